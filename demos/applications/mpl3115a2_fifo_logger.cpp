@@ -0,0 +1,189 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include <libhal-mpl/configuration.hpp>
+#include <libhal-mpl/mpl3115a2.hpp>
+#include <libhal-mpl/sample_log.hpp>
+#include <libhal-util/serial.hpp>
+#include <libhal-util/steady_clock.hpp>
+
+#include "../hardware_map.hpp"
+
+namespace {
+/// Fixed capacity queue of samples waiting to be streamed
+template<std::size_t Capacity>
+class sample_ring
+{
+public:
+  bool push(const hal::mpl::sample_record& p_record)
+  {
+    if (m_count == Capacity) {
+      return false;
+    }
+    m_records[(m_head + m_count) % Capacity] = p_record;
+    m_count++;
+    return true;
+  }
+
+  bool pop(hal::mpl::sample_record& p_record)
+  {
+    if (m_count == 0) {
+      return false;
+    }
+    p_record = m_records[m_head];
+    m_head = (m_head + 1) % Capacity;
+    m_count--;
+    return true;
+  }
+
+private:
+  std::array<hal::mpl::sample_record, Capacity> m_records{};
+  std::size_t m_head = 0;
+  std::size_t m_count = 0;
+};
+
+std::uint32_t to_milliseconds(hal::steady_clock& p_clock, std::uint64_t p_ticks)
+{
+  auto frequency = p_clock.frequency().operating_frequency;
+  return static_cast<std::uint32_t>(static_cast<float>(p_ticks) * 1000.0f /
+                                    frequency);
+}
+}  // namespace
+
+/**
+ * Reference for acquiring at the highest rate the device supports without the
+ * MCU triggering conversions.
+ *
+ * In active mode the device converts once per auto-acquisition time step, and
+ * the shortest step is 1 second. OS128 converts in 512ms so the lowest noise
+ * oversampling ratio costs nothing at that rate. Samples collect in the FIFO
+ * and INT1 fires at the watermark, so the MCU only touches the bus once every
+ * 16 samples, draining the FIFO in a single burst.
+ *
+ * Every sample is written to `stream` as a binary `hal::mpl::sample_record`,
+ * so a capture of the stream is a log file that `tools/log_pipeline` reads
+ * directly. Throughput statistics are printed on `console`.
+ */
+hal::status application(hardware_map& p_map)
+{
+  using namespace std::chrono_literals;
+  using namespace hal::literals;
+  using mpl3115a2 = hal::mpl::mpl3115a2;
+
+  auto& clock = *p_map.clock;
+  auto& console = *p_map.console;
+  auto& stream = *p_map.stream;
+  auto& i2c = *p_map.i2c;
+  auto& int1 = *p_map.int1;
+
+  constexpr std::uint8_t watermark = 16;
+  constexpr auto config = hal::mpl::make_configuration<{
+    .mode = mpl3115a2::mode::barometer,
+    .oversampling = hal::mpl::oversampling_ratio::os128,
+    .acquire = hal::mpl::acquisition::fifo,
+    .fifo = hal::mpl::fifo_mode::circular,
+    .fifo_watermark = watermark,
+    .interrupts = {
+      .enabled = mpl3115a2::interrupt::fifo,
+      .route_to_int1 = mpl3115a2::interrupt::fifo,
+      .int1 = { .active_high = false, .open_drain = false },
+    },
+  }>();
+  constexpr auto sample_period_ms =
+    static_cast<std::uint32_t>(config.sample_period.count());
+  // Drain even if an edge was missed, before the FIFO can overflow
+  constexpr auto max_drain_interval_ms =
+    sample_period_ms * (mpl3115a2::fifo_capacity - watermark);
+  constexpr auto report_interval_ms = 10'000U;
+
+  hal::print(console, "\n\nMPL3115A2 FIFO Logger Starting...\n");
+  auto device = HAL_CHECK(mpl3115a2::create(i2c, config));
+
+  std::atomic<bool> fifo_ready = false;
+  HAL_CHECK(int1.configure({
+    .resistor = hal::pin_resistor::pull_up,
+    .trigger = hal::interrupt_pin::trigger_edge::falling,
+  }));
+  int1.on_trigger([&fifo_ready](bool) { fifo_ready = true; });
+
+  std::array<mpl3115a2::raw_sample_t, mpl3115a2::fifo_capacity> fifo{};
+  sample_ring<128> ring;
+
+  std::uint32_t samples = 0;
+  std::uint32_t overflows = 0;
+  std::uint32_t ring_drops = 0;
+  std::uint64_t bus_ticks = 0;
+  auto start = clock.uptime().ticks;
+  auto last_drain = start;
+  auto last_report = start;
+
+  while (true) {
+    auto now = clock.uptime().ticks;
+
+    if (fifo_ready.exchange(false) ||
+        to_milliseconds(clock, now - last_drain) >= max_drain_interval_ms) {
+      auto read = HAL_CHECK(device.read_fifo(fifo));
+      auto drained = clock.uptime().ticks;
+      bus_ticks += drained - now;
+      last_drain = drained;
+      overflows += read.overflow ? 1 : 0;
+
+      // The newest sample was converted at most one period ago, space the
+      // older samples one period apart from it.
+      auto newest_ms = to_milliseconds(clock, drained - start);
+      auto count = static_cast<std::uint32_t>(read.samples.size());
+      for (std::uint32_t i = 0; i < count; i++) {
+        auto age_ms = (count - 1 - i) * sample_period_ms;
+        hal::mpl::sample_record record{
+          .timestamp = newest_ms - age_ms,
+          .pressure = read.samples[i].pressure,
+          .temperature = read.samples[i].temperature,
+        };
+        if (!ring.push(record)) {
+          ring_drops++;
+        }
+      }
+      samples += count;
+    }
+
+    hal::mpl::sample_record record{};
+    while (ring.pop(record)) {
+      auto bytes = hal::mpl::encode(record);
+      HAL_CHECK(stream.write(bytes));
+    }
+
+    if (to_milliseconds(clock, now - last_report) >= report_interval_ms) {
+      last_report = now;
+      auto elapsed_ms = to_milliseconds(clock, now - start);
+      auto elapsed_s = static_cast<float>(elapsed_ms) / 1000.0f;
+      auto bus_ms = to_milliseconds(clock, bus_ticks);
+
+      hal::print<96>(console,
+                     "samples=%lu rate=%.3f S/s bus=%.4f%% overflows=%lu "
+                     "drops=%lu\n",
+                     static_cast<unsigned long>(samples),
+                     static_cast<float>(samples) / elapsed_s,
+                     100.0f * static_cast<float>(bus_ms) /
+                       static_cast<float>(elapsed_ms),
+                     static_cast<unsigned long>(overflows),
+                     static_cast<unsigned long>(ring_drops));
+    }
+  }
+
+  return hal::success();
+}
@@ -28,7 +28,7 @@ class demos(ConanFile):
     def requirements(self):
         if str(self.options.platform).startswith("lpc40"):
             self.requires("libhal-lpc40/[^2.1.5]")
-        self.requires("libhal-mpl/0.0.1")
+        self.requires("libhal-mpl/0.0.2")
 
     def layout(self):
         platform_directory = "build/" + str(self.options.platform)
@@ -16,13 +16,18 @@
 
 #include <libhal/functional.hpp>
 #include <libhal/i2c.hpp>
+#include <libhal/interrupt_pin.hpp>
 #include <libhal/serial.hpp>
 #include <libhal/steady_clock.hpp>
 
 struct hardware_map
 {
   hal::serial* console;
+  /// High throughput serial port for binary sample streams
+  hal::serial* stream;
   hal::i2c* i2c;
+  /// Wired to the MPL3115A2 INT1 pin
+  hal::interrupt_pin* int1;
   hal::steady_clock* clock;
   hal::callback<void()> reset;
 };
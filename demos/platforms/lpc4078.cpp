@@ -18,6 +18,7 @@
 #include <libhal-lpc40/clock.hpp>
 #include <libhal-lpc40/constants.hpp>
 #include <libhal-lpc40/i2c.hpp>
+#include <libhal-lpc40/interrupt_pin.hpp>
 #include <libhal-lpc40/uart.hpp>
 #include <libhal-util/as_bytes.hpp>
 
@@ -43,15 +44,29 @@ hal::result<hardware_map> initialize_platform()
                                                         .baud_rate = 115200.0f,
                                                       }));
 
+  static std::array<hal::byte, 64> uart1_buffer{};
+
+  // Get and initialize UART1 for binary sample streams
+  static auto uart1 = HAL_CHECK((hal::lpc40::uart::get(1,
+                                                       uart1_buffer,
+                                                       hal::serial::settings{
+                                                         .baud_rate = 921600.0f,
+                                                       })));
+
   // Get and initialize I2C
   static auto i2c2 = HAL_CHECK((hal::lpc40::i2c::get(2,
                                                      hal::i2c::settings{
                                                        .clock_rate = 100.0_kHz,
                                                      })));
 
+  // Get and initialize P0.4 for the MPL3115A2 INT1 pin
+  static auto int1 = HAL_CHECK(hal::lpc40::interrupt_pin::get(0, 4));
+
   return hardware_map{
     .console = &uart0,
+    .stream = &uart1,
     .i2c = &i2c2,
+    .int1 = &int1,
     .clock = &counter,
     .reset = []() { hal::cortex_m::reset(); },
   };
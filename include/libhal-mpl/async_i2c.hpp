@@ -0,0 +1,97 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <span>
+#include <utility>
+
+#include <libhal/error.hpp>
+#include <libhal/functional.hpp>
+#include <libhal/i2c.hpp>
+#include <libhal/units.hpp>
+
+namespace hal::mpl {
+/**
+ * @brief I2C bus that performs transactions in the background, e.g. with DMA,
+ * and reports completion with a callback
+ *
+ * Implement this for buses whose transfers can run without the CPU, then pass
+ * it to the driver's asynchronous APIs. `sync_i2c_adapter` provides the
+ * interface on top of any `hal::i2c` by completing each transaction before
+ * returning.
+ */
+class async_i2c
+{
+public:
+  /**
+   * @brief Called once a transaction finishes, possibly from an interrupt
+   * service routine
+   */
+  using completion_handler = void(hal::status p_status);
+
+  /**
+   * @brief Start a transaction
+   *
+   * `p_data_out` and `p_data_in` must remain valid until `p_on_complete` is
+   * called.
+   *
+   * @param p_address - 7-bit device address
+   * @param p_data_out - bytes to write, may be empty
+   * @param p_data_in - buffer to read into after the write, may be empty
+   * @param p_on_complete - called with the outcome of the transaction
+   * @return hal::status - failure to start the transaction, in which case
+   * `p_on_complete` is not called.
+   */
+  hal::status transaction(hal::byte p_address,
+                          std::span<const hal::byte> p_data_out,
+                          std::span<hal::byte> p_data_in,
+                          hal::callback<completion_handler> p_on_complete)
+  {
+    return driver_transaction(
+      p_address, p_data_out, p_data_in, std::move(p_on_complete));
+  }
+
+  virtual ~async_i2c() = default;
+
+private:
+  virtual hal::status driver_transaction(
+    hal::byte p_address,
+    std::span<const hal::byte> p_data_out,
+    std::span<hal::byte> p_data_in,
+    hal::callback<completion_handler> p_on_complete) = 0;
+};
+
+/**
+ * @brief Default `async_i2c` that performs each transaction on a synchronous
+ * `hal::i2c` and calls the completion handler before returning
+ */
+class sync_i2c_adapter : public async_i2c
+{
+public:
+  /**
+   * @param p_i2c - bus to perform transactions on
+   */
+  explicit sync_i2c_adapter(hal::i2c& p_i2c);
+
+private:
+  hal::status driver_transaction(
+    hal::byte p_address,
+    std::span<const hal::byte> p_data_out,
+    std::span<hal::byte> p_data_in,
+    hal::callback<completion_handler> p_on_complete) override;
+
+  hal::i2c* m_i2c;
+};
+}  // namespace hal::mpl
@@ -0,0 +1,229 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+#include <libhal/functional.hpp>
+#include <libhal/i2c.hpp>
+#include <libhal/steady_clock.hpp>
+#include <libhal/units.hpp>
+
+#include "async_i2c.hpp"
+
+namespace hal::mpl {
+/**
+ * @brief Shares one I2C bus between devices by running their transactions
+ * earliest deadline first
+ *
+ * Every transaction becomes a job tagged with an absolute deadline, the time
+ * it was submitted plus the relative deadline of the channel it came through.
+ * Give latency critical devices, e.g. an IMU, a short relative deadline and the
+ * barometer one close to its conversion time. The barometer's status polls
+ * and data reads then only take the bus when nothing more urgent is waiting.
+ *
+ * Scheduling is cooperative and non-preemptive: a transaction runs to
+ * completion once started, so an urgent job waits at most for the longest
+ * transaction already on the bus. Keep barometer transactions short to bound
+ * this, e.g. avoid draining a full FIFO in one burst next to a tight deadline.
+ *
+ * `run()` dispatches jobs and calls their completion handlers, so handlers
+ * never run from an interrupt even when the underlying bus completes from
+ * one. A job that completes after its deadline is counted as missed on the
+ * scheduler and on its channel.
+ *
+ * Submitting and `run()` must happen from the same thread of execution.
+ */
+class bus_scheduler
+{
+public:
+  /// Jobs that can wait for the bus at the same time
+  static constexpr std::size_t capacity = 8;
+
+  struct statistics_t
+  {
+    /// Jobs whose completion handler has been called
+    std::uint32_t completed = 0;
+    /// Completed jobs that finished after their deadline
+    std::uint32_t missed = 0;
+    /// Largest time past the deadline of a missed job, in clock ticks
+    std::uint64_t max_lateness = 0;
+  };
+
+  /**
+   * @brief Submission point for one device, tagging its transactions with a
+   * relative deadline
+   */
+  class client
+  {
+  public:
+    /**
+     * @return std::uint32_t - completed jobs of this client that finished
+     * after their deadline
+     */
+    [[nodiscard]] std::uint32_t missed() const;
+
+    /**
+     * @return std::uint32_t - completed jobs of this client
+     */
+    [[nodiscard]] std::uint32_t completed() const;
+
+    /**
+     * @param p_deadline - time from submission by which each transaction
+     * should complete
+     */
+    void set_deadline(hal::time_duration p_deadline);
+
+  protected:
+    client(bus_scheduler& p_scheduler, hal::time_duration p_deadline);
+
+    bus_scheduler* m_scheduler;
+
+  private:
+    friend class bus_scheduler;
+
+    std::uint64_t m_deadline_ticks = 0;
+    std::uint32_t m_missed = 0;
+    std::uint32_t m_completed = 0;
+  };
+
+  /**
+   * @brief Asynchronous bus for one device, e.g. for `fifo_drain`
+   *
+   * The completion handler is called from `bus_scheduler::run()`.
+   */
+  class channel
+    : public async_i2c
+    , public client
+  {
+  public:
+    /**
+     * @param p_scheduler - scheduler of the shared bus
+     * @param p_deadline - time from submission by which each transaction
+     * should complete
+     */
+    channel(bus_scheduler& p_scheduler, hal::time_duration p_deadline);
+
+  private:
+    hal::status driver_transaction(
+      hal::byte p_address,
+      std::span<const hal::byte> p_data_out,
+      std::span<hal::byte> p_data_in,
+      hal::callback<completion_handler> p_on_complete) override;
+  };
+
+  /**
+   * @brief Synchronous bus for drivers that take a `hal::i2c`, e.g.
+   * `mpl3115a2`
+   *
+   * A transaction calls `bus_scheduler::run()` until its own job completes,
+   * so more urgent jobs of other devices, and their completion handlers, run
+   * first. The timeout only applies while the job waits for the bus; once
+   * started, the transaction is bounded by the underlying bus.
+   */
+  class blocking_channel
+    : public hal::i2c
+    , public client
+  {
+  public:
+    /**
+     * @param p_scheduler - scheduler of the shared bus
+     * @param p_deadline - time from submission by which each transaction
+     * should complete
+     */
+    blocking_channel(bus_scheduler& p_scheduler, hal::time_duration p_deadline);
+
+  private:
+    hal::status driver_configure(const settings& p_settings) override;
+    hal::result<transaction_t> driver_transaction(
+      hal::byte p_address,
+      std::span<const hal::byte> p_data_out,
+      std::span<hal::byte> p_data_in,
+      hal::function_ref<hal::timeout_function> p_timeout) override;
+
+    std::optional<hal::status> m_outcome;
+  };
+
+  /**
+   * @param p_bus - shared bus, may complete transactions from an interrupt
+   * @param p_clock - clock for deadlines
+   */
+  bus_scheduler(async_i2c& p_bus, hal::steady_clock& p_clock);
+
+  bus_scheduler(const bus_scheduler&) = delete;
+  bus_scheduler& operator=(const bus_scheduler&) = delete;
+
+  /**
+   * @brief Start the pending job with the earliest deadline whenever the bus
+   * is free and complete the jobs the bus has finished
+   *
+   * Call from the main loop or a cooperative task as often as the tightest
+   * deadline requires, and whenever the bus signals completion.
+   *
+   * @return std::size_t - completion handlers called
+   */
+  std::size_t run();
+
+  /**
+   * @return true - no job is pending or on the bus
+   */
+  [[nodiscard]] bool idle() const;
+
+  /**
+   * @return statistics_t - completed and missed jobs of every client
+   */
+  [[nodiscard]] statistics_t statistics() const;
+
+private:
+  struct job_t
+  {
+    hal::byte address;
+    std::span<const hal::byte> data_out;
+    std::span<hal::byte> data_in;
+    std::uint64_t deadline;
+    /// Submission order, breaks deadline ties first come first served
+    std::uint64_t sequence;
+    client* owner;
+    hal::callback<async_i2c::completion_handler> on_complete;
+  };
+
+  hal::status submit(
+    client& p_client,
+    hal::byte p_address,
+    std::span<const hal::byte> p_data_out,
+    std::span<hal::byte> p_data_in,
+    hal::callback<async_i2c::completion_handler> p_on_complete);
+  bool cancel(client& p_client);
+  void finish();
+  void dispatch();
+  std::uint64_t to_ticks(hal::time_duration p_duration);
+
+  async_i2c* m_bus;
+  hal::steady_clock* m_clock;
+  std::array<std::optional<job_t>, capacity> m_pending{};
+  std::optional<job_t> m_active;
+  /// Outcome of the active job, written by the bus before `m_done`
+  hal::status m_outcome{};
+  std::atomic<bool> m_done = false;
+  std::uint64_t m_sequence = 0;
+  statistics_t m_statistics{};
+};
+}  // namespace hal::mpl
@@ -0,0 +1,291 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+#include "mpl3115a2.hpp"
+
+namespace hal::mpl {
+/// Oversampling ratio, the value is the OS[2:0] field of CTRL_REG1
+enum class oversampling_ratio : hal::byte
+{
+  os1 = 0,
+  os2 = 1,
+  os4 = 2,
+  os8 = 3,
+  os16 = 4,
+  os32 = 5,
+  os64 = 6,
+  os128 = 7,
+};
+
+/**
+ * @brief Maximum time a single pressure/altitude and temperature conversion
+ * takes at an oversampling ratio
+ *
+ * @param p_ratio - oversampling ratio
+ * @return constexpr std::chrono::milliseconds - datasheet "minimum time
+ * between data samples"
+ */
+constexpr std::chrono::milliseconds conversion_time(oversampling_ratio p_ratio)
+{
+  constexpr std::array<std::uint16_t, 8> times_ms{
+    6, 10, 18, 34, 66, 130, 258, 512,
+  };
+  return std::chrono::milliseconds(times_ms[static_cast<hal::byte>(p_ratio)]);
+}
+
+/// How the device acquires samples
+enum class acquisition
+{
+  /// Standby between conversions triggered by the driver
+  one_shot,
+  /// Active mode, a conversion every auto-acquisition time step
+  continuous,
+  /// Active mode with samples collected in the 32 sample FIFO
+  fifo,
+};
+
+/// Behavior of the FIFO when full, the value is F_MODE of F_SETUP
+enum class fifo_mode : hal::byte
+{
+  /// Keep the most recent samples, discarding the oldest
+  circular = 1,
+  /// Stop accepting samples until the FIFO is read
+  stop = 2,
+};
+
+/**
+ * @brief Requested device configuration
+ *
+ * Pass to `make_configuration()` to validate it and compute its register
+ * image at compile time.
+ */
+struct configuration_settings
+{
+  mpl3115a2::mode mode = mpl3115a2::mode::altimeter;
+  oversampling_ratio oversampling = oversampling_ratio::os128;
+  acquisition acquire = acquisition::one_shot;
+  /// Time between samples in continuous and fifo acquisition. Must be a power
+  /// of two seconds from 1s to 32768s, 0 selects 1s. Must be 0 for one_shot.
+  std::uint32_t sample_period_ms = 0;
+  fifo_mode fifo = fifo_mode::circular;
+  /// FIFO sample count that raises the FIFO interrupt, 0 disables it
+  std::uint8_t fifo_watermark = 0;
+  mpl3115a2::interrupt_settings interrupts{};
+};
+
+/**
+ * @brief Complete, validated register image of a device configuration along
+ * with its derived timing
+ *
+ * Create with `make_configuration()` and apply with
+ * `mpl3115a2::configure()` or `mpl3115a2::create()`.
+ */
+struct configuration
+{
+  hal::byte ctrl_reg1;
+  hal::byte ctrl_reg2;
+  hal::byte ctrl_reg3;
+  hal::byte ctrl_reg4;
+  hal::byte ctrl_reg5;
+  hal::byte pt_data_cfg;
+  hal::byte f_setup;
+  /// Maximum duration of one conversion
+  std::chrono::milliseconds conversion_time;
+  /// Time between samples in active mode, 0 for one-shot acquisition
+  std::chrono::milliseconds sample_period;
+};
+
+namespace detail {
+constexpr std::uint32_t max_time_step = 15;
+
+constexpr bool is_power_of_two_seconds(std::uint32_t p_period_ms)
+{
+  if (p_period_ms % 1000 != 0) {
+    return false;
+  }
+  auto seconds = p_period_ms / 1000;
+  return seconds != 0 && (seconds & (seconds - 1)) == 0 &&
+         seconds <= (1U << max_time_step);
+}
+
+constexpr hal::byte time_step(std::uint32_t p_period_ms)
+{
+  hal::byte step = 0;
+  for (auto seconds = p_period_ms / 1000; seconds > 1; seconds >>= 1) {
+    step++;
+  }
+  return step;
+}
+
+constexpr configuration compile(const configuration_settings& p_settings)
+{
+  bool active = p_settings.acquire != acquisition::one_shot;
+  auto period_ms = p_settings.sample_period_ms;
+  if (active && period_ms == 0) {
+    period_ms = 1000;
+  }
+
+  // CTRL_REG1: ALT | RAW | OS[2:0] | RST | OST | SBYB
+  hal::byte ctrl_reg1 =
+    static_cast<hal::byte>(static_cast<hal::byte>(p_settings.oversampling)
+                           << 3);
+  if (p_settings.mode == mpl3115a2::mode::altimeter) {
+    ctrl_reg1 |= 1 << 7;
+  }
+  if (active) {
+    ctrl_reg1 |= 1 << 0;
+  }
+
+  // CTRL_REG3: - | - | IPOL1 | PP_OD1 | - | - | IPOL2 | PP_OD2
+  const auto& interrupts = p_settings.interrupts;
+  hal::byte ctrl_reg3 = 0;
+  ctrl_reg3 |= interrupts.int1.active_high ? 1 << 5 : 0;
+  ctrl_reg3 |= interrupts.int1.open_drain ? 1 << 4 : 0;
+  ctrl_reg3 |= interrupts.int2.active_high ? 1 << 1 : 0;
+  ctrl_reg3 |= interrupts.int2.open_drain ? 1 << 0 : 0;
+
+  // F_SETUP: F_MODE[1:0] | F_WMRK[5:0]
+  hal::byte f_setup = 0;
+  if (p_settings.acquire == acquisition::fifo) {
+    f_setup = static_cast<hal::byte>(
+      static_cast<hal::byte>(p_settings.fifo) << 6 | p_settings.fifo_watermark);
+  }
+
+  return configuration{
+    .ctrl_reg1 = ctrl_reg1,
+    .ctrl_reg2 = active ? time_step(period_ms) : hal::byte(0),
+    .ctrl_reg3 = ctrl_reg3,
+    .ctrl_reg4 = interrupts.enabled,
+    .ctrl_reg5 = interrupts.route_to_int1,
+    // DREM | PDEFE | TDEFE
+    .pt_data_cfg = 0x07,
+    .f_setup = f_setup,
+    .conversion_time = hal::mpl::conversion_time(p_settings.oversampling),
+    .sample_period = std::chrono::milliseconds(active ? period_ms : 0),
+  };
+}
+}  // namespace detail
+
+/**
+ * @brief Validate a configuration and compute its register image at compile
+ * time
+ *
+ * Invalid combinations fail to compile with a diagnostic naming the problem:
+ *
+ *     constexpr auto fast = hal::mpl::make_configuration<{
+ *       .mode = hal::mpl::mpl3115a2::mode::barometer,
+ *       .oversampling = hal::mpl::oversampling_ratio::os16,
+ *       .acquire = hal::mpl::acquisition::fifo,
+ *     }>();
+ *
+ * @tparam Settings - requested configuration
+ * @return consteval configuration - validated register image
+ */
+template<configuration_settings Settings>
+consteval configuration make_configuration()
+{
+  constexpr bool active = Settings.acquire != acquisition::one_shot;
+  constexpr auto period_ms =
+    Settings.sample_period_ms == 0 && active ? 1000 : Settings.sample_period_ms;
+  constexpr auto fifo = mpl3115a2::interrupt::fifo;
+
+  static_assert(active || Settings.sample_period_ms == 0,
+                "sample_period_ms only applies to continuous and fifo "
+                "acquisition, one-shot conversions are triggered by reads");
+  // The slowest oversampling ratio converts in 512 ms, so every allowed time
+  // step fits a conversion
+  static_assert(!active || period_ms >= 1000,
+                "The auto-acquisition time step cannot be shorter than 1s, "
+                "use one-shot acquisition for faster sampling");
+  static_assert(!active || detail::is_power_of_two_seconds(period_ms),
+                "sample_period_ms must be a power of two seconds from 1s to "
+                "32768s, other periods would silently be rounded");
+  static_assert(Settings.acquire == acquisition::fifo ||
+                  Settings.fifo_watermark == 0,
+                "fifo_watermark requires fifo acquisition");
+  static_assert(Settings.fifo_watermark <= mpl3115a2::fifo_capacity,
+                "fifo_watermark cannot exceed the 32 sample FIFO");
+  static_assert(Settings.acquire == acquisition::fifo ||
+                  (Settings.interrupts.enabled & fifo) == 0,
+                "The FIFO interrupt requires fifo acquisition");
+  static_assert((Settings.interrupts.route_to_int1 &
+                 ~Settings.interrupts.enabled) == 0,
+                "route_to_int1 routes an interrupt source that is not enabled");
+
+  return detail::compile(Settings);
+}
+
+/**
+ * @brief Configuration that `mpl3115a2::apply()` switches to with a single
+ * burst write of the control register block
+ *
+ * Create named profiles once and switch between them as often as needed:
+ *
+ *     constexpr auto fast = hal::mpl::make_profile<{
+ *       .mode = hal::mpl::mpl3115a2::mode::barometer,
+ *       .oversampling = hal::mpl::oversampling_ratio::os2,
+ *       .acquire = hal::mpl::acquisition::continuous,
+ *     }>();
+ *     constexpr auto precise = hal::mpl::make_profile<{
+ *       .mode = hal::mpl::mpl3115a2::mode::barometer,
+ *     }>();
+ */
+struct profile
+{
+  /// CTRL_REG1 to CTRL_REG5 as burst written, CTRL_REG1 in standby
+  std::array<hal::byte, 5> control_block;
+  /// Complete register image and timing of the profile
+  configuration config;
+};
+
+/**
+ * @brief Validate a configuration and precompute its profile at compile time
+ *
+ * @tparam Settings - requested configuration, any that `make_configuration()`
+ * accepts except fifo acquisition
+ * @return consteval profile - profile for `mpl3115a2::apply()`
+ */
+template<configuration_settings Settings>
+consteval profile make_profile()
+{
+  static_assert(Settings.acquire != acquisition::fifo,
+                "Profiles hold the control register block only, F_SETUP is "
+                "outside of it. Use make_configuration() and configure() for "
+                "fifo acquisition");
+
+  constexpr auto config = make_configuration<Settings>();
+  // Clear SBYB so the block is always written in standby
+  constexpr hal::byte standby = ~hal::byte(1 << 0);
+  return profile{
+    .control_block = {
+      static_cast<hal::byte>(config.ctrl_reg1 & standby),
+      config.ctrl_reg2,
+      config.ctrl_reg3,
+      config.ctrl_reg4,
+      config.ctrl_reg5,
+    },
+    .config = config,
+  };
+}
+
+/// Configuration applied by `mpl3115a2::create(hal::i2c&)`
+inline constexpr configuration default_configuration =
+  make_configuration<configuration_settings{}>();
+}  // namespace hal::mpl
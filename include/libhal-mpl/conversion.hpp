@@ -0,0 +1,91 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+
+#include <libhal/units.hpp>
+
+namespace hal::mpl {
+/**
+ * @brief Assemble the 24-bit OUT_P register word from its three bytes
+ *
+ * The word holds the 20-bit pressure or altitude sample left justified, with
+ * the lowest 4 bits always reading zero.
+ *
+ * @param p_msb - value of out_p_msb_r
+ * @param p_csb - value of out_p_csb_r
+ * @param p_lsb - value of out_p_lsb_r
+ * @return constexpr std::uint32_t - raw OUT_P word
+ */
+constexpr std::uint32_t to_raw_pressure(hal::byte p_msb,
+                                        hal::byte p_csb,
+                                        hal::byte p_lsb)
+{
+  return std::uint32_t(p_msb) << 16 | std::uint32_t(p_csb) << 8 |
+         std::uint32_t(p_lsb);
+}
+
+/**
+ * @brief Assemble the 16-bit OUT_T register word from its two bytes
+ *
+ * @param p_msb - value of out_t_msb_r
+ * @param p_lsb - value of out_t_lsb_r
+ * @return constexpr std::int16_t - raw OUT_T word in two's complement
+ */
+constexpr std::int16_t to_raw_temperature(hal::byte p_msb, hal::byte p_lsb)
+{
+  return static_cast<std::int16_t>(std::uint16_t(p_msb) << 8 | p_lsb);
+}
+
+/**
+ * @brief Convert a raw OUT_P word captured in barometer mode to pascals
+ *
+ * @param p_raw - raw OUT_P word, unsigned Q18.2 shifted left by 4
+ * @return constexpr float - pressure in pascals (Pa)
+ */
+constexpr float to_pascals(std::uint32_t p_raw)
+{
+  // Note: 64 -> Pa, 6400 -> kPa
+  constexpr float pressure_conversion_factor = 64.0f;
+  return static_cast<float>(p_raw) / pressure_conversion_factor;
+}
+
+/**
+ * @brief Convert a raw OUT_P word captured in altimeter mode to meters
+ *
+ * @param p_raw - raw OUT_P word, signed Q16.4 shifted left by 4
+ * @return constexpr hal::meters - altitude in meters
+ */
+constexpr hal::meters to_meters(std::uint32_t p_raw)
+{
+  constexpr float altitude_conversion_factor = 65536.0f;
+  // Move the sign bit of the 24-bit word into bit 31
+  auto altitude_reading = static_cast<std::int32_t>(p_raw << 8);
+  return static_cast<float>(altitude_reading) / altitude_conversion_factor;
+}
+
+/**
+ * @brief Convert a raw OUT_T word to degrees celsius
+ *
+ * @param p_raw - raw OUT_T word, signed Q8.4 shifted left by 4
+ * @return constexpr hal::celsius - temperature in celsius
+ */
+constexpr hal::celsius to_celsius(std::int16_t p_raw)
+{
+  constexpr float temp_conversion_factor = 256.0f;
+  return static_cast<float>(p_raw) / temp_conversion_factor;
+}
+}  // namespace hal::mpl
@@ -0,0 +1,103 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+
+#include <libhal/steady_clock.hpp>
+
+#include "mpl3115a2.hpp"
+
+namespace hal::mpl {
+/**
+ * @brief Pressure difference between two mpl3115a2 devices measured as a
+ * tightly paired sample
+ *
+ * Both conversions are triggered back to back before either is collected, so
+ * the two samples are taken within one trigger transaction of each other
+ * rather than a full conversion time apart. A per-pair offset, measured with
+ * both ports at the same pressure, removes the static mismatch between the two
+ * devices.
+ */
+class differential_pressure
+{
+public:
+  struct reading_t
+  {
+    /// Pressure at the high port minus the low port, minus the pair offset,
+    /// in pascals (Pa)
+    float difference;
+    /// Pressure at the high port in pascals (Pa)
+    float high;
+    /// Pressure at the low port in pascals (Pa)
+    float low;
+    /// Uptime ticks midway between the OST writes that started the two
+    /// conversions
+    std::uint64_t timestamp;
+    /// Uptime ticks between the OST writes that started the two conversions
+    std::uint64_t skew;
+  };
+
+  /**
+   * @brief Construct a new differential pressure object
+   *
+   * The devices must be on separate I2C buses, as every mpl3115a2 uses the
+   * same address.
+   *
+   * @param p_high - device on the high pressure port
+   * @param p_low - device on the low pressure port
+   * @param p_clock - clock used to timestamp readings
+   */
+  differential_pressure(mpl3115a2& p_high,
+                        mpl3115a2& p_low,
+                        hal::steady_clock& p_clock);
+
+  /**
+   * @brief Measure both ports as a pair
+   *
+   * @return hal::result<reading_t> - paired reading
+   */
+  [[nodiscard]] hal::result<reading_t> read();
+
+  /**
+   * @brief Measure and store the pair offset
+   *
+   * Both ports must be at the same pressure, e.g. open to the same volume,
+   * while calibrating.
+   *
+   * @param p_samples - number of paired readings to average
+   * @return hal::result<float> - the new offset in pascals (Pa)
+   */
+  [[nodiscard]] hal::result<float> calibrate(std::uint16_t p_samples);
+
+  /**
+   * @brief Set the pair offset, e.g. from a stored calibration
+   *
+   * @param p_offset - high minus low reading at equal pressure in pascals
+   */
+  void set_offset(float p_offset);
+
+  /**
+   * @return float - the pair offset in pascals (Pa)
+   */
+  [[nodiscard]] float offset() const;
+
+private:
+  mpl3115a2* m_high;
+  mpl3115a2* m_low;
+  hal::steady_clock* m_clock;
+  float m_offset = 0.0f;
+};
+}  // namespace hal::mpl
@@ -0,0 +1,285 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+#include "mpl3115a2.hpp"
+
+namespace hal::mpl {
+/**
+ * @brief Learns how the pressure output drifts with die temperature and
+ * removes that drift from each sample
+ *
+ * While the platform is stationary, `learn()` fits
+ * `pressure = offset + coefficient * (temperature - reference)` to the raw
+ * samples with recursive least squares. The offset absorbs the true pressure,
+ * and the forgetting factor lets it follow slow weather changes. The
+ * coefficient is the temperature drift. `compensate()` subtracts the drift
+ * from a raw pressure word in fixed point, using the temperature read in the
+ * same burst, so correcting a sample needs no floating point and no extra
+ * conversions.
+ *
+ * Learning needs the temperature to vary. Samples at a constant temperature
+ * cannot separate the drift from the pressure: the offset follows them, and
+ * the coefficient only moves as far as the samples disagree with it at that
+ * temperature. The uncertainty of the coefficient grows meanwhile, up to
+ * `max_covariance`, so the first temperature change afterwards is learned
+ * quickly.
+ */
+class drift_compensator
+{
+public:
+  /// Fit state, e.g. to keep learning across a restart
+  struct state_t
+  {
+    float offset;
+    float coefficient;
+    float p00;
+    float p01;
+    float p11;
+    std::int64_t pressure_base;
+    std::uint32_t samples;
+  };
+
+  struct settings
+  {
+    /// Weight of past samples in the fit, closer to 1.0 remembers longer
+    float forgetting = 0.999f;
+    /// Initial variance of the estimates, their sum stays below twice this.
+    /// Larger values learn faster from the first samples.
+    float max_covariance = 1.0e4f;
+  };
+
+  /**
+   * @brief Construct a new drift compensator
+   *
+   * @param p_reference - raw OUT_T word at which the correction is zero
+   * @param p_settings - fit settings
+   */
+  constexpr drift_compensator(std::int16_t p_reference, settings p_settings)
+    : m_settings(p_settings)
+    , m_reference(p_reference)
+  {
+    reset();
+  }
+
+  /**
+   * @brief Construct a new drift compensator with the default fit settings
+   *
+   * @param p_reference - raw OUT_T word at which the correction is zero
+   */
+  constexpr explicit drift_compensator(std::int16_t p_reference)
+    : drift_compensator(p_reference, settings{})
+  {
+  }
+
+  /**
+   * @brief Update the fit with a sample taken while stationary
+   *
+   * @param p_sample - raw barometer sample
+   */
+  constexpr void learn(const mpl3115a2::raw_sample_t& p_sample)
+  {
+    if (m_samples == 0) {
+      // Pressures are fitted relative to the first one for float precision
+      m_pressure_base = p_sample.pressure;
+    }
+    // Saturate, wrapping to 0 would move the base under a running fit
+    if (m_samples != UINT32_MAX) {
+      m_samples++;
+    }
+
+    float x = celsius_from_reference(p_sample.temperature);
+    float y = pascals_from_base(p_sample.pressure);
+    float lambda = m_settings.forgetting;
+
+    // Gain for the regressor [1, x]
+    float px0 = m_p00 + m_p01 * x;
+    float px1 = m_p01 + m_p11 * x;
+    float denominator = lambda + px0 + x * px1;
+    float k0 = px0 / denominator;
+    float k1 = px1 / denominator;
+
+    float error = y - (m_offset + m_coefficient * x);
+    m_offset += k0 * error;
+    m_coefficient += k1 * error;
+
+    // P = (P - K * (P x)^T) / lambda
+    m_p00 = (m_p00 - k0 * px0) / lambda;
+    m_p01 = (m_p01 - k0 * px1) / lambda;
+    m_p11 = (m_p11 - k1 * px1) / lambda;
+    bound_covariance();
+
+    update_fixed_point();
+  }
+
+  /**
+   * @brief Remove the temperature drift from a raw pressure word
+   *
+   * @param p_sample - raw barometer sample
+   * @return constexpr std::uint32_t - corrected raw OUT_P word, convert it
+   * with `to_pascals()`
+   */
+  constexpr std::uint32_t compensate(
+    const mpl3115a2::raw_sample_t& p_sample) const
+  {
+    auto delta = std::int64_t(p_sample.temperature) - m_reference;
+    auto correction = (m_coefficient_q16 * delta) >> fraction_bits;
+    auto corrected = std::int64_t(p_sample.pressure) - correction;
+    return static_cast<std::uint32_t>(
+      std::clamp<std::int64_t>(corrected, 0, max_pressure_word));
+  }
+
+  /**
+   * @return constexpr float - learned drift in pascals per degree celsius
+   */
+  constexpr float coefficient() const
+  {
+    return m_coefficient;
+  }
+
+  /**
+   * @brief Set the drift, e.g. from a stored calibration, and continue
+   * learning from there
+   *
+   * @param p_coefficient - drift in pascals per degree celsius
+   */
+  constexpr void set_coefficient(float p_coefficient)
+  {
+    m_coefficient = p_coefficient;
+    update_fixed_point();
+  }
+
+  /**
+   * @return constexpr std::uint32_t - samples learned since the last reset,
+   * saturating at UINT32_MAX
+   */
+  constexpr std::uint32_t samples() const
+  {
+    return m_samples;
+  }
+
+  /**
+   * @return constexpr state_t - the complete fit
+   */
+  constexpr state_t state() const
+  {
+    return {
+      .offset = m_offset,
+      .coefficient = m_coefficient,
+      .p00 = m_p00,
+      .p01 = m_p01,
+      .p11 = m_p11,
+      .pressure_base = m_pressure_base,
+      .samples = m_samples,
+    };
+  }
+
+  /**
+   * @brief Continue from a fit returned by `state()`
+   *
+   * @param p_state - fit to continue from
+   */
+  constexpr void restore(const state_t& p_state)
+  {
+    m_offset = p_state.offset;
+    m_coefficient = p_state.coefficient;
+    m_p00 = p_state.p00;
+    m_p01 = p_state.p01;
+    m_p11 = p_state.p11;
+    m_pressure_base = p_state.pressure_base;
+    m_samples = p_state.samples;
+    update_fixed_point();
+  }
+
+  /**
+   * @brief Forget the fit, including the coefficient
+   */
+  constexpr void reset()
+  {
+    m_offset = 0.0f;
+    m_coefficient = 0.0f;
+    m_p00 = m_settings.max_covariance;
+    m_p01 = 0.0f;
+    m_p11 = m_settings.max_covariance;
+    m_samples = 0;
+    update_fixed_point();
+  }
+
+private:
+  static constexpr int fraction_bits = 16;
+  static constexpr std::int64_t max_pressure_word = 0xFFFFFF;
+  /// OUT_P counts per pascal and OUT_T counts per degree celsius
+  static constexpr float pressure_counts = 64.0f;
+  static constexpr float temperature_counts = 256.0f;
+
+  constexpr float celsius_from_reference(std::int16_t p_temperature) const
+  {
+    return static_cast<float>(p_temperature - m_reference) /
+           temperature_counts;
+  }
+
+  constexpr float pascals_from_base(std::uint32_t p_pressure) const
+  {
+    return static_cast<float>(std::int64_t(p_pressure) - m_pressure_base) /
+           pressure_counts;
+  }
+
+  /**
+   * While the temperature does not change, P grows without bound in the
+   * direction the samples do not observe. Scaling the whole matrix keeps it
+   * positive definite, where clamping single terms does not, so a later
+   * temperature step cannot make the gain denominator reach zero.
+   */
+  constexpr void bound_covariance()
+  {
+    float trace = m_p00 + m_p11;
+    float max_trace = 2.0f * m_settings.max_covariance;
+    if (trace > max_trace) {
+      float scale = max_trace / trace;
+      m_p00 *= scale;
+      m_p01 *= scale;
+      m_p11 *= scale;
+    }
+    // Rounding can still push the badly conditioned matrix out of positive
+    // semidefiniteness. p01 * p01 <= p00 * p11 restores it.
+    float variance_product = m_p00 * m_p11;
+    if (m_p01 * m_p01 > variance_product) {
+      m_p01 = variance_product / m_p01;
+    }
+  }
+
+  constexpr void update_fixed_point()
+  {
+    // OUT_P counts per OUT_T count, Q16
+    constexpr float scale =
+      pressure_counts / temperature_counts * float(1 << fraction_bits);
+    m_coefficient_q16 = static_cast<std::int64_t>(m_coefficient * scale);
+  }
+
+  settings m_settings;
+  std::int16_t m_reference;
+  std::int64_t m_pressure_base = 0;
+  float m_offset = 0.0f;
+  float m_coefficient = 0.0f;
+  float m_p00 = 0.0f;
+  float m_p01 = 0.0f;
+  float m_p11 = 0.0f;
+  std::int64_t m_coefficient_q16 = 0;
+  std::uint32_t m_samples = 0;
+};
+}  // namespace hal::mpl
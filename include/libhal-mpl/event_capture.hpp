@@ -0,0 +1,202 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <span>
+
+#include <libhal/interrupt_pin.hpp>
+
+#include "mpl3115a2.hpp"
+
+namespace hal::mpl {
+/**
+ * @brief Records the samples around a pressure event, including the samples
+ * taken before it
+ *
+ * The device keeps the pre-trigger history itself: configure it for
+ * continuous acquisition into a circular FIFO, see `make_configuration()`, and
+ * nothing needs to run on the MCU while waiting for an event. A trigger comes
+ * either from the `interrupt::pressure_threshold` source, set up with
+ * `set_pressure_target()` and `attach()`, or from software via `trigger()`.
+ *
+ * After a trigger, `service()` takes the newest PreTrigger samples from the
+ * FIFO as the history, the last of which is the trigger sample, then collects
+ * the next PostTrigger samples from later calls. Call `service()` soon after
+ * the trigger, as samples converted in between count towards the history, and
+ * at least every 32 sample periods while collecting so the FIFO does not
+ * overflow.
+ *
+ * @tparam PreTrigger - samples kept from before the trigger, the FIFO holds at
+ * most 32
+ * @tparam PostTrigger - samples kept from after the trigger
+ */
+template<std::size_t PreTrigger, std::size_t PostTrigger>
+class event_capture
+{
+public:
+  static_assert(PreTrigger <= mpl3115a2::fifo_capacity,
+                "The pre-trigger history is held by the device FIFO");
+  static_assert(PreTrigger + PostTrigger > 0,
+                "An event capture must keep at least one sample");
+
+  enum class state
+  {
+    /// Waiting for a trigger
+    armed,
+    /// Triggered, post-trigger samples are being collected
+    collecting,
+    /// Every sample has been captured, triggers are ignored until `rearm()`
+    captured,
+  };
+
+  /**
+   * @brief Construct a new event capture
+   *
+   * @param p_device - device configured for continuous acquisition into a
+   * circular FIFO
+   */
+  explicit event_capture(mpl3115a2& p_device)
+    : m_device(&p_device)
+  {
+  }
+
+  /**
+   * @brief Install `trigger()` as the trigger handler of the interrupt pin
+   * wired to the device's threshold interrupt output
+   *
+   * @param p_pin - interrupt pin wired to the device
+   */
+  void attach(hal::interrupt_pin& p_pin)
+  {
+    p_pin.on_trigger([this](bool) { trigger(); });
+  }
+
+  /**
+   * @brief Mark the newest sample as the event. Safe to call from an
+   * interrupt service routine.
+   */
+  void trigger()
+  {
+    m_triggered.store(true, std::memory_order_release);
+  }
+
+  /**
+   * @brief Take the pre-trigger history once triggered and collect the
+   * post-trigger samples available so far. Call from thread context, never
+   * from the interrupt itself, as servicing performs I2C transactions.
+   *
+   * @return hal::result<state> - capture state after servicing
+   */
+  [[nodiscard]] hal::result<state> service()
+  {
+    if (m_state == state::armed) {
+      if (!m_triggered.exchange(false, std::memory_order_acq_rel)) {
+        return m_state;
+      }
+      HAL_CHECK(capture_history());
+    }
+
+    if (m_state == state::collecting) {
+      auto remaining = std::span(m_post).subspan(m_post_count);
+      auto read = HAL_CHECK(m_device->read_fifo(remaining));
+      m_post_count += read.samples.size();
+      m_overflow = m_overflow || read.overflow;
+      if (m_post_count == PostTrigger) {
+        m_state = state::captured;
+      }
+    }
+
+    return m_state;
+  }
+
+  /**
+   * @brief Discard the captured event and wait for the next trigger
+   */
+  void rearm()
+  {
+    m_pre_count = 0;
+    m_post_count = 0;
+    m_overflow = false;
+    m_triggered.store(false, std::memory_order_release);
+    m_state = state::armed;
+  }
+
+  /**
+   * @return state - current capture state
+   */
+  [[nodiscard]] state current_state() const
+  {
+    return m_state;
+  }
+
+  /**
+   * @return std::span<const mpl3115a2::raw_sample_t> - samples up to and
+   * including the trigger sample, oldest first. Fewer than PreTrigger if the
+   * FIFO had not filled yet.
+   */
+  [[nodiscard]] std::span<const mpl3115a2::raw_sample_t> pre_trigger() const
+  {
+    return std::span(m_pre).first(m_pre_count);
+  }
+
+  /**
+   * @return std::span<const mpl3115a2::raw_sample_t> - samples collected after
+   * the trigger so far, oldest first
+   */
+  [[nodiscard]] std::span<const mpl3115a2::raw_sample_t> post_trigger() const
+  {
+    return std::span(m_post).first(m_post_count);
+  }
+
+  /**
+   * @return true - the FIFO overflowed while collecting, so the post-trigger
+   * samples are not contiguous with the trigger sample
+   */
+  [[nodiscard]] bool overflow() const
+  {
+    return m_overflow;
+  }
+
+private:
+  hal::status capture_history()
+  {
+    // Acknowledge the threshold source so the device can signal the next
+    // event once rearmed.
+    HAL_CHECK(m_device->read_interrupt_source());
+
+    std::array<mpl3115a2::raw_sample_t, mpl3115a2::fifo_capacity> fifo{};
+    auto read = HAL_CHECK(m_device->read_fifo(fifo));
+    auto history = read.samples.last(std::min(PreTrigger, read.samples.size()));
+    std::ranges::copy(history, m_pre.begin());
+    m_pre_count = history.size();
+
+    m_state = PostTrigger == 0 ? state::captured : state::collecting;
+    return hal::success();
+  }
+
+  mpl3115a2* m_device;
+  std::array<mpl3115a2::raw_sample_t, PreTrigger> m_pre{};
+  std::array<mpl3115a2::raw_sample_t, PostTrigger> m_post{};
+  std::size_t m_pre_count = 0;
+  std::size_t m_post_count = 0;
+  bool m_overflow = false;
+  state m_state = state::armed;
+  std::atomic<bool> m_triggered = false;
+};
+}  // namespace hal::mpl
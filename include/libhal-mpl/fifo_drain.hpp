@@ -0,0 +1,91 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <span>
+
+#include <libhal/functional.hpp>
+
+#include "async_i2c.hpp"
+#include "mpl3115a2.hpp"
+
+namespace hal::mpl {
+/**
+ * @brief Drains the FIFO of an mpl3115a2 over an asynchronous bus
+ *
+ * Works like `mpl3115a2::read_fifo()`, but the F_STATUS read and the burst
+ * read of up to 160 bytes of F_DATA are queued on an `async_i2c`, so a DMA
+ * capable bus moves the data while the CPU does other work or sleeps. Each
+ * step is started from the completion of the previous one.
+ *
+ * The object holds the transfer buffers, so it must not be moved or destroyed
+ * while `busy()`.
+ */
+class fifo_drain
+{
+public:
+  /**
+   * @brief Called with the samples read and the overflow state, or the bus
+   * error, from the context the bus completes transactions in
+   */
+  using completion_handler =
+    void(hal::result<mpl3115a2::fifo_read_t> p_read);
+
+  /**
+   * @param p_device - device configured for fifo acquisition
+   * @param p_bus - bus the device is connected to
+   */
+  fifo_drain(mpl3115a2& p_device, async_i2c& p_bus);
+
+  /**
+   * @brief Start draining the FIFO
+   *
+   * @param p_samples - destination for the samples, must remain valid until
+   * `p_on_complete` is called
+   * @param p_on_complete - called once the drain finishes or fails
+   * @return hal::status - std::errc::operation_not_permitted if the FIFO is
+   * not enabled, std::errc::device_or_resource_busy if a drain is already in
+   * progress, or the bus failed to start the first transaction. In these cases
+   * `p_on_complete` is not called.
+   */
+  hal::status start(std::span<mpl3115a2::raw_sample_t> p_samples,
+                    hal::callback<completion_handler> p_on_complete);
+
+  /**
+   * @return true - a drain is in progress
+   */
+  [[nodiscard]] bool busy() const;
+
+private:
+  void on_status(hal::status p_status);
+  void on_data(hal::status p_status);
+  void finish(hal::result<mpl3115a2::fifo_read_t> p_read);
+
+  mpl3115a2* m_device;
+  async_i2c* m_bus;
+  std::array<hal::byte, 1> m_status{};
+  std::array<hal::byte,
+             mpl3115a2::fifo_capacity * mpl3115a2::fifo_sample_size>
+    m_data{};
+  std::span<mpl3115a2::raw_sample_t> m_samples{};
+  std::size_t m_count = 0;
+  bool m_overflow = false;
+  hal::callback<completion_handler> m_on_complete{};
+  std::atomic<bool> m_busy = false;
+};
+}  // namespace hal::mpl
@@ -0,0 +1,79 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+namespace hal::mpl {
+/**
+ * @brief First order low pass (exponential smoothing) filter
+ *
+ * Used to smooth converted pressure, altitude or temperature samples. The
+ * first sample passed through the filter seeds its state.
+ */
+class low_pass_filter
+{
+public:
+  /**
+   * @brief Construct a new low pass filter
+   *
+   * @param p_alpha - weight of each new sample, from 0.0 (ignore new samples)
+   * to 1.0 (no filtering).
+   */
+  constexpr explicit low_pass_filter(float p_alpha)
+    : m_alpha(p_alpha)
+  {
+  }
+
+  /**
+   * @brief Pass a new sample through the filter
+   *
+   * @param p_sample - new unfiltered sample
+   * @return constexpr float - filtered output
+   */
+  constexpr float update(float p_sample)
+  {
+    if (!m_seeded) {
+      m_state = p_sample;
+      m_seeded = true;
+    } else {
+      m_state += m_alpha * (p_sample - m_state);
+    }
+    return m_state;
+  }
+
+  /**
+   * @brief Latest filter output
+   *
+   * @return constexpr float - filtered value, 0.0 if no sample has been seen.
+   */
+  constexpr float value() const
+  {
+    return m_state;
+  }
+
+  /**
+   * @brief Forget previous samples so the next sample seeds the filter again
+   */
+  constexpr void reset()
+  {
+    m_seeded = false;
+    m_state = 0.0f;
+  }
+
+private:
+  float m_alpha;
+  float m_state = 0.0f;
+  bool m_seeded = false;
+};
+}  // namespace hal::mpl
@@ -0,0 +1,95 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <optional>
+
+#include <libhal/i2c.hpp>
+#include <libhal/timeout.hpp>
+#include <libhal/units.hpp>
+
+#include "conversion.hpp"
+#include "mpl3115a2.hpp"
+
+/**
+ * @file hot_path.hpp
+ * @brief Header-only steady state sample path
+ *
+ * The driver's own sample reads go through these functions, so they behave
+ * identically, but calling them directly lets the compiler inline the whole
+ * read and the conversion into the application's loop without link time
+ * optimization. When the bus type passed in is a `final` class, its
+ * `driver_transaction()` is devirtualized and can be inlined as well.
+ *
+ * Only use them while the driver is not converting on its own behalf, e.g. in
+ * continuous acquisition after `mpl3115a2::create()` or `configure()`. They
+ * do not trigger conversions and do not work in FIFO acquisition.
+ */
+namespace hal::mpl::hot_path {
+namespace detail {
+/// Registers of the hot path, the private register map src/mpl3115a2_reg.hpp
+/// uses these definitions
+inline constexpr hal::byte device_address = 0x60;
+inline constexpr hal::byte status_r = 0x00;
+inline constexpr hal::byte out_p_msb_r = 0x01;
+inline constexpr hal::byte status_pdr = 0x04;
+}  // namespace detail
+
+/**
+ * @brief Burst read OUT_P and OUT_T
+ *
+ * @tparam I2c - bus type, ideally the concrete `final` driver type
+ * @param p_i2c - bus the device is on
+ * @return hal::result<mpl3115a2::raw_sample_t> - the last converted sample
+ */
+template<class I2c>
+inline hal::result<mpl3115a2::raw_sample_t> read_output(I2c& p_i2c)
+{
+  // OUT_P and OUT_T are contiguous, read all five bytes at once
+  constexpr std::array<hal::byte, 1> address{ detail::out_p_msb_r };
+  std::array<hal::byte, 5> buffer{};
+  HAL_CHECK(p_i2c.transaction(
+    detail::device_address, address, buffer, hal::never_timeout()));
+
+  return mpl3115a2::raw_sample_t{
+    .pressure = to_raw_pressure(buffer[0], buffer[1], buffer[2]),
+    .temperature = to_raw_temperature(buffer[3], buffer[4]),
+  };
+}
+
+/**
+ * @brief Read the sample if a new pressure or altitude conversion completed
+ *
+ * @tparam I2c - bus type, ideally the concrete `final` driver type
+ * @param p_i2c - bus the device is on
+ * @return hal::result<std::optional<mpl3115a2::raw_sample_t>> - the new
+ * sample, or std::nullopt if none completed since the last read
+ */
+template<class I2c>
+inline hal::result<std::optional<mpl3115a2::raw_sample_t>> try_read(
+  I2c& p_i2c)
+{
+  constexpr std::array<hal::byte, 1> address{ detail::status_r };
+  std::array<hal::byte, 1> status{};
+  HAL_CHECK(p_i2c.transaction(
+    detail::device_address, address, status, hal::never_timeout()));
+
+  if ((status[0] & detail::status_pdr) == 0) {
+    return std::optional<mpl3115a2::raw_sample_t>{};
+  }
+  return std::optional(HAL_CHECK(read_output(p_i2c)));
+}
+}  // namespace hal::mpl::hot_path
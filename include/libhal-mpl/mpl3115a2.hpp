@@ -14,11 +14,21 @@
 
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+#include <libhal/functional.hpp>
 #include <libhal/i2c.hpp>
 #include <libhal/timeout.hpp>
 #include <libhal/units.hpp>
 
+#include "wait_policy.hpp"
+
 namespace hal::mpl {
+struct configuration;
+struct profile;
 
 class mpl3115a2
 {
@@ -45,6 +55,72 @@ public:
     meters altitude;
   };
 
+  /// Unconverted sample, see `conversion.hpp` for converting to units
+  struct raw_sample_t
+  {
+    /// Raw OUT_P word, pressure or altitude depending on the mode
+    std::uint32_t pressure;
+    /// Raw OUT_T word
+    std::int16_t temperature;
+  };
+
+  struct fifo_read_t
+  {
+    /// Samples read from the FIFO, oldest first
+    std::span<raw_sample_t> samples;
+    /// The FIFO overflowed since the last read, so samples were lost
+    bool overflow;
+  };
+
+  /**
+   * @brief Interrupt sources as laid out in CTRL_REG4, CTRL_REG5 and
+   * INT_SOURCE. Combine with `|` to form a mask.
+   */
+  struct interrupt
+  {
+    /// New pressure/altitude or temperature data is available
+    static constexpr hal::byte data_ready = 1 << 7;
+    /// FIFO watermark reached or FIFO overflowed
+    static constexpr hal::byte fifo = 1 << 6;
+    /// Pressure/altitude is outside of its target window
+    static constexpr hal::byte pressure_window = 1 << 5;
+    /// Temperature is outside of its target window
+    static constexpr hal::byte temperature_window = 1 << 4;
+    /// Pressure/altitude crossed its target threshold
+    static constexpr hal::byte pressure_threshold = 1 << 3;
+    /// Temperature crossed its target threshold
+    static constexpr hal::byte temperature_threshold = 1 << 2;
+    /// Pressure/altitude changed since the last measurement
+    static constexpr hal::byte pressure_change = 1 << 1;
+    /// Temperature changed since the last measurement
+    static constexpr hal::byte temperature_change = 1 << 0;
+  };
+
+  /// Electrical configuration of one interrupt output pin
+  struct interrupt_pin_settings
+  {
+    /// Drive the pin high when asserted, otherwise low
+    bool active_high = false;
+    /// Use an open drain output so the line can be shared with other devices
+    bool open_drain = false;
+  };
+
+  struct interrupt_settings
+  {
+    /// Interrupt sources to enable, see `interrupt`
+    hal::byte enabled = 0;
+    /// Enabled sources signaled on INT1, the remainder are signaled on INT2
+    hal::byte route_to_int1 = 0;
+    interrupt_pin_settings int1{};
+    interrupt_pin_settings int2{};
+  };
+
+  /**
+   * @brief Puts the caller to sleep or yields for at least `p_duration`, e.g.
+   * by waiting for interrupts or with an RTOS delay
+   */
+  using sleep_function = void(hal::time_duration p_duration);
+
   /**
    * @brief Initialization of MPLX device.
    *
@@ -57,6 +133,160 @@ public:
    */
   [[nodiscard]] static result<mpl3115a2> create(hal::i2c& p_i2c);
 
+  /**
+   * @brief Initialization of MPLX device with a specific configuration.
+   *
+   * Performs the WHOAMI check and reset, then applies `p_configuration`
+   * instead of the default configuration. Registers already at their reset
+   * value are not written.
+   *
+   * @param p_i2c The I2C peripheral used for communication with the device.
+   * @param p_configuration Configuration created with `make_configuration()`
+   * from `configuration.hpp`.
+   */
+  [[nodiscard]] static result<mpl3115a2> create(
+    hal::i2c& p_i2c,
+    const configuration& p_configuration);
+
+  /**
+   * @brief Initialization of MPLX device with a specific configuration that
+   * waits for the reset with `p_policy`
+   *
+   * Same as `create(p_i2c, p_configuration)` followed by
+   * `set_wait_policy(p_policy)`, except that the wait for the software reset
+   * already uses the policy.
+   *
+   * @param p_i2c The I2C peripheral used for communication with the device.
+   * @param p_configuration Configuration created with `make_configuration()`
+   * from `configuration.hpp`.
+   * @param p_policy Policy for every wait, must outlive the driver
+   */
+  [[nodiscard]] static result<mpl3115a2> create(
+    hal::i2c& p_i2c,
+    const configuration& p_configuration,
+    wait_policy& p_policy);
+
+  /**
+   * @brief Driver state kept in retained memory while the MCU is in deep
+   * sleep, see `snapshot()` and `resume()`
+   *
+   * Holds the driver's shadow of every register it writes, including the
+   * calibration written with `set_sea_pressure()` and
+   * `set_altitude_offset()`. Trivially copyable, so it can be stored and
+   * restored as bytes.
+   */
+  struct snapshot_t
+  {
+    /// Layout of the snapshot, `snapshot_version` when taken
+    std::uint8_t version;
+    /// `snapshot_fifo` and `snapshot_one_shot_pending`
+    std::uint8_t flags;
+    /// Conversion time of the configured oversampling ratio
+    std::uint16_t conversion_time_ms;
+    /// F_SETUP
+    hal::byte f_setup;
+    /// PT_DATA_CFG
+    hal::byte pt_data_cfg;
+    /// BAR_IN, MSB first
+    std::array<hal::byte, 2> bar_in;
+    /// P_TGT, MSB first
+    std::array<hal::byte, 2> p_tgt;
+    /// CTRL_REG1 to CTRL_REG5. CTRL_REG1 has the ALT bit of the current mode
+    /// and neither OST nor RST.
+    std::array<hal::byte, 5> control;
+    /// OFF_P, OFF_T and OFF_H
+    std::array<hal::byte, 3> offsets;
+  };
+
+  /// Current layout version of `snapshot_t`
+  static constexpr std::uint8_t snapshot_version = 2;
+  /// `snapshot_t::flags` bit set when samples are collected in the FIFO
+  static constexpr std::uint8_t snapshot_fifo = 1 << 0;
+  /// `snapshot_t::flags` bit set when a one-shot conversion was triggered
+  /// but not yet waited for
+  static constexpr std::uint8_t snapshot_one_shot_pending = 1 << 1;
+
+  /// How `resume()` confirms that the device still matches the snapshot
+  enum class resume_check : std::uint8_t
+  {
+    /// Trust the snapshot without any transaction, e.g. when the device is
+    /// known to have stayed powered
+    none,
+    /// Read PT_DATA_CFG through OFF_H in one burst and compare every
+    /// register the snapshot holds, plus F_SETUP in FIFO acquisition. A
+    /// device that was reset or lost power reads PT_DATA_CFG as 0, which no
+    /// configuration uses, and loses its calibration.
+    registers,
+  };
+
+  /**
+   * @brief Rebuild the driver from a snapshot without WHOAMI, reset or
+   * configuration transactions
+   *
+   * Use after deep sleep instead of `create()`. If the check fails, fall back
+   * to `create()`, which configures the device from scratch. Calibration
+   * written to the device, e.g. with `set_sea_pressure()`, is kept by a
+   * device that stayed powered and must be written again after `create()`.
+   * The wait policy is not part of the snapshot, set it again with
+   * `set_wait_policy()` or `on_conversion_wait()`.
+   *
+   * @param p_i2c The I2C peripheral used for communication with the device.
+   * @param p_snapshot State returned by `snapshot()` before sleeping
+   * @param p_check Verification to perform, one transaction or two in FIFO
+   * acquisition
+   * @return result<mpl3115a2> - the resumed driver,
+   * std::errc::invalid_argument for a snapshot of another layout version, or
+   * std::errc::state_not_recoverable if the device registers do not match
+   * the snapshot.
+   */
+  [[nodiscard]] static result<mpl3115a2> resume(
+    hal::i2c& p_i2c,
+    const snapshot_t& p_snapshot,
+    resume_check p_check = resume_check::registers);
+
+  /**
+   * @brief Capture the driver state to resume from after deep sleep
+   *
+   * Take the snapshot after the last transaction before sleeping, so that it
+   * matches the device.
+   *
+   * @return snapshot_t - state for `resume()`
+   */
+  [[nodiscard]] snapshot_t snapshot() const;
+
+  /**
+   * @brief Apply a complete configuration
+   *
+   * The device is placed in standby while the control registers are written
+   * and only returns to active mode, if the configuration requests it, after
+   * every register has been written. Changing between circular and stop FIFO
+   * mode disables the FIFO in between, as the datasheet requires, which
+   * discards the samples it holds.
+   *
+   * @param p_configuration Configuration created with `make_configuration()`
+   * from `configuration.hpp`.
+   */
+  hal::status configure(const configuration& p_configuration);
+
+  /**
+   * @brief Switch to a precomputed profile
+   *
+   * CTRL_REG1 to CTRL_REG5 are written in one auto-increment burst that
+   * starts with CTRL_REG1 in standby, so the remaining control registers are
+   * always written in standby. Switching from a one-shot to a one-shot
+   * profile takes that single transaction. Leaving a continuous profile
+   * takes one more write before it to enter standby, and switching to a
+   * continuous profile one more write after it to enter active mode once
+   * every register is in place.
+   *
+   * @param p_profile Profile created with `make_profile()` from
+   * `configuration.hpp`.
+   * @return hal::status - std::errc::operation_not_permitted while FIFO
+   * acquisition is configured, as F_SETUP is outside the control register
+   * block. Use `configure()` to leave FIFO acquisition.
+   */
+  hal::status apply(const profile& p_profile);
+
   /**
    * @brief Read pressure data from out_t_msb_r and out_t_lsb_r
    *        and perform temperature conversion to celsius.
@@ -75,6 +305,73 @@ public:
    */
   [[nodiscard]] hal::result<altitude_read_t> read_altitude();
 
+  /**
+   * @brief Start a conversion without waiting for it to complete
+   *
+   * Switches to `p_mode` if needed and, in one-shot acquisition, triggers the
+   * conversion. Collect the result with `read_sample()`. Splitting the two
+   * lets several devices convert at the same time.
+   *
+   * @param p_mode - barometer for pressure or altimeter for altitude
+   */
+  hal::status trigger_conversion(mode p_mode);
+
+  /**
+   * @brief Wait for the conversion started by `trigger_conversion()` and read
+   *        pressure/altitude and temperature in a single burst
+   *
+   * @return hal::result<raw_sample_t> - unconverted sample
+   */
+  [[nodiscard]] hal::result<raw_sample_t> read_sample();
+
+  /**
+   * @brief Check the data ready flag once and, if a sample is ready, read it
+   *        in a single burst
+   *
+   * Lets the caller decide how to wait between checks, see `polling.hpp`.
+   *
+   * @return hal::result<std::optional<raw_sample_t>> - the sample, or
+   * std::nullopt if the conversion has not completed yet.
+   * std::errc::operation_not_permitted if samples are collected in the FIFO.
+   */
+  [[nodiscard]] hal::result<std::optional<raw_sample_t>> try_read_sample();
+
+  /**
+   * @return hal::time_duration - conversion time of the configured
+   * oversampling ratio
+   */
+  [[nodiscard]] hal::time_duration conversion_time() const;
+
+  /**
+   * @brief Sleep through one-shot conversions instead of polling for them
+   *
+   * Once set, waiting for a triggered one-shot conversion first calls
+   * `p_sleep` with the conversion time of the configured oversampling ratio
+   * and then checks the data ready flag, which is then normally set on the
+   * first read. Polling resumes if it is not. Continuous acquisition always
+   * polls, as the time to the next sample is not known.
+   *
+   * The driver keeps a `polling::expected_time` policy around `p_sleep`,
+   * which replaces a policy set with `set_wait_policy()`.
+   *
+   * @param p_sleep - sleep or yield function, an empty callback restores
+   * polling
+   */
+  void on_conversion_wait(hal::callback<sleep_function> p_sleep);
+
+  /**
+   * @brief Wait with `p_policy` between every check of the device: for a
+   * conversion, for a previous one-shot to complete and for a software reset
+   *
+   * Before checking for a triggered one-shot conversion, the policy is started
+   * with the conversion time. Other waits start it with zero. Polling still
+   * gives up after `default_max_polling_retries` checks.
+   *
+   * @param p_policy - waiting strategy, see `polling.hpp`. Must outlive the
+   * driver or be replaced first.
+   */
+  void set_wait_policy(wait_policy& p_policy);
+
   /**
    * @brief Set sea level pressure (Barometric input for altitude calculations)
    *        in bar_in_msb_r and bar_in_lsb_r registers
@@ -83,13 +380,73 @@ public:
    */
   hal::status set_sea_pressure(float p_sea_level_pressure);
 
+  /**
+   * @brief Set the pressure target in p_tgt_msb_r and p_tgt_lsb_r used by the
+   *        `interrupt::pressure_threshold` and `interrupt::pressure_window`
+   *        sources in barometer mode
+   * @param p_target Target pressure in Pascals, stored in 2 Pa units.
+   */
+  hal::status set_pressure_target(float p_target);
+
   /**
    * @brief Set altitude offset in off_h_r
    * @param p_offset Offset value in meters, from -127 to 128
    */
   hal::status set_altitude_offset(int8_t p_offset);
 
-  /* Maximum number of retries for polling operations. */
+  /**
+   * @brief Configure interrupt pin polarity, output driver, enabled sources
+   *        and routing with a single write of CTRL_REG3 to CTRL_REG5
+   *
+   * The device must be in standby, which is always the case when using the
+   * one-shot read APIs.
+   *
+   * @param p_settings - interrupt configuration
+   */
+  hal::status configure_interrupts(const interrupt_settings& p_settings);
+
+  /**
+   * @brief Read INT_SOURCE to determine which enabled interrupts have fired
+   *
+   * Sources are cleared by servicing them, e.g. reading the output data
+   * registers clears `interrupt::data_ready`.
+   *
+   * @return hal::result<hal::byte> - mask of fired sources, see `interrupt`
+   */
+  [[nodiscard]] hal::result<hal::byte> read_interrupt_source();
+
+  /**
+   * @brief Drain samples from the FIFO
+   *
+   * Reads F_STATUS and then every available sample, up to the size of
+   * `p_samples`, in a single burst read of F_DATA. Requires a configuration
+   * using fifo acquisition.
+   *
+   * @param p_samples - destination for the samples, at most 32 are available
+   * @return hal::result<fifo_read_t> - the samples read and the overflow
+   * state, std::errc::operation_not_permitted if the FIFO is not enabled.
+   */
+  [[nodiscard]] hal::result<fifo_read_t> read_fifo(
+    std::span<raw_sample_t> p_samples);
+
+  /**
+   * @return true - samples are collected in the FIFO, see `read_fifo()`
+   */
+  [[nodiscard]] bool fifo_enabled() const;
+
+  /* Number of samples the FIFO can hold. */
+  static constexpr std::size_t fifo_capacity = 32;
+
+  /* Bytes per FIFO sample, 3 pressure/altitude bytes then 2 temperature
+   * bytes. */
+  static constexpr std::size_t fifo_sample_size = 5;
+
+  /**
+   * Maximum number of retries for polling operations. Polling operations that
+   * exhaust this limit fail with std::errc::timed_out, which bounds the number
+   * of transactions each API can issue. These bounds are verified by
+   * tests/worst_case.test.cpp.
+   */
   static constexpr uint16_t default_max_polling_retries = 10000;
 
 private:
@@ -99,12 +456,95 @@ private:
    */
   explicit mpl3115a2(hal::i2c& p_i2c);
 
+  /**
+   * @brief Check WHOAMI, reset the device and apply `p_configuration`
+   */
+  hal::status initialize(const configuration& p_configuration);
+
+  /**
+   * @brief Policy set with `set_wait_policy()`, otherwise the one built with
+   * `on_conversion_wait()`, otherwise `polling::immediate`
+   */
+  wait_policy& policy();
+
+  /**
+   * @brief CTRL_REG1 as the device holds it, without OST and RST
+   */
+  hal::byte current_ctrl_reg1() const;
+
+  /**
+   * @brief Put an active device in standby without changing other CTRL_REG1
+   * fields, before they are changed
+   */
+  hal::status enter_standby();
+
+  /**
+   * @brief Update the tracked device state from an applied configuration
+   */
+  void track_configuration(const configuration& p_configuration);
+
+  /**
+   * @brief Update the tracked device state from the control registers of an
+   * applied configuration only
+   */
+  void track_control(const configuration& p_configuration);
+
+  /**
+   * @brief Switch to the requested mode if needed and start a conversion, or
+   * in active mode only switch as conversions are already scheduled.
+   * @param p_mode Mode the conversion must be made in
+   */
+  hal::status begin_conversion(mode p_mode);
+
+  /**
+   * @brief Wait for a conversion to set `p_flag` in the status register with
+   * the wait policy
+   * @param p_flag Data ready flag to wait for
+   */
+  hal::status wait_for_conversion(hal::byte p_flag);
+
+  /**
+   * @brief Read OUT_P and OUT_T in a single burst
+   */
+  hal::result<raw_sample_t> read_output_sample();
+
   /* The I2C peripheral used for communication with the device. */
   hal::i2c* m_i2c;
 
   /* Variable to track current sensor mode to determine if CTRL_REG1 ALT flag
    * needs to be set. */
   mode m_sensor_mode = mode::barometer;
+
+  /* Set when the configuration puts the device in active mode, where
+   * conversions happen every time step rather than on a one-shot trigger. */
+  bool m_continuous = false;
+
+  /* Set when samples are collected in the FIFO rather than OUT_P/OUT_T. */
+  bool m_fifo = false;
+
+  /* Set between triggering a one-shot conversion and waiting for it. */
+  bool m_one_shot_pending = false;
+
+  /* Conversion time of the configured oversampling ratio. */
+  hal::time_duration m_conversion_time{};
+
+  /* Shadow of the registers the driver writes, for snapshots. The ALT bit
+   * of CTRL_REG1 follows m_sensor_mode instead. Starts at the reset values,
+   * BAR_IN resets to 101,326 Pa. */
+  hal::byte m_f_setup = 0;
+  hal::byte m_pt_data_cfg = 0;
+  std::array<hal::byte, 2> m_bar_in{ 0xC5, 0xE7 };
+  std::array<hal::byte, 2> m_p_tgt{};
+  std::array<hal::byte, 5> m_control{};
+  std::array<hal::byte, 3> m_offsets{};
+
+  /* Policy built by on_conversion_wait(). Owned so the driver stays
+   * movable. */
+  std::optional<polling::expected_time<hal::callback<sleep_function>>>
+    m_conversion_wait{};
+
+  /* Policy set with set_wait_policy(), not owned. */
+  wait_policy* m_wait_policy = nullptr;
 };
 
 }  // namespace hal::mpl
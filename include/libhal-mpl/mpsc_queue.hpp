@@ -0,0 +1,161 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+namespace hal::mpl {
+/**
+ * @brief Bounded lock-free queue with many producers and one consumer
+ *
+ * Hands batches of decoded samples from the threads or interrupts that
+ * receive them to a single processing thread without a mutex. Each slot
+ * carries a sequence number that tells producers and the consumer whose turn
+ * it is, so producers only contend on one compare-and-swap of the tail index
+ * and never wait on each other while copying their values in. The consumer
+ * side uses no read-modify-write operations at all.
+ *
+ * `try_push()` is safe from any number of threads. `try_pop()` must only be
+ * called from one thread at a time.
+ *
+ * @tparam T - value type, moved in and out of the queue
+ * @tparam Capacity - number of slots, a power of two
+ */
+template<typename T, std::size_t Capacity>
+class mpsc_queue
+{
+public:
+  static_assert(Capacity >= 2 && std::has_single_bit(Capacity),
+                "Capacity must be a power of two");
+
+  mpsc_queue()
+  {
+    for (std::size_t i = 0; i < Capacity; i++) {
+      m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  mpsc_queue(const mpsc_queue&) = delete;
+  mpsc_queue& operator=(const mpsc_queue&) = delete;
+
+  /**
+   * @brief Append a value unless the queue is full
+   *
+   * @param p_value - value to move into the queue
+   * @return true - the value was queued
+   * @return false - the queue is full, `p_value` was not moved from
+   */
+  bool try_push(T&& p_value)
+  {
+    return emplace(std::move(p_value));
+  }
+
+  /**
+   * @brief Append a copy of a value unless the queue is full
+   *
+   * @param p_value - value to copy into the queue
+   * @return true - the value was queued
+   * @return false - the queue is full
+   */
+  bool try_push(const T& p_value)
+  {
+    return emplace(p_value);
+  }
+
+  /**
+   * @brief Remove the oldest value. Consumer thread only.
+   *
+   * @return std::optional<T> - the oldest value, std::nullopt if the queue is
+   * empty or the oldest value is still being written by its producer.
+   */
+  std::optional<T> try_pop()
+  {
+    auto& slot = m_slots[m_head % Capacity];
+    if (slot.sequence.load(std::memory_order_acquire) != m_head + 1) {
+      return std::nullopt;
+    }
+
+    std::optional<T> value(std::move(slot.value));
+    // Hand the slot to the producer one lap ahead
+    slot.sequence.store(m_head + Capacity, std::memory_order_release);
+    m_head++;
+    return value;
+  }
+
+  /**
+   * @brief Number of queued values. Consumer thread only.
+   *
+   * @return std::size_t - values queued or being written, exact only when no
+   * producer is running
+   */
+  [[nodiscard]] std::size_t size_approx() const
+  {
+    return m_tail.load(std::memory_order_relaxed) - m_head;
+  }
+
+  static constexpr std::size_t capacity()
+  {
+    return Capacity;
+  }
+
+private:
+  template<typename U>
+  bool emplace(U&& p_value)
+  {
+    auto position = m_tail.load(std::memory_order_relaxed);
+
+    while (true) {
+      auto& slot = m_slots[position % Capacity];
+      auto sequence = slot.sequence.load(std::memory_order_acquire);
+      auto lag = static_cast<std::intptr_t>(sequence - position);
+
+      if (lag == 0) {
+        // The slot is free for this position, claim it
+        if (m_tail.compare_exchange_weak(
+              position, position + 1, std::memory_order_relaxed)) {
+          slot.value = std::forward<U>(p_value);
+          slot.sequence.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (lag < 0) {
+        // The consumer has not emptied the slot from the previous lap
+        return false;
+      } else {
+        // Another producer claimed this position first
+        position = m_tail.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /// Keeps the producer and consumer indices on separate cache lines
+  static constexpr std::size_t cache_line_size = 64;
+
+  struct slot_t
+  {
+    std::atomic<std::size_t> sequence;
+    T value{};
+  };
+
+  std::array<slot_t, Capacity> m_slots;
+  alignas(cache_line_size) std::atomic<std::size_t> m_tail = 0;
+  alignas(cache_line_size) std::size_t m_head = 0;
+};
+}  // namespace hal::mpl
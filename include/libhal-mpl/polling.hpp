@@ -0,0 +1,58 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+
+#include "mpl3115a2.hpp"
+#include "wait_policy.hpp"
+
+namespace hal::mpl {
+/**
+ * @brief Wait for the conversion started by `trigger_conversion()` using
+ * `p_policy` and read the sample
+ *
+ * Unlike `mpl3115a2::set_wait_policy()`, the policy and the attempt limit only
+ * apply to this read.
+ *
+ * @tparam Policy - waiting strategy, see `hal::mpl::polling`
+ * @param p_device - device with a conversion in progress
+ * @param p_policy - waiting strategy state
+ * @param p_max_attempts - data ready checks before giving up
+ * @return hal::result<mpl3115a2::raw_sample_t> - unconverted sample,
+ * std::errc::timed_out if the sample was not ready after `p_max_attempts`
+ * checks.
+ */
+template<typename Policy>
+[[nodiscard]] hal::result<mpl3115a2::raw_sample_t> read_sample(
+  mpl3115a2& p_device,
+  Policy& p_policy,
+  std::uint16_t p_max_attempts = mpl3115a2::default_max_polling_retries)
+{
+  p_policy.start(p_device.conversion_time());
+
+  for (std::uint16_t attempt = 0; attempt < p_max_attempts; attempt++) {
+    if (attempt != 0) {
+      p_policy.wait(attempt);
+    }
+    auto sample = HAL_CHECK(p_device.try_read_sample());
+    if (sample.has_value()) {
+      return *sample;
+    }
+  }
+
+  return hal::new_error(std::errc::timed_out);
+}
+}  // namespace hal::mpl
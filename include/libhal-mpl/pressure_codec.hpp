@@ -0,0 +1,716 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <system_error>
+
+#include <libhal/error.hpp>
+#include <libhal/units.hpp>
+
+/**
+ * @file pressure_codec.hpp
+ * @brief Lossless block codec for raw 20-bit pressure samples
+ *
+ * Each block predicts every sample from the previous ones and codes the
+ * prediction residuals with a Rice code whose parameter adapts to the running
+ * mean of the residuals. The predictor is chosen per block, either a fixed
+ * polynomial of order 0 to 3 or a linear predictor of up to order 12 over the
+ * sample differences, fitted to the block with the Levinson-Durbin recursion.
+ * The linear predictor averages sensor noise over many samples, which the
+ * polynomials cannot.
+ *
+ * Blocks are self contained so an archive can index them for random access,
+ * and `pressure_block_decoder` decodes a block incrementally into a buffer of
+ * any size.
+ *
+ * Block layout, little endian:
+ *
+ *   u16 sample count | u8 predictor | u8 coefficient shift |
+ *   u32 payload size in bytes | payload
+ *
+ * The predictor is the polynomial order, or 0x80 plus the order of a linear
+ * predictor. The payload holds the i16 coefficients of a linear predictor,
+ * followed by the residual bit stream, most significant bit first.
+ */
+namespace hal::mpl {
+/// Bytes in the header of every block
+static constexpr std::size_t pressure_block_header_size = 8;
+/// Maximum number of samples in a block
+static constexpr std::size_t max_pressure_block_samples = 4096;
+/// Width of a raw pressure sample, the OUT_P word shifted right by 4
+static constexpr unsigned pressure_sample_bits = 20;
+/// Maximum order of the linear predictor
+static constexpr unsigned max_pressure_lpc_order = 12;
+
+struct pressure_block_info
+{
+  /// Number of samples in the block
+  std::uint16_t samples;
+  /// Polynomial order, or `lpc_predictor` plus the linear predictor order
+  std::uint8_t predictor;
+  /// Fractional bits of the linear predictor coefficients
+  std::uint8_t shift;
+  /// Size of the coefficients and bit stream following the header
+  std::uint32_t payload_size;
+
+  /// Flag set in `predictor` for linear predictors
+  static constexpr std::uint8_t lpc_predictor = 0x80;
+
+  /// Size of the whole block in bytes
+  [[nodiscard]] constexpr std::size_t size() const
+  {
+    return pressure_block_header_size + payload_size;
+  }
+};
+
+namespace detail {
+/// Runs of this many zeros are followed by the residual in escape_bits bits
+static constexpr unsigned rice_escape_zeros = 24;
+/// Predictions are clamped to 20 bits, so residuals zig-zag map to 21 bits
+static constexpr unsigned rice_escape_bits = pressure_sample_bits + 1;
+/// The running mean is halved every this many samples to follow changes
+static constexpr std::uint32_t rice_reset_count = 64;
+static constexpr unsigned max_polynomial_order = 3;
+/// Fractional bits of quantized coefficients of magnitude below 2
+static constexpr unsigned lpc_precision = 14;
+
+constexpr std::uint32_t zigzag(std::int32_t p_value)
+{
+  return (static_cast<std::uint32_t>(p_value) << 1) ^
+         static_cast<std::uint32_t>(p_value >> 31);
+}
+
+constexpr std::int32_t unzigzag(std::uint32_t p_value)
+{
+  return static_cast<std::int32_t>(p_value >> 1) ^
+         -static_cast<std::int32_t>(p_value & 1);
+}
+
+/// Previous samples, most recent first
+using sample_history = std::array<std::int32_t, max_pressure_lpc_order + 1>;
+
+constexpr void push(sample_history& p_history, std::int32_t p_sample)
+{
+  std::copy_backward(
+    p_history.begin(), p_history.end() - 1, p_history.end());
+  p_history[0] = p_sample;
+}
+
+struct predictor
+{
+  std::uint8_t order = 0;
+  bool lpc = false;
+  std::uint8_t shift = 0;
+  std::array<std::int16_t, max_pressure_lpc_order> coefficients{};
+
+  /**
+   * @brief Predict the next sample, clamped to the 20-bit sample range
+   *
+   * @param p_history - previous samples, most recent first
+   * @param p_available - number of valid samples in `p_history`
+   */
+  [[nodiscard]] constexpr std::int32_t operator()(
+    const sample_history& p_history,
+    std::size_t p_available) const
+  {
+    std::int64_t prediction = 0;
+
+    if (lpc && p_available > order) {
+      // Predict the next difference from the previous differences
+      std::int64_t sum = 0;
+      for (std::size_t i = 0; i < order; i++) {
+        sum += std::int64_t(coefficients[i]) *
+               (p_history[i] - p_history[i + 1]);
+      }
+      prediction = p_history[0] + (sum >> shift);
+    } else {
+      auto usable = std::min<std::size_t>(lpc ? 1 : order, p_available);
+      switch (usable) {
+        case 0:
+          prediction = 0;
+          break;
+        case 1:
+          prediction = p_history[0];
+          break;
+        case 2:
+          prediction = 2 * p_history[0] - p_history[1];
+          break;
+        default:
+          prediction = 3 * p_history[0] - 3 * p_history[1] + p_history[2];
+          break;
+      }
+    }
+
+    constexpr std::int64_t max_sample = (1 << pressure_sample_bits) - 1;
+    return static_cast<std::int32_t>(std::clamp<std::int64_t>(
+      prediction, 0, max_sample));
+  }
+};
+
+/// Rice parameter from the running mean of the mapped residuals
+class rice_model
+{
+public:
+  [[nodiscard]] constexpr unsigned parameter() const
+  {
+    // Mapped residuals are twice the magnitude of the residuals. The smallest
+    // k where 2^k is at least half their mean is near the optimal Rice
+    // parameter for geometrically distributed residuals.
+    auto half_mean = (m_sum + 2 * m_count - 1) / (2 * m_count);
+    if (half_mean <= 1) {
+      return 0;
+    }
+    return std::min(static_cast<unsigned>(std::bit_width(half_mean - 1)),
+                    rice_escape_bits);
+  }
+
+  constexpr void update(std::uint32_t p_value)
+  {
+    m_sum += p_value;
+    m_count++;
+    if (m_count == rice_reset_count) {
+      m_sum /= 2;
+      m_count /= 2;
+    }
+  }
+
+private:
+  std::uint32_t m_sum = 16;
+  std::uint32_t m_count = 1;
+};
+
+class bit_writer
+{
+public:
+  constexpr explicit bit_writer(std::span<hal::byte> p_output)
+    : m_output(p_output)
+  {
+  }
+
+  /// Append the low `p_bits` bits of `p_value`, at most 32
+  constexpr void put(std::uint32_t p_value, unsigned p_bits)
+  {
+    m_accumulator = (m_accumulator << p_bits) | p_value;
+    m_bits += p_bits;
+    while (m_bits >= 8) {
+      m_bits -= 8;
+      emit(static_cast<hal::byte>(m_accumulator >> m_bits));
+    }
+  }
+
+  /// Pad the last byte with zeros and return the bytes written
+  constexpr std::size_t flush()
+  {
+    if (m_bits != 0) {
+      emit(static_cast<hal::byte>(m_accumulator << (8 - m_bits)));
+      m_bits = 0;
+    }
+    return m_position;
+  }
+
+  [[nodiscard]] constexpr bool overflowed() const
+  {
+    return m_position > m_output.size();
+  }
+
+private:
+  constexpr void emit(hal::byte p_byte)
+  {
+    if (m_position < m_output.size()) {
+      m_output[m_position] = p_byte;
+    }
+    m_position++;
+  }
+
+  std::span<hal::byte> m_output;
+  std::size_t m_position = 0;
+  std::uint64_t m_accumulator = 0;
+  unsigned m_bits = 0;
+};
+
+class bit_reader
+{
+public:
+  constexpr bit_reader() = default;
+
+  constexpr explicit bit_reader(std::span<const hal::byte> p_input)
+    : m_input(p_input)
+  {
+  }
+
+  /// Make at least 57 bits available, reading zeros past the end
+  constexpr void refill()
+  {
+    if (m_position + 8 <= m_input.size()) {
+      // Load 8 bytes at once and keep the whole bytes that fit
+      std::uint64_t next = 0;
+      for (std::size_t i = 0; i < 8; i++) {
+        next = (next << 8) | m_input[m_position + i];
+      }
+      m_accumulator |= next >> m_bits;
+      m_position += (63 - m_bits) / 8;
+      m_bits |= 56;
+      return;
+    }
+    while (m_bits <= 56) {
+      hal::byte next = 0;
+      if (m_position < m_input.size()) {
+        next = m_input[m_position];
+      }
+      m_position++;
+      m_accumulator |= std::uint64_t(next) << (56 - m_bits);
+      m_bits += 8;
+    }
+  }
+
+  [[nodiscard]] constexpr unsigned leading_zeros() const
+  {
+    return static_cast<unsigned>(std::countl_zero(m_accumulator));
+  }
+
+  /// Remove `p_bits` bits, at most 32, that were made available by refill()
+  constexpr std::uint32_t take(unsigned p_bits)
+  {
+    if (p_bits == 0) {
+      return 0;
+    }
+    auto value = static_cast<std::uint32_t>(m_accumulator >> (64 - p_bits));
+    m_accumulator <<= p_bits;
+    m_bits -= p_bits;
+    return value;
+  }
+
+  /// Reads went past the end of the input
+  [[nodiscard]] constexpr bool overrun() const
+  {
+    return m_position * 8 - m_bits > m_input.size() * 8;
+  }
+
+private:
+  std::span<const hal::byte> m_input{};
+  std::size_t m_position = 0;
+  std::uint64_t m_accumulator = 0;
+  unsigned m_bits = 0;
+};
+
+/// Sum of the mapped residuals of `p_predictor` over a block, which tracks
+/// the coded size
+inline std::uint64_t residual_cost(std::span<const std::uint32_t> p_samples,
+                                   const predictor& p_predictor)
+{
+  std::uint64_t cost = 0;
+  sample_history history{};
+  for (std::size_t i = 0; i < p_samples.size(); i++) {
+    auto sample = static_cast<std::int32_t>(p_samples[i]);
+    cost += zigzag(sample - p_predictor(history, i));
+    push(history, sample);
+  }
+  return cost;
+}
+
+/**
+ * @brief Fit linear predictors of every order up to `p_max_order` to the
+ * sample differences and keep the one with the smallest residuals
+ *
+ * @return predictor - best linear predictor, order 0 if none could be fitted
+ */
+inline predictor fit_lpc(std::span<const std::uint32_t> p_samples,
+                         unsigned p_max_order,
+                         std::uint64_t& p_cost)
+{
+  predictor best{};
+  auto count = p_samples.size();
+  if (p_max_order == 0 || count <= p_max_order + 1) {
+    return best;
+  }
+
+  // Autocorrelation of the differences
+  std::array<double, max_pressure_lpc_order + 1> correlation{};
+  for (std::size_t lag = 0; lag <= p_max_order; lag++) {
+    double sum = 0.0;
+    for (std::size_t i = lag + 2; i <= count; i++) {
+      double current = double(p_samples[i - 1]) - double(p_samples[i - 2]);
+      double previous = double(p_samples[i - 1 - lag]) -
+                        double(p_samples[i - 2 - lag]);
+      sum += current * previous;
+    }
+    correlation[lag] = sum;
+  }
+  if (correlation[0] <= 0.0) {
+    return best;
+  }
+
+  // Levinson-Durbin recursion, yielding the predictor of every order
+  std::array<double, max_pressure_lpc_order + 1> lpc{};
+  std::array<double, max_pressure_lpc_order + 1> previous{};
+  double error = correlation[0];
+  for (unsigned order = 1; order <= p_max_order; order++) {
+    double reflection = correlation[order];
+    for (unsigned j = 1; j < order; j++) {
+      reflection -= lpc[j] * correlation[order - j];
+    }
+    reflection /= error;
+
+    previous = lpc;
+    lpc[order] = reflection;
+    for (unsigned j = 1; j < order; j++) {
+      lpc[j] = previous[j] - reflection * previous[order - j];
+    }
+    error *= 1.0 - reflection * reflection;
+    if (error <= 0.0) {
+      break;
+    }
+
+    // Every residual pass costs as much as coding the block, so only a few
+    // orders are tried
+    bool evaluate = order <= 2 || order % 4 == 0 || order == p_max_order;
+    if (!evaluate) {
+      continue;
+    }
+
+    // Quantize with as many fractional bits as fit in 16 bits
+    double largest = 0.0;
+    for (unsigned j = 1; j <= order; j++) {
+      largest = std::max(largest, std::abs(lpc[j]));
+    }
+    unsigned shift = lpc_precision;
+    while (shift > 0 && largest * double(1 << shift) > 32767.0) {
+      shift--;
+    }
+
+    predictor candidate{
+      .order = static_cast<std::uint8_t>(order),
+      .lpc = true,
+      .shift = static_cast<std::uint8_t>(shift),
+    };
+    for (unsigned j = 1; j <= order; j++) {
+      auto quantized = std::lround(lpc[j] * double(1 << shift));
+      candidate.coefficients[j - 1] =
+        static_cast<std::int16_t>(std::clamp<long>(quantized, -32768, 32767));
+    }
+
+    auto cost = residual_cost(p_samples, candidate);
+    if (cost < p_cost) {
+      p_cost = cost;
+      best = candidate;
+    }
+  }
+
+  return best;
+}
+}  // namespace detail
+
+/**
+ * @brief Worst case size of a block holding `p_samples` samples, for sizing
+ * the output buffer of `encode_pressure_block()`
+ */
+constexpr std::size_t max_pressure_block_size(std::size_t p_samples)
+{
+  constexpr std::size_t bits_per_sample =
+    detail::rice_escape_zeros + 1 + detail::rice_escape_bits;
+  return pressure_block_header_size + 2 * max_pressure_lpc_order +
+         (p_samples * bits_per_sample + 7) / 8;
+}
+
+/**
+ * @brief Read and validate a block header
+ *
+ * @param p_block - bytes starting at a block
+ * @return hal::result<pressure_block_info> - block header,
+ * std::errc::bad_message if the header is invalid or the block is truncated.
+ */
+inline hal::result<pressure_block_info> read_pressure_block_header(
+  std::span<const hal::byte> p_block)
+{
+  if (p_block.size() < pressure_block_header_size) {
+    return hal::new_error(std::errc::bad_message);
+  }
+
+  pressure_block_info info{
+    .samples = static_cast<std::uint16_t>(p_block[0] | p_block[1] << 8),
+    .predictor = p_block[2],
+    .shift = p_block[3],
+    .payload_size = std::uint32_t(p_block[4]) |
+                    std::uint32_t(p_block[5]) << 8 |
+                    std::uint32_t(p_block[6]) << 16 |
+                    std::uint32_t(p_block[7]) << 24,
+  };
+
+  bool lpc = (info.predictor & pressure_block_info::lpc_predictor) != 0;
+  unsigned order = info.predictor & ~pressure_block_info::lpc_predictor;
+  bool valid_predictor =
+    lpc ? (order >= 1 && order <= max_pressure_lpc_order &&
+           info.shift <= detail::lpc_precision &&
+           info.payload_size >= 2 * order)
+        : (order <= detail::max_polynomial_order && info.shift == 0);
+
+  if (info.samples == 0 || info.samples > max_pressure_block_samples ||
+      !valid_predictor ||
+      info.payload_size > p_block.size() - pressure_block_header_size) {
+    return hal::new_error(std::errc::bad_message);
+  }
+
+  return info;
+}
+
+/**
+ * @brief Encode up to `max_pressure_block_samples` samples into one block
+ *
+ * @param p_samples - raw 20-bit pressure samples, e.g. `to_raw_pressure() >> 4`
+ * @param p_output - destination, `max_pressure_block_size()` bytes always
+ * suffice
+ * @param p_max_lpc_order - highest linear predictor order to try. 0 only
+ * tries the polynomial predictors, which avoids the floating point predictor
+ * fitting on devices without an FPU.
+ * @return hal::result<std::size_t> - size of the block in bytes,
+ * std::errc::invalid_argument if there are no samples, too many samples, a
+ * sample is wider than 20 bits or the order is above
+ * `max_pressure_lpc_order`, std::errc::no_buffer_space if `p_output` is too
+ * small.
+ */
+inline hal::result<std::size_t> encode_pressure_block(
+  std::span<const std::uint32_t> p_samples,
+  std::span<hal::byte> p_output,
+  unsigned p_max_lpc_order = max_pressure_lpc_order)
+{
+  if (p_samples.empty() || p_samples.size() > max_pressure_block_samples ||
+      p_max_lpc_order > max_pressure_lpc_order) {
+    return hal::new_error(std::errc::invalid_argument);
+  }
+  for (auto sample : p_samples) {
+    if (sample >> pressure_sample_bits) {
+      return hal::new_error(std::errc::invalid_argument);
+    }
+  }
+
+  // Pick the predictor that leaves the smallest residuals over the block
+  detail::predictor best{};
+  auto best_cost = detail::residual_cost(p_samples, best);
+  for (std::uint8_t order = 1; order <= detail::max_polynomial_order;
+       order++) {
+    detail::predictor polynomial{ .order = order };
+    auto cost = detail::residual_cost(p_samples, polynomial);
+    if (cost < best_cost) {
+      best_cost = cost;
+      best = polynomial;
+    }
+  }
+  auto lpc = detail::fit_lpc(p_samples, p_max_lpc_order, best_cost);
+  if (lpc.order != 0) {
+    best = lpc;
+  }
+
+  std::size_t coefficient_bytes = best.lpc ? 2 * best.order : 0;
+  if (p_output.size() < pressure_block_header_size + coefficient_bytes) {
+    return hal::new_error(std::errc::no_buffer_space);
+  }
+  auto payload = p_output.subspan(pressure_block_header_size);
+  for (std::size_t i = 0; i < coefficient_bytes / 2; i++) {
+    auto coefficient = static_cast<std::uint16_t>(best.coefficients[i]);
+    payload[2 * i] = hal::byte(coefficient);
+    payload[2 * i + 1] = hal::byte(coefficient >> 8);
+  }
+
+  detail::bit_writer writer(payload.subspan(coefficient_bytes));
+  detail::rice_model model;
+  detail::sample_history history{};
+  for (std::size_t i = 0; i < p_samples.size(); i++) {
+    auto sample = static_cast<std::int32_t>(p_samples[i]);
+    auto mapped = detail::zigzag(sample - best(history, i));
+    auto k = model.parameter();
+    auto quotient = mapped >> k;
+
+    if (quotient < detail::rice_escape_zeros) {
+      // quotient zeros terminated by a one, then the k low bits
+      writer.put(1, quotient + 1);
+      writer.put(mapped & ((std::uint32_t(1) << k) - 1), k);
+    } else {
+      writer.put(1, detail::rice_escape_zeros + 1);
+      writer.put(mapped, detail::rice_escape_bits);
+    }
+
+    model.update(mapped);
+    detail::push(history, sample);
+  }
+
+  auto payload_size = coefficient_bytes + writer.flush();
+  if (writer.overflowed()) {
+    return hal::new_error(std::errc::no_buffer_space);
+  }
+
+  auto count = static_cast<std::uint16_t>(p_samples.size());
+  auto size = static_cast<std::uint32_t>(payload_size);
+  p_output[0] = hal::byte(count);
+  p_output[1] = hal::byte(count >> 8);
+  p_output[2] = best.lpc ? hal::byte(pressure_block_info::lpc_predictor |
+                                     best.order)
+                         : best.order;
+  p_output[3] = best.shift;
+  p_output[4] = hal::byte(size);
+  p_output[5] = hal::byte(size >> 8);
+  p_output[6] = hal::byte(size >> 16);
+  p_output[7] = hal::byte(size >> 24);
+
+  return pressure_block_header_size + payload_size;
+}
+
+/**
+ * @brief Incremental decoder for one block
+ *
+ * Decodes as many samples as fit in each buffer passed to `read()`, so a block
+ * can be streamed through a small buffer.
+ */
+class pressure_block_decoder
+{
+public:
+  /**
+   * @brief Create a decoder for the block at the start of `p_block`
+   *
+   * @param p_block - bytes starting at a block, which must remain valid while
+   * decoding
+   * @return hal::result<pressure_block_decoder> - decoder,
+   * std::errc::bad_message if the header is invalid.
+   */
+  static hal::result<pressure_block_decoder> create(
+    std::span<const hal::byte> p_block)
+  {
+    auto info = HAL_CHECK(read_pressure_block_header(p_block));
+    auto payload =
+      p_block.subspan(pressure_block_header_size, info.payload_size);
+
+    detail::predictor predictor{
+      .order = static_cast<std::uint8_t>(
+        info.predictor & ~pressure_block_info::lpc_predictor),
+      .lpc = (info.predictor & pressure_block_info::lpc_predictor) != 0,
+      .shift = info.shift,
+    };
+    std::size_t coefficient_bytes = predictor.lpc ? 2 * predictor.order : 0;
+    for (std::size_t i = 0; i < coefficient_bytes / 2; i++) {
+      predictor.coefficients[i] = static_cast<std::int16_t>(
+        payload[2 * i] | std::uint16_t(payload[2 * i + 1]) << 8);
+    }
+
+    return pressure_block_decoder(
+      info, predictor, payload.subspan(coefficient_bytes));
+  }
+
+  /**
+   * @brief Decode the next samples of the block
+   *
+   * @param p_samples - destination for up to `remaining()` samples
+   * @return hal::result<std::span<std::uint32_t>> - the samples decoded,
+   * empty once the block is finished, std::errc::bad_message if the block is
+   * corrupt.
+   */
+  hal::result<std::span<std::uint32_t>> read(
+    std::span<std::uint32_t> p_samples)
+  {
+    auto count = std::min(p_samples.size(), remaining());
+
+    for (std::size_t i = 0; i < count; i++) {
+      m_reader.refill();
+      auto zeros = m_reader.leading_zeros();
+      if (zeros > detail::rice_escape_zeros) {
+        return hal::new_error(std::errc::bad_message);
+      }
+      m_reader.take(zeros + 1);
+
+      std::uint32_t mapped = 0;
+      if (zeros == detail::rice_escape_zeros) {
+        mapped = m_reader.take(detail::rice_escape_bits);
+      } else {
+        auto k = m_model.parameter();
+        mapped = (std::uint32_t(zeros) << k) | m_reader.take(k);
+      }
+      m_model.update(mapped);
+
+      auto sample = m_predictor(m_history, m_decoded) +
+                    detail::unzigzag(mapped);
+      if (sample < 0 || (sample >> pressure_sample_bits) != 0) {
+        return hal::new_error(std::errc::bad_message);
+      }
+      detail::push(m_history, sample);
+      p_samples[i] = static_cast<std::uint32_t>(sample);
+      m_decoded++;
+    }
+
+    if (m_reader.overrun()) {
+      return hal::new_error(std::errc::bad_message);
+    }
+
+    return p_samples.first(count);
+  }
+
+  /**
+   * @return std::size_t - samples not yet decoded
+   */
+  [[nodiscard]] std::size_t remaining() const
+  {
+    return m_info.samples - m_decoded;
+  }
+
+  /**
+   * @return const pressure_block_info& - header of the block
+   */
+  [[nodiscard]] const pressure_block_info& info() const
+  {
+    return m_info;
+  }
+
+private:
+  pressure_block_decoder(pressure_block_info p_info,
+                         detail::predictor p_predictor,
+                         std::span<const hal::byte> p_bits)
+    : m_info(p_info)
+    , m_predictor(p_predictor)
+    , m_reader(p_bits)
+  {
+  }
+
+  pressure_block_info m_info;
+  detail::predictor m_predictor;
+  detail::bit_reader m_reader;
+  detail::rice_model m_model{};
+  detail::sample_history m_history{};
+  std::size_t m_decoded = 0;
+};
+
+/**
+ * @brief Decode a whole block
+ *
+ * @param p_block - bytes starting at a block
+ * @param p_samples - destination, at least the sample count of the block
+ * @return hal::result<std::span<std::uint32_t>> - the decoded samples,
+ * std::errc::no_buffer_space if `p_samples` is too small,
+ * std::errc::bad_message if the block is corrupt.
+ */
+inline hal::result<std::span<std::uint32_t>> decode_pressure_block(
+  std::span<const hal::byte> p_block,
+  std::span<std::uint32_t> p_samples)
+{
+  auto decoder = HAL_CHECK(pressure_block_decoder::create(p_block));
+  if (p_samples.size() < decoder.remaining()) {
+    return hal::new_error(std::errc::no_buffer_space);
+  }
+  return decoder.read(p_samples);
+}
+}  // namespace hal::mpl
@@ -0,0 +1,107 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+
+#include <libhal/units.hpp>
+
+#include "filter.hpp"
+#include "mpl3115a2.hpp"
+
+namespace hal::mpl {
+/**
+ * @brief Keeps the sea level pressure input (BAR_IN) of an mpl3115a2 matched
+ * to an external reference altitude, e.g. from GNSS
+ *
+ * Every reference altitude paired with a barometric sample gives a sea level
+ * pressure estimate through the barometric formula. The estimates pass
+ * through a slow low pass filter, so GNSS noise does not reach the altitude
+ * output, and BAR_IN is only rewritten once the filtered estimate moves by
+ * at least the register's 2 Pa resolution.
+ */
+class qnh_tracker
+{
+public:
+  struct settings
+  {
+    /// Weight of each new estimate, see `low_pass_filter`
+    float alpha = 0.01f;
+    /// BAR_IN value of the device when tracking starts, the reset value by
+    /// default
+    float sea_pressure = 101326.0f;
+  };
+
+  /**
+   * @brief Construct a new QNH tracker
+   *
+   * @param p_device - device whose BAR_IN is maintained
+   * @param p_settings - filter weight and current BAR_IN value
+   */
+  qnh_tracker(mpl3115a2& p_device, settings p_settings);
+
+  /**
+   * @brief Construct a new QNH tracker for a device with the reset BAR_IN
+   * value and the default filter weight
+   *
+   * @param p_device - device whose BAR_IN is maintained
+   */
+  explicit qnh_tracker(mpl3115a2& p_device);
+
+  /**
+   * @brief Update the estimate from a barometer mode sample
+   *
+   * @param p_pressure - measured pressure in pascals (Pa)
+   * @param p_reference - true altitude of the device in meters
+   * @return hal::status - success, or the error of writing BAR_IN
+   */
+  hal::status update_pressure(float p_pressure, meters p_reference);
+
+  /**
+   * @brief Update the estimate from an altimeter mode sample
+   *
+   * The device computed `p_altitude` from the BAR_IN value last written, so
+   * the pressure it measured is recovered from that value.
+   *
+   * @param p_altitude - altitude reported by the device in meters
+   * @param p_reference - true altitude of the device in meters
+   * @return hal::status - success, or the error of writing BAR_IN
+   */
+  hal::status update_altitude(meters p_altitude, meters p_reference);
+
+  /**
+   * @return float - filtered sea level pressure estimate in pascals (Pa)
+   */
+  [[nodiscard]] float sea_pressure() const;
+
+  /**
+   * @return float - sea level pressure last written to BAR_IN in pascals (Pa)
+   */
+  [[nodiscard]] float written_sea_pressure() const;
+
+  /**
+   * @return std::uint32_t - number of BAR_IN writes
+   */
+  [[nodiscard]] std::uint32_t writes() const;
+
+private:
+  hal::status update(float p_sea_pressure);
+
+  mpl3115a2* m_device;
+  low_pass_filter m_filter;
+  float m_written;
+  std::uint32_t m_writes = 0;
+};
+}  // namespace hal::mpl
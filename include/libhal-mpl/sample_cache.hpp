@@ -0,0 +1,127 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+
+#include <libhal/steady_clock.hpp>
+#include <libhal/units.hpp>
+
+#include "mpl3115a2.hpp"
+
+namespace hal::mpl {
+/**
+ * @brief Shares the samples of one mpl3115a2 between many readers
+ *
+ * A sample younger than the max age is returned without touching the bus, so
+ * every module reading within the same control tick gets the result of a
+ * single conversion. Readers that poll with `try_read()` while a conversion
+ * is in progress wait on that conversion rather than starting another, which
+ * coalesces their requests when they interleave, e.g. as cooperative tasks.
+ *
+ * The age of a sample is measured from the trigger of its conversion, the
+ * earliest time it could have been taken. A conversion in progress that was
+ * triggered longer than the max age ago is collected and discarded, and a new
+ * one is started, so `try_read()` needs a max age longer than the conversion
+ * time to ever return a sample.
+ *
+ * Not thread safe. Readers running in separate threads must serialize their
+ * calls.
+ */
+class sample_cache
+{
+public:
+  struct sample_t
+  {
+    /// Unconverted pressure, or altitude, and temperature
+    mpl3115a2::raw_sample_t raw;
+    /// Uptime ticks when the conversion was triggered
+    std::uint64_t timestamp;
+  };
+
+  /**
+   * @brief Construct a new sample cache object
+   *
+   * @param p_device - device to take the samples from
+   * @param p_clock - clock used to age samples
+   * @param p_max_age - oldest sample returned without a new conversion
+   * @param p_mode - measurement mode of the cached samples
+   */
+  sample_cache(mpl3115a2& p_device,
+               hal::steady_clock& p_clock,
+               hal::time_duration p_max_age,
+               mpl3115a2::mode p_mode = mpl3115a2::mode::barometer);
+
+  /**
+   * @brief Return the cached sample if it is fresh, otherwise convert a new
+   * one and wait for it
+   *
+   * Waits for a conversion already started by `try_read()` instead of
+   * triggering another, unless that conversion was triggered longer than the
+   * max age ago.
+   *
+   * @return hal::result<sample_t> - a sample no older than the max age
+   */
+  [[nodiscard]] hal::result<sample_t> read();
+
+  /**
+   * @brief Return the cached sample if it is fresh, otherwise start a
+   * conversion, or check the one in progress, without waiting
+   *
+   * @return hal::result<std::optional<sample_t>> - a sample no older than the
+   * max age, or std::nullopt while its conversion is in progress
+   */
+  [[nodiscard]] hal::result<std::optional<sample_t>> try_read();
+
+  /**
+   * @brief Discard the cached sample so the next read converts a new one,
+   * e.g. after reconfiguring the device
+   */
+  void invalidate();
+
+  /**
+   * @param p_max_age - oldest sample returned without a new conversion
+   */
+  void set_max_age(hal::time_duration p_max_age);
+
+  /**
+   * @return std::uint32_t - conversions triggered by the cache
+   */
+  [[nodiscard]] std::uint32_t conversions() const;
+
+  /**
+   * @return std::uint32_t - reads answered from the cache or from a
+   * conversion started for another reader
+   */
+  [[nodiscard]] std::uint32_t coalesced() const;
+
+private:
+  [[nodiscard]] bool fresh(std::uint64_t p_now) const;
+  [[nodiscard]] bool within_max_age(std::uint64_t p_now,
+                                    std::uint64_t p_timestamp) const;
+  hal::status start_conversion(std::uint64_t p_now);
+
+  mpl3115a2* m_device;
+  hal::steady_clock* m_clock;
+  mpl3115a2::mode m_mode;
+  std::uint64_t m_max_age_ticks = 0;
+  std::optional<sample_t> m_sample;
+  /// Trigger time of the conversion in progress
+  std::optional<std::uint64_t> m_pending;
+  std::uint32_t m_conversions = 0;
+  std::uint32_t m_coalesced = 0;
+};
+}  // namespace hal::mpl
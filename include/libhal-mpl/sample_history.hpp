@@ -0,0 +1,186 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <system_error>
+
+#include <libhal/error.hpp>
+#include <libhal/units.hpp>
+
+namespace hal::mpl {
+/**
+ * @brief Fixed capacity history of converted samples keyed by timestamp
+ *
+ * Lets consumers such as sensor fusion ask for barometer values at times that
+ * do not line up with the sample times, without each keeping its own copy of
+ * recent samples. Values between two samples are linearly interpolated.
+ * Lookups are a binary search over the ring buffer, O(log Capacity).
+ *
+ * Once full, each new sample replaces the oldest one.
+ *
+ * @tparam Capacity - number of samples kept
+ */
+template<std::size_t Capacity>
+class sample_history
+{
+public:
+  static_assert(Capacity >= 2, "Interpolation needs at least two samples");
+
+  struct sample_t
+  {
+    /// Time of the sample, in ticks of the caller's clock
+    std::uint64_t timestamp;
+    /// Pressure in pascals (Pa)
+    float pressure;
+    meters altitude;
+    celsius temperature;
+  };
+
+  /**
+   * @brief Append the newest sample
+   *
+   * @param p_sample - sample newer than every sample in the history
+   * @return hal::status - std::errc::invalid_argument if the timestamp is not
+   * after the newest sample's.
+   */
+  constexpr hal::status push(const sample_t& p_sample)
+  {
+    if (m_size != 0 && p_sample.timestamp <= newest_sample().timestamp) {
+      return hal::new_error(std::errc::invalid_argument);
+    }
+
+    m_samples[(m_first + m_size) % Capacity] = p_sample;
+    if (m_size == Capacity) {
+      m_first = (m_first + 1) % Capacity;
+    } else {
+      m_size++;
+    }
+    return hal::success();
+  }
+
+  /**
+   * @brief Sample at any time within the history
+   *
+   * @param p_timestamp - time of interest, between the oldest and newest
+   * sample inclusive
+   * @return hal::result<sample_t> - the sample at that time, interpolated
+   * between its neighbors, std::errc::result_out_of_range if the time is
+   * outside of the history.
+   */
+  constexpr hal::result<sample_t> at(std::uint64_t p_timestamp) const
+  {
+    if (m_size == 0 || p_timestamp < oldest_sample().timestamp ||
+        p_timestamp > newest_sample().timestamp) {
+      return hal::new_error(std::errc::result_out_of_range);
+    }
+
+    // Find the first sample at or after the timestamp
+    std::size_t low = 0;
+    std::size_t high = m_size - 1;
+    while (low < high) {
+      auto middle = low + (high - low) / 2;
+      if (get(middle).timestamp < p_timestamp) {
+        low = middle + 1;
+      } else {
+        high = middle;
+      }
+    }
+
+    const auto& after = get(low);
+    if (after.timestamp == p_timestamp) {
+      return after;
+    }
+
+    const auto& before = get(low - 1);
+    auto fraction = static_cast<float>(p_timestamp - before.timestamp) /
+                    static_cast<float>(after.timestamp - before.timestamp);
+    auto lerp = [fraction](float p_from, float p_to) {
+      return p_from + (p_to - p_from) * fraction;
+    };
+
+    return sample_t{
+      .timestamp = p_timestamp,
+      .pressure = lerp(before.pressure, after.pressure),
+      .altitude = lerp(before.altitude, after.altitude),
+      .temperature = lerp(before.temperature, after.temperature),
+    };
+  }
+
+  /**
+   * @return hal::result<sample_t> - oldest sample,
+   * std::errc::result_out_of_range if the history is empty.
+   */
+  constexpr hal::result<sample_t> oldest() const
+  {
+    if (m_size == 0) {
+      return hal::new_error(std::errc::result_out_of_range);
+    }
+    return oldest_sample();
+  }
+
+  /**
+   * @return hal::result<sample_t> - newest sample,
+   * std::errc::result_out_of_range if the history is empty.
+   */
+  constexpr hal::result<sample_t> newest() const
+  {
+    if (m_size == 0) {
+      return hal::new_error(std::errc::result_out_of_range);
+    }
+    return newest_sample();
+  }
+
+  /**
+   * @return constexpr std::size_t - number of samples in the history
+   */
+  constexpr std::size_t size() const
+  {
+    return m_size;
+  }
+
+  /**
+   * @brief Forget every sample, e.g. after a time base change
+   */
+  constexpr void clear()
+  {
+    m_first = 0;
+    m_size = 0;
+  }
+
+private:
+  /// Sample by age, 0 is the oldest
+  constexpr const sample_t& get(std::size_t p_index) const
+  {
+    return m_samples[(m_first + p_index) % Capacity];
+  }
+
+  constexpr const sample_t& oldest_sample() const
+  {
+    return get(0);
+  }
+
+  constexpr const sample_t& newest_sample() const
+  {
+    return get(m_size - 1);
+  }
+
+  std::array<sample_t, Capacity> m_samples{};
+  std::size_t m_first = 0;
+  std::size_t m_size = 0;
+};
+}  // namespace hal::mpl
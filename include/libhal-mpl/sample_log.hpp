@@ -0,0 +1,88 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+#include <libhal/units.hpp>
+
+namespace hal::mpl {
+/**
+ * @brief A single logged measurement holding the raw device registers
+ *
+ * Logs keep the raw register words so that they can be converted later with
+ * the functions in `conversion.hpp` without losing resolution.
+ */
+struct sample_record
+{
+  /// Capture time in milliseconds
+  std::uint32_t timestamp;
+  /// Raw OUT_P word, see `to_raw_pressure()`
+  std::uint32_t pressure;
+  /// Raw OUT_T word, see `to_raw_temperature()`
+  std::int16_t temperature;
+
+  bool operator==(const sample_record&) const = default;
+};
+
+/// Size of an encoded sample_record in bytes
+static constexpr std::size_t sample_record_size = 10;
+
+/**
+ * @brief Encode a record into its little endian log representation
+ *
+ * @param p_record - record to encode
+ * @return constexpr std::array<hal::byte, sample_record_size> - encoded bytes
+ */
+constexpr std::array<hal::byte, sample_record_size> encode(
+  const sample_record& p_record)
+{
+  auto temperature = static_cast<std::uint16_t>(p_record.temperature);
+  return {
+    hal::byte(p_record.timestamp),       hal::byte(p_record.timestamp >> 8),
+    hal::byte(p_record.timestamp >> 16), hal::byte(p_record.timestamp >> 24),
+    hal::byte(p_record.pressure),        hal::byte(p_record.pressure >> 8),
+    hal::byte(p_record.pressure >> 16),  hal::byte(p_record.pressure >> 24),
+    hal::byte(temperature),              hal::byte(temperature >> 8),
+  };
+}
+
+/**
+ * @brief Decode a record from its little endian log representation
+ *
+ * @param p_bytes - exactly sample_record_size bytes from a log
+ * @return constexpr sample_record - decoded record
+ */
+constexpr sample_record decode(
+  std::span<const hal::byte, sample_record_size> p_bytes)
+{
+  auto u32 = [&p_bytes](std::size_t p_offset) -> std::uint32_t {
+    return std::uint32_t(p_bytes[p_offset]) |
+           std::uint32_t(p_bytes[p_offset + 1]) << 8 |
+           std::uint32_t(p_bytes[p_offset + 2]) << 16 |
+           std::uint32_t(p_bytes[p_offset + 3]) << 24;
+  };
+  auto temperature =
+    static_cast<std::uint16_t>(p_bytes[8] | std::uint16_t(p_bytes[9]) << 8);
+
+  return sample_record{
+    .timestamp = u32(0),
+    .pressure = u32(4),
+    .temperature = static_cast<std::int16_t>(temperature),
+  };
+}
+}  // namespace hal::mpl
@@ -0,0 +1,248 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include <libhal/functional.hpp>
+#include <libhal/input_pin.hpp>
+#include <libhal/interrupt_pin.hpp>
+
+#include "mpl3115a2.hpp"
+
+namespace hal::mpl {
+/**
+ * @brief Dispatcher for several mpl3115a2 devices whose INT pins share one
+ * open drain interrupt line
+ *
+ * Configure each device's interrupt pin with `open_drain = true` and the same
+ * polarity. On an edge, `service()` reads INT_SOURCE of the registered
+ * devices, most frequently firing device first, and calls the handlers of
+ * only the devices that fired. When the level of the line can be read, the
+ * search stops as soon as the line is released so the remaining devices are
+ * not touched at all.
+ *
+ * @tparam MaxDevices - maximum number of devices sharing the line
+ */
+template<std::size_t MaxDevices>
+class shared_interrupt
+{
+public:
+  /**
+   * @brief Called for each device with pending interrupts. Must service the
+   * reported sources so the device releases the line.
+   */
+  using handler = void(mpl3115a2& p_device, hal::byte p_sources);
+
+  /**
+   * @brief Construct a new shared interrupt dispatcher
+   *
+   * @param p_line - optional input connected to the shared line. Without it,
+   * every registered device is checked on each edge.
+   * @param p_active_high - level of the line when asserted
+   */
+  explicit shared_interrupt(hal::input_pin* p_line = nullptr,
+                            bool p_active_high = false)
+    : m_line(p_line)
+    , m_active_high(p_active_high)
+  {
+  }
+
+  /**
+   * @brief Register a device on the shared line
+   *
+   * @param p_device - device whose INT pin is wired to the line
+   * @param p_sources - interrupt sources that the handler services
+   * @param p_handler - called with the fired sources from `p_sources`
+   * @return hal::status - std::errc::no_buffer_space if MaxDevices devices are
+   * already registered.
+   */
+  hal::status add(mpl3115a2& p_device,
+                  hal::byte p_sources,
+                  hal::callback<handler> p_handler)
+  {
+    if (m_count >= MaxDevices) {
+      return hal::new_error(std::errc::no_buffer_space);
+    }
+    m_entries[m_count++] = entry{
+      .device = &p_device,
+      .sources = p_sources,
+      .callback = std::move(p_handler),
+    };
+    return hal::success();
+  }
+
+  /**
+   * @brief Install `notify()` as the trigger handler of the interrupt pin
+   * wired to the shared line
+   *
+   * @param p_pin - interrupt pin wired to the shared line
+   */
+  void attach(hal::interrupt_pin& p_pin)
+  {
+    p_pin.on_trigger([this](bool) { notify(); });
+  }
+
+  /**
+   * @brief Record that the shared line fired. Safe to call from an interrupt
+   * service routine.
+   */
+  void notify()
+  {
+    m_pending.store(true, std::memory_order_release);
+  }
+
+  /**
+   * @return true - the line fired since the last `service()`
+   */
+  [[nodiscard]] bool pending() const
+  {
+    return m_pending.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief Service the devices that fired, if the line fired since the last
+   * call. Call from thread context, never from the interrupt itself, as
+   * servicing performs I2C transactions.
+   *
+   * @return hal::result<std::size_t> - number of device handlers called
+   */
+  [[nodiscard]] hal::result<std::size_t> service()
+  {
+    if (!m_pending.exchange(false, std::memory_order_acq_rel)) {
+      return std::size_t{ 0 };
+    }
+    return dispatch();
+  }
+
+  /**
+   * @brief Check the registered devices and call the handlers of the ones
+   * that fired, regardless of `pending()`.
+   *
+   * When the level of the line can be read, devices are checked again while
+   * the line stays asserted, e.g. because a device that was already read
+   * fired again. If it is still asserted after a few passes, `pending()` is
+   * set so the next `service()` continues.
+   *
+   * @return hal::result<std::size_t> - number of device handlers called
+   */
+  [[nodiscard]] hal::result<std::size_t> dispatch()
+  {
+    std::size_t serviced = 0;
+
+    for (std::size_t pass = 0; pass < max_passes; pass++) {
+      serviced += HAL_CHECK(scan());
+      // Without the line level there is no way to tell whether a device that
+      // was already read fired again
+      if (m_line == nullptr || !HAL_CHECK(line_asserted())) {
+        return serviced;
+      }
+    }
+
+    // A device keeps firing, or a source nobody services holds the line. An
+    // edge triggered line will not fire again, so service the line on the
+    // next call.
+    notify();
+    return serviced;
+  }
+
+  /**
+   * @return std::size_t - number of registered devices
+   */
+  [[nodiscard]] std::size_t size() const
+  {
+    return m_count;
+  }
+
+private:
+  struct entry
+  {
+    mpl3115a2* device = nullptr;
+    hal::byte sources = 0;
+    hal::callback<handler> callback{};
+    std::uint16_t hits = 0;
+  };
+
+  /// Walks over the devices, after which a line that is still asserted is
+  /// left for the next `service()`
+  static constexpr std::size_t max_passes = 3;
+
+  hal::result<std::size_t> scan()
+  {
+    std::size_t serviced = 0;
+
+    for (std::size_t i = 0; i < m_count; i++) {
+      if (!HAL_CHECK(line_asserted())) {
+        break;
+      }
+
+      auto& current = m_entries[i];
+      auto fired = HAL_CHECK(current.device->read_interrupt_source());
+      fired &= current.sources;
+      if (fired == 0) {
+        continue;
+      }
+
+      current.callback(*current.device, fired);
+      serviced++;
+      record_hit(i);
+    }
+
+    return serviced;
+  }
+
+  hal::result<bool> line_asserted()
+  {
+    if (m_line == nullptr) {
+      return true;
+    }
+    auto level = HAL_CHECK(m_line->level()).state;
+    return level == m_active_high;
+  }
+
+  /**
+   * @brief Count a hit and move the entry ahead of entries that fire less
+   * often, so the device most likely to have fired is read first.
+   */
+  void record_hit(std::size_t p_index)
+  {
+    if (m_entries[p_index].hits == UINT16_MAX) {
+      // Decay all counts so the order keeps adapting to recent behavior
+      for (std::size_t i = 0; i < m_count; i++) {
+        m_entries[i].hits /= 2;
+      }
+    }
+    m_entries[p_index].hits++;
+
+    // Moving the entry forward only shifts entries that were already
+    // checked during this scan, so none are skipped or checked twice.
+    while (p_index > 0 &&
+           m_entries[p_index - 1].hits < m_entries[p_index].hits) {
+      std::swap(m_entries[p_index - 1], m_entries[p_index]);
+      p_index--;
+    }
+  }
+
+  std::array<entry, MaxDevices> m_entries{};
+  std::size_t m_count = 0;
+  hal::input_pin* m_line;
+  bool m_active_high;
+  std::atomic<bool> m_pending = false;
+};
+}  // namespace hal::mpl
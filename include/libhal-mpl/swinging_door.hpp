@@ -0,0 +1,206 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+
+namespace hal::mpl {
+/**
+ * @brief Lossy swinging door compression of a slowly varying sample stream
+ *
+ * Emits only the points needed to reconstruct the stream by linear
+ * interpolation between them, with every input sample within the tolerance
+ * of the reconstruction. Nearly constant pressure from a stationary node
+ * collapses to a point per trend change, or per `max_interval` if set, so only
+ * emitted points need to be transmitted.
+ *
+ * Samples are fed one at a time, e.g. converted with `to_pascals()` as they
+ * come from the driver:
+ *
+ *     hal::mpl::swinging_door door({ .tolerance = 2.0f });
+ *     auto point = door.update({ .timestamp = now, .value = pascals });
+ *     if (point) {
+ *       transmit(*point);
+ *     }
+ *
+ * A segment is only closed once a sample no longer fits it, so the latest
+ * emitted point lags the stream. Call `flush()` before going quiet to emit
+ * the end of the open segment.
+ *
+ * Values are floats, so the tolerance must be well above their resolution,
+ * about 0.008 at sea level pressure in pascals.
+ */
+class swinging_door
+{
+public:
+  struct point
+  {
+    /// Time of the sample, in ticks of the caller's clock
+    std::uint64_t timestamp;
+    float value;
+  };
+
+  struct settings
+  {
+    /// Largest difference between a sample and the reconstruction
+    float tolerance;
+    /// Longest time between emitted points, e.g. as a heartbeat, unless
+    /// samples are further apart. 0 for no limit.
+    std::uint64_t max_interval = 0;
+  };
+
+  /**
+   * @param p_settings - error bound and heartbeat interval
+   */
+  constexpr explicit swinging_door(const settings& p_settings)
+    : m_settings(p_settings)
+  {
+  }
+
+  /**
+   * @brief Add the next sample
+   *
+   * Samples not newer than the previous one are ignored.
+   *
+   * @param p_sample - next sample of the stream
+   * @return constexpr std::optional<point> - the point closing the previous
+   * segment if `p_sample` does not fit it, and the very first sample
+   */
+  constexpr std::optional<point> update(const point& p_sample)
+  {
+    if (!m_archived) {
+      m_archived = p_sample;
+      return p_sample;
+    }
+    auto previous = m_last ? m_last->timestamp : m_archived->timestamp;
+    if (p_sample.timestamp <= previous) {
+      return std::nullopt;
+    }
+
+    std::optional<point> closed;
+    if (m_last) {
+      auto [low, high] = slopes(p_sample);
+      low = std::max(m_low, low);
+      high = std::min(m_high, high);
+      bool too_long = m_settings.max_interval != 0 &&
+                      p_sample.timestamp - m_archived->timestamp >
+                        m_settings.max_interval;
+      if (low <= high && !too_long) {
+        m_low = low;
+        m_high = high;
+        m_last = p_sample;
+        return std::nullopt;
+      }
+      closed = close();
+    }
+
+    auto [low, high] = slopes(p_sample);
+    m_low = low;
+    m_high = high;
+    m_last = p_sample;
+    return closed;
+  }
+
+  /**
+   * @brief Close the open segment at the latest sample
+   *
+   * @return constexpr std::optional<point> - end of the open segment, or
+   * std::nullopt if every sample is already covered by emitted points
+   */
+  constexpr std::optional<point> flush()
+  {
+    if (!m_last) {
+      return std::nullopt;
+    }
+    auto closed = close();
+    m_last.reset();
+    return closed;
+  }
+
+  /**
+   * @brief Forget the stream, the next sample is emitted as its first point
+   */
+  constexpr void reset()
+  {
+    m_archived.reset();
+    m_last.reset();
+  }
+
+  /**
+   * @brief Reconstruct the stream between two consecutive emitted points
+   *
+   * @param p_start - earlier emitted point
+   * @param p_end - next emitted point
+   * @param p_timestamp - time between the two points
+   * @return constexpr float - value within the tolerance of the sample taken
+   * at `p_timestamp`
+   */
+  static constexpr float interpolate(const point& p_start,
+                                     const point& p_end,
+                                     std::uint64_t p_timestamp)
+  {
+    auto span = static_cast<float>(p_end.timestamp - p_start.timestamp);
+    auto elapsed = static_cast<float>(p_timestamp - p_start.timestamp);
+    return p_start.value + (p_end.value - p_start.value) * (elapsed / span);
+  }
+
+private:
+  struct slope_window
+  {
+    float low;
+    float high;
+  };
+
+  /// Slopes from the last emitted point that keep `p_sample` in tolerance
+  constexpr slope_window slopes(const point& p_sample) const
+  {
+    auto elapsed =
+      static_cast<float>(p_sample.timestamp - m_archived->timestamp);
+    auto rise = p_sample.value - m_archived->value;
+    return slope_window{
+      .low = (rise - m_settings.tolerance) / elapsed,
+      .high = (rise + m_settings.tolerance) / elapsed,
+    };
+  }
+
+  /// Emit the end of the open segment at the latest sample, on the line
+  /// through the window closest to that sample
+  constexpr point close()
+  {
+    auto elapsed =
+      static_cast<float>(m_last->timestamp - m_archived->timestamp);
+    auto slope = std::clamp(
+      (m_last->value - m_archived->value) / elapsed, m_low, m_high);
+    m_archived = point{
+      .timestamp = m_last->timestamp,
+      .value = m_archived->value + slope * elapsed,
+    };
+    return *m_archived;
+  }
+
+  settings m_settings;
+  /// Last emitted point, where the open segment starts
+  std::optional<point> m_archived;
+  /// Latest sample of the open segment
+  std::optional<point> m_last;
+  /// Slopes from `m_archived` that keep every sample of the open segment in
+  /// tolerance
+  float m_low = 0.0f;
+  float m_high = 0.0f;
+};
+}  // namespace hal::mpl
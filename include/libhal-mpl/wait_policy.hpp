@@ -0,0 +1,185 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+#include <libhal/units.hpp>
+
+namespace hal::mpl {
+/**
+ * @brief Decides how the driver waits between checks of a device flag, e.g.
+ * for a conversion, a one-shot trigger or a software reset to complete
+ *
+ * `start()` is called before the first check with the time the condition is
+ * expected to take, zero if it is expected at once or not known. `wait()` is
+ * called before each later check with the number of checks made so far.
+ *
+ * `hal::mpl::polling` below provides the common strategies. Pass one to
+ * `mpl3115a2::set_wait_policy()` or to `hal::mpl::read_sample()` from
+ * `polling.hpp`.
+ */
+class wait_policy
+{
+public:
+  /**
+   * @brief Called before the first check
+   *
+   * @param p_expected - time the condition is expected to take
+   */
+  void start(hal::time_duration p_expected)
+  {
+    driver_start(p_expected);
+  }
+
+  /**
+   * @brief Called before every check after the first
+   *
+   * @param p_attempt - checks made so far
+   */
+  void wait(std::uint16_t p_attempt)
+  {
+    driver_wait(p_attempt);
+  }
+
+  virtual ~wait_policy() = default;
+
+private:
+  virtual void driver_start(hal::time_duration p_expected) = 0;
+  virtual void driver_wait(std::uint16_t p_attempt) = 0;
+};
+}  // namespace hal::mpl
+
+/**
+ * @brief Policies for waiting on the device, see `hal::mpl::wait_policy`
+ *
+ * A policy decides what happens before the first check of a flag and between
+ * later checks, trading latency against bus load and CPU time. Give one to
+ * `mpl3115a2::set_wait_policy()` and every wait of the driver uses it, or to
+ * `read_sample()` to wait for a single triggered conversion.
+ *
+ * Policies are class templates, so strategies that are not used are not
+ * linked. Policies that sleep take a callable with the signature
+ * `void(hal::time_duration)`, e.g. a wrapper around `hal::delay()` or an RTOS
+ * delay.
+ */
+namespace hal::mpl::polling {
+/// Check back to back, lowest latency and highest bus load
+class immediate final : public wait_policy
+{
+private:
+  void driver_start(hal::time_duration) override
+  {
+  }
+
+  void driver_wait(std::uint16_t) override
+  {
+  }
+};
+
+/// Sleep for a fixed time between checks
+template<typename Sleep>
+class fixed_delay final : public wait_policy
+{
+public:
+  fixed_delay(Sleep p_sleep, hal::time_duration p_delay)
+    : m_sleep(std::move(p_sleep))
+    , m_delay(p_delay)
+  {
+  }
+
+private:
+  void driver_start(hal::time_duration) override
+  {
+  }
+
+  void driver_wait(std::uint16_t) override
+  {
+    m_sleep(m_delay);
+  }
+
+  Sleep m_sleep;
+  hal::time_duration m_delay;
+};
+
+/// Double the sleep between checks, starting at `p_initial` and never
+/// exceeding `p_maximum`
+template<typename Sleep>
+class exponential_backoff final : public wait_policy
+{
+public:
+  exponential_backoff(Sleep p_sleep,
+                      hal::time_duration p_initial,
+                      hal::time_duration p_maximum)
+    : m_sleep(std::move(p_sleep))
+    , m_initial(p_initial)
+    , m_maximum(p_maximum)
+    , m_delay(p_initial)
+  {
+  }
+
+private:
+  void driver_start(hal::time_duration) override
+  {
+    m_delay = m_initial;
+  }
+
+  void driver_wait(std::uint16_t) override
+  {
+    m_sleep(m_delay);
+    m_delay = std::min(m_delay * 2, m_maximum);
+  }
+
+  Sleep m_sleep;
+  hal::time_duration m_initial;
+  hal::time_duration m_maximum;
+  hal::time_duration m_delay;
+};
+
+/// Sleep for the expected time, e.g. the conversion time of the configured
+/// oversampling ratio, before the first check, then check every `p_interval`
+template<typename Sleep>
+class expected_time final : public wait_policy
+{
+public:
+  explicit expected_time(Sleep p_sleep,
+                         hal::time_duration p_interval = hal::time_duration{})
+    : m_sleep(std::move(p_sleep))
+    , m_interval(p_interval)
+  {
+  }
+
+private:
+  void driver_start(hal::time_duration p_expected) override
+  {
+    if (p_expected != hal::time_duration{}) {
+      m_sleep(p_expected);
+    }
+  }
+
+  void driver_wait(std::uint16_t) override
+  {
+    if (m_interval != hal::time_duration{}) {
+      m_sleep(m_interval);
+    }
+  }
+
+  Sleep m_sleep;
+  hal::time_duration m_interval;
+};
+}  // namespace hal::mpl::polling
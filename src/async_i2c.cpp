@@ -0,0 +1,42 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-mpl/async_i2c.hpp>
+
+#include <libhal/timeout.hpp>
+
+namespace hal::mpl {
+sync_i2c_adapter::sync_i2c_adapter(hal::i2c& p_i2c)
+  : m_i2c(&p_i2c)
+{
+}
+
+hal::status sync_i2c_adapter::driver_transaction(
+  hal::byte p_address,
+  std::span<const hal::byte> p_data_out,
+  std::span<hal::byte> p_data_in,
+  hal::callback<completion_handler> p_on_complete)
+{
+  auto outcome = m_i2c->transaction(
+    p_address, p_data_out, p_data_in, hal::never_timeout());
+
+  if (outcome) {
+    p_on_complete(hal::success());
+  } else {
+    p_on_complete(outcome.error());
+  }
+
+  return hal::success();
+}
+}  // namespace hal::mpl
@@ -0,0 +1,243 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-mpl/bus_scheduler.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+namespace hal::mpl {
+std::uint32_t bus_scheduler::client::missed() const
+{
+  return m_missed;
+}
+
+std::uint32_t bus_scheduler::client::completed() const
+{
+  return m_completed;
+}
+
+void bus_scheduler::client::set_deadline(hal::time_duration p_deadline)
+{
+  m_deadline_ticks = m_scheduler->to_ticks(p_deadline);
+}
+
+bus_scheduler::client::client(bus_scheduler& p_scheduler,
+                              hal::time_duration p_deadline)
+  : m_scheduler(&p_scheduler)
+{
+  set_deadline(p_deadline);
+}
+
+bus_scheduler::channel::channel(bus_scheduler& p_scheduler,
+                                hal::time_duration p_deadline)
+  : client(p_scheduler, p_deadline)
+{
+}
+
+hal::status bus_scheduler::channel::driver_transaction(
+  hal::byte p_address,
+  std::span<const hal::byte> p_data_out,
+  std::span<hal::byte> p_data_in,
+  hal::callback<completion_handler> p_on_complete)
+{
+  return m_scheduler->submit(
+    *this, p_address, p_data_out, p_data_in, std::move(p_on_complete));
+}
+
+bus_scheduler::blocking_channel::blocking_channel(
+  bus_scheduler& p_scheduler,
+  hal::time_duration p_deadline)
+  : client(p_scheduler, p_deadline)
+{
+}
+
+hal::status bus_scheduler::blocking_channel::driver_configure(const settings&)
+{
+  // The clock rate is shared by every device, so it belongs to the owner of
+  // the underlying bus
+  return hal::new_error(std::errc::operation_not_permitted);
+}
+
+hal::result<hal::i2c::transaction_t>
+bus_scheduler::blocking_channel::driver_transaction(
+  hal::byte p_address,
+  std::span<const hal::byte> p_data_out,
+  std::span<hal::byte> p_data_in,
+  hal::function_ref<hal::timeout_function> p_timeout)
+{
+  m_outcome.reset();
+  HAL_CHECK(m_scheduler->submit(
+    *this, p_address, p_data_out, p_data_in, [this](hal::status p_status) {
+      m_outcome = p_status;
+    }));
+
+  while (!m_outcome) {
+    m_scheduler->run();
+    if (m_outcome) {
+      break;
+    }
+    auto waiting = p_timeout();
+    // A job on the bus cannot be withdrawn, it is bounded by the bus instead
+    if (!waiting && m_scheduler->cancel(*this)) {
+      return waiting.error();
+    }
+  }
+
+  HAL_CHECK(*m_outcome);
+  return transaction_t{};
+}
+
+bus_scheduler::bus_scheduler(async_i2c& p_bus, hal::steady_clock& p_clock)
+  : m_bus(&p_bus)
+  , m_clock(&p_clock)
+{
+}
+
+std::size_t bus_scheduler::run()
+{
+  std::size_t completed = 0;
+
+  while (true) {
+    if (m_active) {
+      if (!m_done.load(std::memory_order_acquire)) {
+        break;
+      }
+      finish();
+      completed++;
+      continue;
+    }
+
+    dispatch();
+    if (!m_active) {
+      break;
+    }
+  }
+
+  return completed;
+}
+
+bool bus_scheduler::idle() const
+{
+  if (m_active) {
+    return false;
+  }
+  for (const auto& job : m_pending) {
+    if (job) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bus_scheduler::statistics_t bus_scheduler::statistics() const
+{
+  return m_statistics;
+}
+
+hal::status bus_scheduler::submit(
+  client& p_client,
+  hal::byte p_address,
+  std::span<const hal::byte> p_data_out,
+  std::span<hal::byte> p_data_in,
+  hal::callback<async_i2c::completion_handler> p_on_complete)
+{
+  for (auto& slot : m_pending) {
+    if (!slot) {
+      slot = job_t{
+        .address = p_address,
+        .data_out = p_data_out,
+        .data_in = p_data_in,
+        .deadline = m_clock->uptime().ticks + p_client.m_deadline_ticks,
+        .sequence = m_sequence++,
+        .owner = &p_client,
+        .on_complete = std::move(p_on_complete),
+      };
+      return hal::success();
+    }
+  }
+
+  return hal::new_error(std::errc::resource_unavailable_try_again);
+}
+
+bool bus_scheduler::cancel(client& p_client)
+{
+  for (auto& slot : m_pending) {
+    if (slot && slot->owner == &p_client) {
+      slot.reset();
+      return true;
+    }
+  }
+  return false;
+}
+
+void bus_scheduler::finish()
+{
+  auto job = std::move(*m_active);
+  m_active.reset();
+  m_done.store(false, std::memory_order_relaxed);
+
+  auto now = m_clock->uptime().ticks;
+  m_statistics.completed++;
+  job.owner->m_completed++;
+  if (now > job.deadline) {
+    m_statistics.missed++;
+    m_statistics.max_lateness =
+      std::max(m_statistics.max_lateness, now - job.deadline);
+    job.owner->m_missed++;
+  }
+
+  job.on_complete(m_outcome);
+}
+
+void bus_scheduler::dispatch()
+{
+  std::optional<job_t>* earliest = nullptr;
+  for (auto& slot : m_pending) {
+    if (slot && (!earliest || slot->deadline < (*earliest)->deadline ||
+                 (slot->deadline == (*earliest)->deadline &&
+                  slot->sequence < (*earliest)->sequence))) {
+      earliest = &slot;
+    }
+  }
+  if (!earliest) {
+    return;
+  }
+
+  m_active = std::move(*earliest);
+  earliest->reset();
+
+  auto started = m_bus->transaction(m_active->address,
+                                    m_active->data_out,
+                                    m_active->data_in,
+                                    [this](hal::status p_status) {
+                                      m_outcome = p_status;
+                                      m_done.store(true,
+                                                   std::memory_order_release);
+                                    });
+  if (!started) {
+    // The bus never calls back, complete the job with the failure instead
+    m_outcome = started;
+    m_done.store(true, std::memory_order_release);
+  }
+}
+
+std::uint64_t bus_scheduler::to_ticks(hal::time_duration p_duration)
+{
+  auto frequency = m_clock->frequency().operating_frequency;
+  auto seconds = std::chrono::duration<double>(p_duration).count();
+  return static_cast<std::uint64_t>(seconds * frequency);
+}
+}  // namespace hal::mpl
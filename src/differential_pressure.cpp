@@ -0,0 +1,83 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-mpl/differential_pressure.hpp>
+
+#include <libhal-mpl/conversion.hpp>
+
+namespace hal::mpl {
+differential_pressure::differential_pressure(mpl3115a2& p_high,
+                                             mpl3115a2& p_low,
+                                             hal::steady_clock& p_clock)
+  : m_high(&p_high)
+  , m_low(&p_low)
+  , m_clock(&p_clock)
+{
+}
+
+hal::result<differential_pressure::reading_t> differential_pressure::read()
+{
+  // Trigger both conversions before waiting on either so they run in
+  // parallel, separated only by the trigger transactions. A trigger ends with
+  // the OST write that starts the conversion, so the clock is read right
+  // after each one.
+  HAL_CHECK(m_high->trigger_conversion(mpl3115a2::mode::barometer));
+  auto high_trigger = m_clock->uptime().ticks;
+  HAL_CHECK(m_low->trigger_conversion(mpl3115a2::mode::barometer));
+  auto low_trigger = m_clock->uptime().ticks;
+
+  auto high_sample = HAL_CHECK(m_high->read_sample());
+  auto low_sample = HAL_CHECK(m_low->read_sample());
+
+  auto high = to_pascals(high_sample.pressure);
+  auto low = to_pascals(low_sample.pressure);
+  auto skew = low_trigger - high_trigger;
+
+  return reading_t{
+    .difference = high - low - m_offset,
+    .high = high,
+    .low = low,
+    .timestamp = high_trigger + skew / 2,
+    .skew = skew,
+  };
+}
+
+hal::result<float> differential_pressure::calibrate(std::uint16_t p_samples)
+{
+  if (p_samples == 0) {
+    return hal::new_error(std::errc::invalid_argument);
+  }
+
+  // Accumulate in double so long calibrations do not lose the fractional
+  // pascals to float rounding.
+  double sum = 0.0;
+  for (std::uint16_t i = 0; i < p_samples; i++) {
+    auto reading = HAL_CHECK(read());
+    sum += static_cast<double>(reading.high - reading.low);
+  }
+
+  m_offset = static_cast<float>(sum / p_samples);
+  return m_offset;
+}
+
+void differential_pressure::set_offset(float p_offset)
+{
+  m_offset = p_offset;
+}
+
+float differential_pressure::offset() const
+{
+  return m_offset;
+}
+}  // namespace hal::mpl
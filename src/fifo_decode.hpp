@@ -0,0 +1,69 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <span>
+
+#include <libhal-mpl/conversion.hpp>
+#include <libhal-mpl/mpl3115a2.hpp>
+
+#include "mpl3115a2_reg.hpp"
+
+namespace hal::mpl {
+/// Samples to read and overflow state from an F_STATUS value
+struct fifo_status_t
+{
+  std::size_t count;
+  bool overflow;
+};
+
+/**
+ * @brief Decode F_STATUS shared by the blocking and asynchronous FIFO reads
+ *
+ * @param p_f_status - F_STATUS value
+ * @param p_space - samples the caller can take
+ * @return constexpr fifo_status_t - samples to burst read from F_DATA
+ */
+constexpr fifo_status_t decode_fifo_status(hal::byte p_f_status,
+                                           std::size_t p_space)
+{
+  auto available = static_cast<std::size_t>(p_f_status & f_status_cnt_mask);
+  return {
+    .count = std::min({ available, p_space, mpl3115a2::fifo_capacity }),
+    .overflow = (p_f_status & f_status_ovf) != 0,
+  };
+}
+
+/**
+ * @brief Decode an F_DATA burst into raw samples
+ *
+ * @param p_data - burst of `p_samples.size()` samples
+ * @param p_samples - decoded samples
+ */
+constexpr void decode_fifo_data(std::span<const hal::byte> p_data,
+                                std::span<mpl3115a2::raw_sample_t> p_samples)
+{
+  for (std::size_t i = 0; i < p_samples.size(); i++) {
+    auto sample = p_data.subspan(i * mpl3115a2::fifo_sample_size,
+                                 mpl3115a2::fifo_sample_size);
+    p_samples[i] = mpl3115a2::raw_sample_t{
+      .pressure = to_raw_pressure(sample[0], sample[1], sample[2]),
+      .temperature = to_raw_temperature(sample[3], sample[4]),
+    };
+  }
+}
+}  // namespace hal::mpl
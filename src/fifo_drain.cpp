@@ -0,0 +1,117 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-mpl/fifo_drain.hpp>
+
+#include <utility>
+
+#include "fifo_decode.hpp"
+#include "mpl3115a2_reg.hpp"
+
+namespace hal::mpl {
+namespace {
+// Register addresses are written from static storage as the bus reads them
+// after start() returns.
+// status_r aliases F_STATUS in FIFO mode
+constexpr std::array<hal::byte, 1> f_status_address{ status_r };
+// out_p_msb_r aliases F_DATA in FIFO mode
+constexpr std::array<hal::byte, 1> f_data_address{ out_p_msb_r };
+}  // namespace
+
+fifo_drain::fifo_drain(mpl3115a2& p_device, async_i2c& p_bus)
+  : m_device(&p_device)
+  , m_bus(&p_bus)
+{
+}
+
+hal::status fifo_drain::start(std::span<mpl3115a2::raw_sample_t> p_samples,
+                              hal::callback<completion_handler> p_on_complete)
+{
+  if (!m_device->fifo_enabled()) {
+    return hal::new_error(std::errc::operation_not_permitted);
+  }
+  if (m_busy.exchange(true, std::memory_order_acq_rel)) {
+    return hal::new_error(std::errc::device_or_resource_busy);
+  }
+
+  m_samples = p_samples;
+  m_on_complete = std::move(p_on_complete);
+
+  auto started = m_bus->transaction(
+    device_address, f_status_address, m_status, [this](hal::status p_status) {
+      on_status(p_status);
+    });
+  if (!started) {
+    m_busy.store(false, std::memory_order_release);
+  }
+
+  return started;
+}
+
+bool fifo_drain::busy() const
+{
+  return m_busy.load(std::memory_order_acquire);
+}
+
+void fifo_drain::on_status(hal::status p_status)
+{
+  auto read_data = [this, &p_status]() -> hal::status {
+    HAL_CHECK(p_status);
+
+    auto status = decode_fifo_status(m_status[0], m_samples.size());
+    m_count = status.count;
+    m_overflow = status.overflow;
+
+    if (m_count == 0) {
+      finish(mpl3115a2::fifo_read_t{ .samples = m_samples.first(0),
+                                     .overflow = m_overflow });
+      return hal::success();
+    }
+
+    // Every sample is drained in one burst
+    auto data =
+      std::span(m_data).first(m_count * mpl3115a2::fifo_sample_size);
+    return m_bus->transaction(
+      device_address, f_data_address, data, [this](hal::status p_data) {
+        on_data(p_data);
+      });
+  };
+
+  auto started = read_data();
+  if (!started) {
+    finish(started.error());
+  }
+}
+
+void fifo_drain::on_data(hal::status p_status)
+{
+  if (!p_status) {
+    finish(p_status.error());
+    return;
+  }
+
+  decode_fifo_data(m_data, m_samples.first(m_count));
+
+  finish(mpl3115a2::fifo_read_t{ .samples = m_samples.first(m_count),
+                                 .overflow = m_overflow });
+}
+
+void fifo_drain::finish(hal::result<mpl3115a2::fifo_read_t> p_read)
+{
+  // Release the drain first so the handler can start the next one
+  auto on_complete = std::move(m_on_complete);
+  m_busy.store(false, std::memory_order_release);
+  on_complete(std::move(p_read));
+}
+}  // namespace hal::mpl
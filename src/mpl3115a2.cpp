@@ -1,14 +1,32 @@
 #include <libhal-mpl/mpl3115a2.hpp>
 
+#include <algorithm>
 #include <array>
+#include <chrono>
+#include <type_traits>
+#include <utility>
 
+#include <libhal-mpl/configuration.hpp>
+#include <libhal-mpl/conversion.hpp>
+#include <libhal-mpl/hot_path.hpp>
 #include <libhal-util/i2c.hpp>
 
+#include "fifo_decode.hpp"
 #include "mpl3115a2_reg.hpp"
 
 using namespace std::literals;
 namespace hal::mpl {
+static_assert(hot_path::detail::device_address == device_address);
+static_assert(hot_path::detail::status_r == status_r);
+static_assert(hot_path::detail::out_p_msb_r == out_p_msb_r);
+static_assert(hot_path::detail::status_pdr == status_pdr);
+static_assert(std::is_trivially_copyable_v<mpl3115a2::snapshot_t>,
+              "Snapshots are kept as bytes in retained memory");
+
 namespace {
+/// Policy of a driver without a wait policy or conversion wait, stateless
+polling::immediate no_wait;
+
 /**
  * @brief Set the ctrl_reg1_alt bit in ctrl_reg1 to the value corresponding to
  * 'mode'
@@ -42,6 +60,53 @@ hal::status set_mode(hal::i2c* p_i2c, mpl3115a2::mode p_mode)
   return hal::success();
 }
 
+/**
+ * @brief Switch the mode of a device converting in active mode
+ *
+ * ALT may only change in standby, so the device is put in standby, the sample
+ * of the previous mode is discarded and the device is made active again in
+ * the new mode.
+ *
+ * @param p_i2c The I2C peripheral used for communication with the device.
+ * @param p_mode: The desired operation mode
+ */
+hal::status set_active_mode(hal::i2c* p_i2c, mpl3115a2::mode p_mode)
+{
+  auto ctrl_buffer =
+    HAL_CHECK(hal::write_then_read<1>(*p_i2c,
+                                      device_address,
+                                      std::array<hal::byte, 1>{ ctrl_reg1 },
+                                      hal::never_timeout()));
+  hal::byte standby = ctrl_buffer[0] & ~(ctrl_reg1_sbyb | ctrl_reg1_ost);
+
+  HAL_CHECK(hal::write(*p_i2c,
+                       device_address,
+                       std::array<hal::byte, 2>{ ctrl_reg1, standby },
+                       hal::never_timeout()));
+
+  // Reading the output registers clears their data ready flags, so the next
+  // sample read waits for a conversion in the new mode
+  HAL_CHECK(hal::write_then_read<out_t_lsb_r - out_p_msb_r + 1>(
+    *p_i2c,
+    device_address,
+    std::array<hal::byte, 1>{ out_p_msb_r },
+    hal::never_timeout()));
+
+  hal::byte active = standby | ctrl_reg1_sbyb;
+  if (p_mode == mpl3115a2::mode::barometer) {
+    active &= ~ctrl_reg1_alt;
+  } else {
+    active |= ctrl_reg1_alt;
+  }
+
+  HAL_CHECK(hal::write(*p_i2c,
+                       device_address,
+                       std::array<hal::byte, 2>{ ctrl_reg1, active },
+                       hal::never_timeout()));
+
+  return hal::success();
+}
+
 struct modify_reg_param_t
 {
   hal::byte address;
@@ -77,8 +142,9 @@ hal::status modify_reg_bits(hal::i2c* p_i2c, modify_reg_param_t p_reg)
 * @brief Wait for the reset bit in ctrl_reg1 to be set.
          Catches and ignores expected std::errc::no_such_device_or_address.
 * @param p_i2c The I2C peripheral used for communication with the device.
+* @param p_policy Decides how to wait between checks
 */
-hal::status poll_reset(hal::i2c* p_i2c)
+hal::status poll_reset(hal::i2c* p_i2c, wait_policy& p_policy)
 {
   bool flag_set = true;
   uint16_t retries = 0;
@@ -105,11 +171,19 @@ hal::status poll_reset(hal::i2c* p_i2c)
   };
 
   // Perform polling
+  p_policy.start(hal::time_duration{});
   while (flag_set && (retries < mpl3115a2::default_max_polling_retries)) {
+    if (retries != 0) {
+      p_policy.wait(retries);
+    }
     HAL_CHECK(hal::attempt(poll_function, err_handler));
     retries++;
   }
 
+  if (flag_set) {
+    return hal::new_error(std::errc::timed_out);
+  }
+
   return hal::success();
 }
 
@@ -122,22 +196,32 @@ struct poll_flag_param_t
   hal::byte flag;
   /// The state of the bit to finish polling
   bool desired_state;
+  /// Time the flag is expected to take to reach the desired state
+  hal::time_duration expected{};
 };
 
 /**
  * @brief Wait for a specified flag bit in a register to be set to the desired
  * state.
  * @param p_i2c The I2C peripheral used for communication with the device.
- * reached, the function will exit.
+ * @param p_policy Decides how to wait between checks
+ * @return std::errc::timed_out if the flag did not reach the desired state
+ * within default_max_polling_retries reads.
  */
-hal::status poll_flag(hal::i2c* p_i2c, poll_flag_param_t p_poll)
+hal::status poll_flag(hal::i2c* p_i2c,
+                      wait_policy& p_policy,
+                      poll_flag_param_t p_poll)
 {
   std::array<hal::byte, 1> status_payload{ p_poll.address };
   std::array<hal::byte, 1> status_buffer{};
   uint16_t retries = 0;
   bool flag_set = true;
 
+  p_policy.start(p_poll.expected);
   while (flag_set && (retries < mpl3115a2::default_max_polling_retries)) {
+    if (retries != 0) {
+      p_policy.wait(retries);
+    }
     HAL_CHECK(hal::write_then_read(*p_i2c,
                                    device_address,
                                    status_payload,
@@ -152,6 +236,10 @@ hal::status poll_flag(hal::i2c* p_i2c, poll_flag_param_t p_poll)
     retries++;
   }
 
+  if (flag_set) {
+    return hal::new_error(std::errc::timed_out);
+  }
+
   return hal::success();
 }
 
@@ -159,13 +247,15 @@ hal::status poll_flag(hal::i2c* p_i2c, poll_flag_param_t p_poll)
  * @brief Trigger one-shot measurement by setting ctrl_reg1_ost bit in
  * ctrl_reg1.
  * @param p_i2c The I2C peripheral used for communication with the device.
+ * @param p_policy Decides how to wait for a previous one-shot to complete
  */
-hal::status initiate_one_shot(hal::i2c* p_i2c)
+hal::status initiate_one_shot(hal::i2c* p_i2c, wait_policy& p_policy)
 {
   // Wait for one-shot flag to clear
-  poll_flag(
+  HAL_CHECK(poll_flag(
     p_i2c,
-    { .address = ctrl_reg1, .flag = ctrl_reg1_ost, .desired_state = false });
+    p_policy,
+    { .address = ctrl_reg1, .flag = ctrl_reg1_ost, .desired_state = false }));
 
   // Set ost bit in ctrl_reg1 - initiate one shot measurement
   HAL_CHECK(modify_reg_bits(
@@ -173,6 +263,78 @@ hal::status initiate_one_shot(hal::i2c* p_i2c)
 
   return hal::success();
 }
+
+/**
+ * @brief Write a configuration's register image with the device held in
+ * standby until every register has been written. The device must be in
+ * standby when called.
+ * @param p_i2c The I2C peripheral used for communication with the device.
+ * @param p_config The configuration to apply
+ * @param p_after_reset Skip registers that are already at their reset value
+ * @param p_previous_f_setup F_SETUP as currently configured
+ */
+hal::status write_configuration(hal::i2c* p_i2c,
+                                const configuration& p_config,
+                                bool p_after_reset,
+                                hal::byte p_previous_f_setup)
+{
+  // Control register fields other than SBYB and OST may only be changed in
+  // standby, which the device is already in
+  hal::byte standby_ctrl_reg1 = p_config.ctrl_reg1 & ~ctrl_reg1_sbyb;
+  if (!p_after_reset || standby_ctrl_reg1 != 0) {
+    HAL_CHECK(
+      hal::write(*p_i2c,
+                 device_address,
+                 std::array<hal::byte, 2>{ ctrl_reg1, standby_ctrl_reg1 },
+                 hal::never_timeout()));
+  }
+
+  hal::byte previous_fifo_mode = p_previous_f_setup & f_setup_f_mode_mask;
+  hal::byte fifo_mode = p_config.f_setup & f_setup_f_mode_mask;
+  if (previous_fifo_mode != 0 && fifo_mode != 0 &&
+      previous_fifo_mode != fifo_mode) {
+    // Circular and stop mode cannot be switched directly
+    std::array<hal::byte, 2> disable_payload{ f_setup_r, 0 };
+    HAL_CHECK(hal::write(
+      *p_i2c, device_address, disable_payload, hal::never_timeout()));
+  }
+
+  if (!p_after_reset || p_config.f_setup != 0) {
+    std::array<hal::byte, 2> fifo_payload{ f_setup_r, p_config.f_setup };
+    HAL_CHECK(
+      hal::write(*p_i2c, device_address, fifo_payload, hal::never_timeout()));
+  }
+
+  if (!p_after_reset || p_config.pt_data_cfg != 0) {
+    std::array<hal::byte, 2> dr_payload{ pt_data_cfg_r, p_config.pt_data_cfg };
+    HAL_CHECK(
+      hal::write(*p_i2c, device_address, dr_payload, hal::never_timeout()));
+  }
+
+  // CTRL_REG2 through CTRL_REG5 are contiguous, write them in one burst
+  std::array<hal::byte, 5> control_payload{
+    ctrl_reg2,          p_config.ctrl_reg2, p_config.ctrl_reg3,
+    p_config.ctrl_reg4, p_config.ctrl_reg5,
+  };
+  bool control_at_reset = p_config.ctrl_reg2 == 0 &&
+                          p_config.ctrl_reg3 == 0 &&
+                          p_config.ctrl_reg4 == 0 && p_config.ctrl_reg5 == 0;
+  if (!p_after_reset || !control_at_reset) {
+    HAL_CHECK(hal::write(
+      *p_i2c, device_address, control_payload, hal::never_timeout()));
+  }
+
+  // Enter active mode last, once the device is fully configured
+  if (p_config.ctrl_reg1 & ctrl_reg1_sbyb) {
+    HAL_CHECK(
+      hal::write(*p_i2c,
+                 device_address,
+                 std::array<hal::byte, 2>{ ctrl_reg1, p_config.ctrl_reg1 },
+                 hal::never_timeout()));
+  }
+
+  return hal::success();
+}
 }  // namespace
 
 mpl3115a2::mpl3115a2(hal::i2c& p_i2c)
@@ -182,12 +344,33 @@ mpl3115a2::mpl3115a2(hal::i2c& p_i2c)
 }
 
 result<mpl3115a2> mpl3115a2::create(hal::i2c& p_i2c)
+{
+  return create(p_i2c, default_configuration);
+}
+
+result<mpl3115a2> mpl3115a2::create(hal::i2c& p_i2c,
+                                    const configuration& p_configuration)
 {
   mpl3115a2 mpl_dev(p_i2c);
+  HAL_CHECK(mpl_dev.initialize(p_configuration));
+  return mpl_dev;
+}
+
+result<mpl3115a2> mpl3115a2::create(hal::i2c& p_i2c,
+                                    const configuration& p_configuration,
+                                    wait_policy& p_policy)
+{
+  mpl3115a2 mpl_dev(p_i2c);
+  mpl_dev.set_wait_policy(p_policy);
+  HAL_CHECK(mpl_dev.initialize(p_configuration));
+  return mpl_dev;
+}
 
+hal::status mpl3115a2::initialize(const configuration& p_configuration)
+{
   // sanity check
   auto whoami_buffer =
-    HAL_CHECK(hal::write_then_read<1>(p_i2c,
+    HAL_CHECK(hal::write_then_read<1>(*m_i2c,
                                       device_address,
                                       std::array<hal::byte, 1>{ whoami_r },
                                       hal::never_timeout()));
@@ -197,24 +380,233 @@ result<mpl3115a2> mpl3115a2::create(hal::i2c& p_i2c)
   }
 
   // software reset
-  modify_reg_bits(&p_i2c,
-                  { .address = ctrl_reg1, .bits_to_set = ctrl_reg1_rst });
+  HAL_CHECK(modify_reg_bits(
+    m_i2c, { .address = ctrl_reg1, .bits_to_set = ctrl_reg1_rst }));
+
+  HAL_CHECK(poll_reset(m_i2c, policy()));
+
+  HAL_CHECK(write_configuration(m_i2c, p_configuration, true, 0));
+  track_configuration(p_configuration);
+
+  return hal::success();
+}
+
+result<mpl3115a2> mpl3115a2::resume(hal::i2c& p_i2c,
+                                    const snapshot_t& p_snapshot,
+                                    resume_check p_check)
+{
+  if (p_snapshot.version != snapshot_version) {
+    return hal::new_error(std::errc::invalid_argument);
+  }
+
+  if (p_check == resume_check::registers) {
+    // PT_DATA_CFG through OFF_H are contiguous, read them in one burst. The
+    // thresholds, windows and captured minimum and maximum in between are
+    // skipped, the driver does not write them.
+    constexpr std::size_t span = off_h_r - pt_data_cfg_r + 1;
+    auto registers =
+      HAL_CHECK(hal::write_then_read<span>(p_i2c,
+                                           device_address,
+                                           std::array{ pt_data_cfg_r },
+                                           hal::never_timeout()));
+    auto at = [&registers](hal::byte p_register) {
+      return registers[p_register - pt_data_cfg_r];
+    };
+    auto matches = [&registers](hal::byte p_first,
+                                std::span<const hal::byte> p_bytes) {
+      auto first = registers.begin() + (p_first - pt_data_cfg_r);
+      return std::equal(p_bytes.begin(), p_bytes.end(), first);
+    };
+
+    // OST stays set until a pending one-shot conversion completes
+    auto control = p_snapshot.control;
+    control[0] |= at(ctrl_reg1) & ctrl_reg1_ost;
+
+    if (at(pt_data_cfg_r) != p_snapshot.pt_data_cfg ||
+        !matches(bar_in_msb_r, p_snapshot.bar_in) ||
+        !matches(p_tgt_msb_r, p_snapshot.p_tgt) ||
+        !matches(ctrl_reg1, control) || !matches(off_p_r, p_snapshot.offsets)) {
+      return hal::new_error(std::errc::state_not_recoverable);
+    }
+
+    // F_SETUP sits before INT_SOURCE, which must not be read here. A reset
+    // device reads it as 0, so only FIFO acquisition needs the extra read.
+    if (p_snapshot.f_setup != 0) {
+      auto fifo_setup =
+        HAL_CHECK(hal::write_then_read<1>(p_i2c,
+                                          device_address,
+                                          std::array{ f_setup_r },
+                                          hal::never_timeout()));
+      if (fifo_setup[0] != p_snapshot.f_setup) {
+        return hal::new_error(std::errc::state_not_recoverable);
+      }
+    }
+  }
+
+  const hal::byte ctrl = p_snapshot.control[0];
+  mpl3115a2 mpl_dev(p_i2c);
+  mpl_dev.m_f_setup = p_snapshot.f_setup;
+  mpl_dev.m_pt_data_cfg = p_snapshot.pt_data_cfg;
+  mpl_dev.m_bar_in = p_snapshot.bar_in;
+  mpl_dev.m_p_tgt = p_snapshot.p_tgt;
+  mpl_dev.m_control = p_snapshot.control;
+  mpl_dev.m_offsets = p_snapshot.offsets;
+  mpl_dev.m_sensor_mode =
+    (ctrl & ctrl_reg1_alt) ? mode::altimeter : mode::barometer;
+  mpl_dev.m_continuous = (ctrl & ctrl_reg1_sbyb) != 0;
+  mpl_dev.m_fifo = (p_snapshot.flags & snapshot_fifo) != 0;
+  mpl_dev.m_one_shot_pending =
+    (p_snapshot.flags & snapshot_one_shot_pending) != 0;
+  mpl_dev.m_conversion_time =
+    std::chrono::milliseconds(p_snapshot.conversion_time_ms);
+
+  return mpl_dev;
+}
 
-  poll_reset(&p_i2c);
+mpl3115a2::snapshot_t mpl3115a2::snapshot() const
+{
+  auto control = m_control;
+  control[0] = current_ctrl_reg1();
 
-  // set oversampling ratio to 2^128 and set altitude mode
-  modify_reg_bits(
-    &p_i2c,
-    { .address = ctrl_reg1, .bits_to_set = ctrl_reg1_os128 | ctrl_reg1_alt });
+  std::uint8_t flags = 0;
+  if (m_fifo) {
+    flags |= snapshot_fifo;
+  }
+  if (m_one_shot_pending) {
+    flags |= snapshot_one_shot_pending;
+  }
 
-  // enable data ready events for pressure/altitude and temperature
-  std::array<hal::byte, 2> dr_payload{
-    pt_data_cfg_r, pt_data_cfg_tdefe | pt_data_cfg_pdefe | pt_data_cfg_drem
+  return snapshot_t{
+    .version = snapshot_version,
+    .flags = flags,
+    .conversion_time_ms = static_cast<std::uint16_t>(
+      std::chrono::duration_cast<std::chrono::milliseconds>(m_conversion_time)
+        .count()),
+    .f_setup = m_f_setup,
+    .pt_data_cfg = m_pt_data_cfg,
+    .bar_in = m_bar_in,
+    .p_tgt = m_p_tgt,
+    .control = control,
+    .offsets = m_offsets,
   };
+}
+
+hal::byte mpl3115a2::current_ctrl_reg1() const
+{
+  hal::byte ctrl = m_control[0] & ~ctrl_reg1_alt;
+  if (m_sensor_mode == mode::altimeter) {
+    ctrl |= ctrl_reg1_alt;
+  }
+  return ctrl;
+}
+
+hal::status mpl3115a2::enter_standby()
+{
+  if (!m_continuous) {
+    return hal::success();
+  }
+
+  // Only SBYB changes, the other fields follow once the device is in standby
+  hal::byte standby = current_ctrl_reg1() & ~ctrl_reg1_sbyb;
+  HAL_CHECK(hal::write(*m_i2c,
+                       device_address,
+                       std::array<hal::byte, 2>{ ctrl_reg1, standby },
+                       hal::never_timeout()));
+
+  return hal::success();
+}
+
+hal::status mpl3115a2::configure(const configuration& p_configuration)
+{
+  HAL_CHECK(enter_standby());
+  HAL_CHECK(write_configuration(m_i2c, p_configuration, false, m_f_setup));
+  track_configuration(p_configuration);
+
+  return hal::success();
+}
+
+hal::status mpl3115a2::apply(const profile& p_profile)
+{
+  if (m_fifo) {
+    return hal::new_error(std::errc::operation_not_permitted);
+  }
+
+  // The block changes CTRL_REG1 fields, which an active device only accepts
+  // after it has been put in standby on its own
+  HAL_CHECK(enter_standby());
+
+  std::array<hal::byte, 6> control_payload{ ctrl_reg1 };
+  std::copy(p_profile.control_block.begin(),
+            p_profile.control_block.end(),
+            control_payload.begin() + 1);
   HAL_CHECK(
-    hal::write(p_i2c, device_address, dr_payload, hal::never_timeout()));
+    hal::write(*m_i2c, device_address, control_payload, hal::never_timeout()));
+
+  // Enter active mode last, once the device is fully configured
+  const auto& config = p_profile.config;
+  if (config.ctrl_reg1 & ctrl_reg1_sbyb) {
+    HAL_CHECK(
+      hal::write(*m_i2c,
+                 device_address,
+                 std::array<hal::byte, 2>{ ctrl_reg1, config.ctrl_reg1 },
+                 hal::never_timeout()));
+  }
 
-  return mpl_dev;
+  // F_SETUP and PT_DATA_CFG are not part of the profile's writes
+  track_control(config);
+  m_one_shot_pending = false;
+
+  return hal::success();
+}
+
+void mpl3115a2::track_configuration(const configuration& p_configuration)
+{
+  track_control(p_configuration);
+  m_fifo = p_configuration.f_setup != 0;
+  m_f_setup = p_configuration.f_setup;
+  m_pt_data_cfg = p_configuration.pt_data_cfg;
+}
+
+void mpl3115a2::track_control(const configuration& p_configuration)
+{
+  m_sensor_mode = (p_configuration.ctrl_reg1 & ctrl_reg1_alt)
+                    ? mode::altimeter
+                    : mode::barometer;
+  m_continuous = (p_configuration.ctrl_reg1 & ctrl_reg1_sbyb) != 0;
+  m_conversion_time = p_configuration.conversion_time;
+  m_control = {
+    static_cast<hal::byte>(p_configuration.ctrl_reg1 &
+                           ~(ctrl_reg1_ost | ctrl_reg1_rst)),
+    p_configuration.ctrl_reg2,
+    p_configuration.ctrl_reg3,
+    p_configuration.ctrl_reg4,
+    p_configuration.ctrl_reg5,
+  };
+}
+
+void mpl3115a2::on_conversion_wait(hal::callback<sleep_function> p_sleep)
+{
+  m_conversion_wait.reset();
+  if (p_sleep) {
+    m_conversion_wait.emplace(std::move(p_sleep));
+  }
+  m_wait_policy = nullptr;
+}
+
+void mpl3115a2::set_wait_policy(wait_policy& p_policy)
+{
+  m_wait_policy = &p_policy;
+}
+
+wait_policy& mpl3115a2::policy()
+{
+  if (m_wait_policy) {
+    return *m_wait_policy;
+  }
+  if (m_conversion_wait) {
+    return *m_conversion_wait;
+  }
+  return no_wait;
 }
 
 hal::status mpl3115a2::set_sea_pressure(float p_sea_level_pressure)
@@ -233,6 +625,24 @@ hal::status mpl3115a2::set_sea_pressure(float p_sea_level_pressure)
 
   HAL_CHECK(
     hal::write(*m_i2c, device_address, slp_payload, hal::never_timeout()));
+  m_bar_in = { two_pa_hi, two_pa_lo };
+
+  return hal::success();
+}
+
+hal::status mpl3115a2::set_pressure_target(float p_target)
+{
+  // divide by 2 to convert to 2Pa per LSB
+  auto two_pa = static_cast<std::uint16_t>(p_target / 2.0f);
+  std::array<hal::byte, 3> target_payload = {
+    p_tgt_msb_r,
+    static_cast<hal::byte>(two_pa >> 8),  // msb
+    static_cast<hal::byte>(two_pa),       // lsb
+  };
+
+  HAL_CHECK(
+    hal::write(*m_i2c, device_address, target_payload, hal::never_timeout()));
+  m_p_tgt = { target_payload[1], target_payload[2] };
 
   return hal::success();
 }
@@ -242,18 +652,179 @@ hal::status mpl3115a2::set_altitude_offset(int8_t p_offset)
   std::array<hal::byte, 2> offset_payload = { off_h_r, hal::byte(p_offset) };
   HAL_CHECK(
     hal::write(*m_i2c, device_address, offset_payload, hal::never_timeout()));
+  m_offsets[2] = offset_payload[1];
 
   return hal::success();
 }
 
-hal::result<mpl3115a2::temperature_read_t> mpl3115a2::read_temperature()
+hal::status mpl3115a2::configure_interrupts(
+  const interrupt_settings& p_settings)
+{
+  hal::byte pin_config = 0;
+  if (p_settings.int1.active_high) {
+    pin_config |= ctrl_reg3_ipol1;
+  }
+  if (p_settings.int1.open_drain) {
+    pin_config |= ctrl_reg3_pp_od1;
+  }
+  if (p_settings.int2.active_high) {
+    pin_config |= ctrl_reg3_ipol2;
+  }
+  if (p_settings.int2.open_drain) {
+    pin_config |= ctrl_reg3_pp_od2;
+  }
+
+  // CTRL_REG3, CTRL_REG4 and CTRL_REG5 are contiguous so the register address
+  // auto-increments through all three within one transaction.
+  std::array<hal::byte, 4> interrupt_payload = {
+    ctrl_reg3,
+    pin_config,
+    p_settings.enabled,
+    static_cast<hal::byte>(p_settings.route_to_int1 & p_settings.enabled),
+  };
+  HAL_CHECK(hal::write(
+    *m_i2c, device_address, interrupt_payload, hal::never_timeout()));
+  std::copy(interrupt_payload.begin() + 1,
+            interrupt_payload.end(),
+            m_control.begin() + 2);
+
+  return hal::success();
+}
+
+hal::result<hal::byte> mpl3115a2::read_interrupt_source()
+{
+  auto source_buffer =
+    HAL_CHECK(hal::write_then_read<1>(*m_i2c,
+                                      device_address,
+                                      std::array<hal::byte, 1>{ int_source_r },
+                                      hal::never_timeout()));
+  return source_buffer[0];
+}
+
+hal::result<mpl3115a2::fifo_read_t> mpl3115a2::read_fifo(
+  std::span<raw_sample_t> p_samples)
+{
+  if (!m_fifo) {
+    return hal::new_error(std::errc::operation_not_permitted);
+  }
+
+  // status_r aliases F_STATUS in FIFO mode
+  auto status_buffer =
+    HAL_CHECK(hal::write_then_read<1>(*m_i2c,
+                                      device_address,
+                                      std::array<hal::byte, 1>{ status_r },
+                                      hal::never_timeout()));
+  auto [count, overflow] =
+    decode_fifo_status(status_buffer[0], p_samples.size());
+
+  if (count == 0) {
+    return fifo_read_t{ .samples = p_samples.first(0), .overflow = overflow };
+  }
+
+  // out_p_msb_r aliases F_DATA in FIFO mode, every sample is drained in one
+  // burst.
+  std::array<hal::byte, fifo_capacity * fifo_sample_size> fifo_buffer{};
+  auto fifo_bytes = std::span(fifo_buffer).first(count * fifo_sample_size);
+  HAL_CHECK(hal::write_then_read(*m_i2c,
+                                 device_address,
+                                 std::array<hal::byte, 1>{ out_p_msb_r },
+                                 fifo_bytes,
+                                 hal::never_timeout()));
+
+  decode_fifo_data(fifo_bytes, p_samples.first(count));
+
+  return fifo_read_t{ .samples = p_samples.first(count), .overflow = overflow };
+}
+
+bool mpl3115a2::fifo_enabled() const
+{
+  return m_fifo;
+}
+
+hal::status mpl3115a2::begin_conversion(mode p_mode)
+{
+  if (m_fifo) {
+    // OUT_P/OUT_T alias the FIFO in this mode
+    return hal::new_error(std::errc::operation_not_permitted);
+  }
+
+  if (m_sensor_mode != p_mode) {
+    if (m_continuous) {
+      HAL_CHECK(set_active_mode(m_i2c, p_mode));
+    } else {
+      HAL_CHECK(set_mode(m_i2c, p_mode));
+    }
+    m_sensor_mode = p_mode;
+  }
+
+  if (m_continuous) {
+    // Conversions happen every time step, only wait for the next one
+    return hal::success();
+  }
+  HAL_CHECK(initiate_one_shot(m_i2c, policy()));
+  m_one_shot_pending = true;
+
+  return hal::success();
+}
+
+hal::status mpl3115a2::wait_for_conversion(hal::byte p_flag)
+{
+  // The time to the next sample is only known for a triggered conversion
+  hal::time_duration expected{};
+  if (m_one_shot_pending) {
+    expected = m_conversion_time;
+  }
+  m_one_shot_pending = false;
+
+  return poll_flag(m_i2c,
+                   policy(),
+                   { .address = status_r,
+                     .flag = p_flag,
+                     .desired_state = true,
+                     .expected = expected });
+}
+
+hal::status mpl3115a2::trigger_conversion(mode p_mode)
+{
+  return begin_conversion(p_mode);
+}
+
+hal::result<mpl3115a2::raw_sample_t> mpl3115a2::read_sample()
+{
+  HAL_CHECK(wait_for_conversion(status_pdr));
+  return read_output_sample();
+}
+
+hal::result<std::optional<mpl3115a2::raw_sample_t>>
+mpl3115a2::try_read_sample()
 {
-  constexpr float temp_conversion_factor = 256.0f;
+  if (m_fifo) {
+    // status_r aliases F_STATUS in this mode
+    return hal::new_error(std::errc::operation_not_permitted);
+  }
 
-  initiate_one_shot(m_i2c);
+  auto sample = HAL_CHECK(hot_path::try_read(*m_i2c));
+  if (sample) {
+    m_one_shot_pending = false;
+  }
+  return sample;
+}
 
-  poll_flag(m_i2c,
-            { .address = status_r, .flag = status_tdr, .desired_state = true });
+hal::time_duration mpl3115a2::conversion_time() const
+{
+  return m_conversion_time;
+}
+
+hal::result<mpl3115a2::raw_sample_t> mpl3115a2::read_output_sample()
+{
+  return hot_path::read_output(*m_i2c);
+}
+
+hal::result<mpl3115a2::temperature_read_t> mpl3115a2::read_temperature()
+{
+  HAL_CHECK(begin_conversion(m_sensor_mode));
+
+  HAL_CHECK(wait_for_conversion(status_tdr));
 
   // Read data from out_t_msb_r and out_t_lsb_r
   auto temp_buffer =
@@ -262,26 +833,16 @@ hal::result<mpl3115a2::temperature_read_t> mpl3115a2::read_temperature()
                                       std::array<hal::byte, 1>{ out_t_msb_r },
                                       hal::never_timeout()));
 
-  auto temp_reading = (temp_buffer[0] << 8) | temp_buffer[1];
   return mpl3115a2::temperature_read_t{
-    static_cast<float>(temp_reading) / temp_conversion_factor,
+    to_celsius(to_raw_temperature(temp_buffer[0], temp_buffer[1])),
   };
 }
 
 hal::result<mpl3115a2::pressure_read_t> mpl3115a2::read_pressure()
 {
-  // Note: 64 -> Pa, 6400 -> kPa
-  constexpr float pressure_conversion_factor = 64.0f;
-
-  if (m_sensor_mode != mode::barometer) {
-    set_mode(m_i2c, mode::barometer);
-    m_sensor_mode = mode::barometer;
-  }
+  HAL_CHECK(begin_conversion(mode::barometer));
 
-  initiate_one_shot(m_i2c);
-
-  poll_flag(m_i2c,
-            { .address = status_r, .flag = status_pdr, .desired_state = true });
+  HAL_CHECK(wait_for_conversion(status_pdr));
 
   // Read data from out_p_msb_r, out_p_csb_r, and out_p_lsb_r
   auto pres_buffer =
@@ -290,28 +851,16 @@ hal::result<mpl3115a2::pressure_read_t> mpl3115a2::read_pressure()
                                       std::array<hal::byte, 1>{ out_p_msb_r },
                                       hal::never_timeout()));
 
-  uint32_t pressure_reading = uint32_t(pres_buffer[0]) << 16 |
-                              uint32_t(pres_buffer[1]) << 8 |
-                              uint32_t(pres_buffer[2]);
-
   return mpl3115a2::pressure_read_t{
-    static_cast<float>(pressure_reading) / pressure_conversion_factor,
+    to_pascals(to_raw_pressure(pres_buffer[0], pres_buffer[1], pres_buffer[2])),
   };
 }
 
 hal::result<mpl3115a2::altitude_read_t> mpl3115a2::read_altitude()
 {
-  constexpr float altitude_conversion_factor = 65536.0f;
-
-  if (m_sensor_mode != mode::altimeter) {
-    set_mode(m_i2c, mode::altimeter);
-    m_sensor_mode = mode::altimeter;
-  }
-
-  initiate_one_shot(m_i2c);
+  HAL_CHECK(begin_conversion(mode::altimeter));
 
-  poll_flag(m_i2c,
-            { .address = status_r, .flag = status_pdr, .desired_state = true });
+  HAL_CHECK(wait_for_conversion(status_pdr));
 
   // Read data from out_p_msb_r, out_p_csb_r, and out_p_lsb_r
   auto alt_buffer =
@@ -320,12 +869,8 @@ hal::result<mpl3115a2::altitude_read_t> mpl3115a2::read_altitude()
                                       std::array<hal::byte, 1>{ out_p_msb_r },
                                       hal::never_timeout()));
 
-  int32_t alt_reading = int32_t(alt_buffer[0]) << 24 |
-                        int32_t(alt_buffer[1]) << 16 |
-                        int32_t(alt_buffer[2]) << 8;
-
   return mpl3115a2::altitude_read_t{
-    static_cast<float>(alt_reading) / altitude_conversion_factor,
+    to_meters(to_raw_pressure(alt_buffer[0], alt_buffer[1], alt_buffer[2])),
   };
 }
 
@@ -12,18 +12,23 @@
 
 #pragma once
 
+#include <cstddef>
+
+#include <libhal-mpl/hot_path.hpp>
 #include <libhal/units.hpp>
 
+// The registers read by the header-only sample path are defined in
+// hot_path.hpp and brought in with using-declarations
 namespace hal::mpl {
 // default 7-bit I2C device address is 0b110'0000
-static constexpr hal::byte device_address = 0x60;
+using hot_path::detail::device_address;
 
 /** ---------- MPL3115A2 Registers ---------- **/
 // The address of the sensor status register - Alias for dr_status or f_status
-static constexpr hal::byte status_r = 0x00;
+using hot_path::detail::status_r;
 
 // Bits 12-19 of 20-bit real-time Pressure sample register
-static constexpr hal::byte out_p_msb_r = 0x01;
+using hot_path::detail::out_p_msb_r;
 // Bits 4-11 of 20-bit real-time Pressure sample register
 static constexpr hal::byte out_p_csb_r = 0x02;
 // Bits 0-3 of 20-bit real-time Pressure sample register
@@ -37,6 +42,12 @@ static constexpr hal::byte out_t_lsb_r = 0x05;
 // Device identification register. Reset value is 0xC4
 static constexpr hal::byte whoami_r = 0x0C;
 
+// FIFO setup register - FIFO mode and watermark
+static constexpr hal::byte f_setup_r = 0x0F;
+
+// Interrupt source register - which enabled interrupt sources have fired
+static constexpr hal::byte int_source_r = 0x12;
+
 // PT Data Configuration Register - data event flag config
 static constexpr hal::byte pt_data_cfg_r = 0x13;
 
@@ -45,9 +56,26 @@ static constexpr hal::byte bar_in_msb_r = 0x14;
 // Barometric input for Altitude calculation bits 0-7
 static constexpr hal::byte bar_in_lsb_r = 0x15;
 
+// Pressure/Altitude target value bits 8-15
+static constexpr hal::byte p_tgt_msb_r = 0x16;
+// Pressure/Altitude target value bits 0-7
+static constexpr hal::byte p_tgt_lsb_r = 0x17;
+
 // Control Register: Modes & Oversampling
 static constexpr hal::byte ctrl_reg1 = 0x26;
-
+// Control Register: Acquisition time step
+static constexpr hal::byte ctrl_reg2 = 0x27;
+// Control Register: Interrupt pin polarity and output driver
+static constexpr hal::byte ctrl_reg3 = 0x28;
+// Control Register: Interrupt enable
+static constexpr hal::byte ctrl_reg4 = 0x29;
+// Control Register: Interrupt routing, 1 = INT1, 0 = INT2
+static constexpr hal::byte ctrl_reg5 = 0x2A;
+
+// Pressure data user offset register
+static constexpr hal::byte off_p_r = 0x2B;
+// Temperature data user offset register
+static constexpr hal::byte off_t_r = 0x2C;
 // Altitude data user offset register
 static constexpr hal::byte off_h_r = 0x2D;
 
@@ -58,10 +86,26 @@ static constexpr hal::byte off_h_r = 0x2D;
 // Temperature new data ready.
 static constexpr hal::byte status_tdr = 0x02;
 // Pressure/Altitude new data ready
-static constexpr hal::byte status_pdr = 0x04;
+using hot_path::detail::status_pdr;
 // Pressure/Altitude OR Temperature data ready
 static constexpr hal::byte status_ptdr = 0x08;
 
+/** ---------- MPL3115A2 FIFO Status Register Bits ---------- **/
+// In FIFO mode status_r is an alias for F_STATUS and out_p_msb_r is an alias
+// for F_DATA, from which samples are burst read 5 bytes at a time.
+
+// FIFO overflowed, cleared by reading F_STATUS
+static constexpr hal::byte f_status_ovf = 0x80;
+// FIFO sample count reached the watermark
+static constexpr hal::byte f_status_wmrk = 0x40;
+// Number of samples held in the FIFO
+static constexpr hal::byte f_status_cnt_mask = 0x3F;
+
+/** ---------- MPL3115A2 FIFO Setup Register Bits ---------- **/
+// FIFO mode, 0 disables the FIFO. The FIFO must be disabled before changing
+// from one enabled mode to the other.
+static constexpr hal::byte f_setup_f_mode_mask = 0xC0;
+
 /** ---------- MPL3115A2 PT DATA Register Bits ---------- **/
 // These bits must be configured at startup in order to
 // enable the status_x flag functionality
@@ -74,6 +118,8 @@ static constexpr hal::byte pt_data_cfg_pdefe = 0x02;
 static constexpr hal::byte pt_data_cfg_drem = 0x04;
 
 /** ---------- MPL3115A2 Control Register Bits ---------- **/
+// Standby/Active mode bit
+static constexpr hal::byte ctrl_reg1_sbyb = 0x01;
 // Reset bit
 static constexpr hal::byte ctrl_reg1_rst = 0x04;
 // One-Shot trigger bit
@@ -81,6 +127,16 @@ static constexpr hal::byte ctrl_reg1_ost = 0x02;
 // Altimeter-Barometer mode bit
 static constexpr hal::byte ctrl_reg1_alt = 0x80;
 
+/** ---------- MPL3115A2 Control Register 3 Bits ---------- **/
+// INT1 polarity, 1 = active high
+static constexpr hal::byte ctrl_reg3_ipol1 = 0x20;
+// INT1 output driver, 1 = open drain
+static constexpr hal::byte ctrl_reg3_pp_od1 = 0x10;
+// INT2 polarity, 1 = active high
+static constexpr hal::byte ctrl_reg3_ipol2 = 0x02;
+// INT2 output driver, 1 = open drain
+static constexpr hal::byte ctrl_reg3_pp_od2 = 0x01;
+
 /** ---------- mpl Oversample Values ---------- **/
 static constexpr hal::byte ctrl_reg1_os32 = 0x28;
 static constexpr hal::byte ctrl_reg1_os64 = 0x30;
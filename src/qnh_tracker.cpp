@@ -0,0 +1,90 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-mpl/qnh_tracker.hpp>
+
+#include <cmath>
+
+namespace hal::mpl {
+namespace {
+/// International standard atmosphere, as used by the device's altitude
+/// conversion
+constexpr float scale_height = 44330.77f;
+constexpr float exponent = 5.255877f;
+/// BAR_IN resolution in pascals
+constexpr float bar_in_resolution = 2.0f;
+
+/// Ratio of the pressure at p_altitude to the pressure at sea level
+float pressure_ratio(meters p_altitude)
+{
+  return std::pow(1.0f - p_altitude / scale_height, exponent);
+}
+}  // namespace
+
+qnh_tracker::qnh_tracker(mpl3115a2& p_device, settings p_settings)
+  : m_device(&p_device)
+  , m_filter(p_settings.alpha)
+  , m_written(p_settings.sea_pressure)
+{
+}
+
+qnh_tracker::qnh_tracker(mpl3115a2& p_device)
+  : qnh_tracker(p_device, settings{})
+{
+}
+
+hal::status qnh_tracker::update_pressure(float p_pressure, meters p_reference)
+{
+  return update(p_pressure / pressure_ratio(p_reference));
+}
+
+hal::status qnh_tracker::update_altitude(meters p_altitude, meters p_reference)
+{
+  auto pressure = m_written * pressure_ratio(p_altitude);
+  return update(pressure / pressure_ratio(p_reference));
+}
+
+float qnh_tracker::sea_pressure() const
+{
+  return m_filter.value();
+}
+
+float qnh_tracker::written_sea_pressure() const
+{
+  return m_written;
+}
+
+std::uint32_t qnh_tracker::writes() const
+{
+  return m_writes;
+}
+
+hal::status qnh_tracker::update(float p_sea_pressure)
+{
+  auto estimate = m_filter.update(p_sea_pressure);
+
+  // Smaller changes cannot be represented by BAR_IN, and waiting for a
+  // whole step keeps the register from toggling between two values
+  if (std::abs(estimate - m_written) < bar_in_resolution) {
+    return hal::success();
+  }
+
+  HAL_CHECK(m_device->set_sea_pressure(estimate));
+  // BAR_IN truncates to whole 2 Pa steps
+  m_written = std::floor(estimate / bar_in_resolution) * bar_in_resolution;
+  m_writes++;
+
+  return hal::success();
+}
+}  // namespace hal::mpl
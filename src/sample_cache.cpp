@@ -0,0 +1,148 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-mpl/sample_cache.hpp>
+
+#include <chrono>
+
+namespace hal::mpl {
+sample_cache::sample_cache(mpl3115a2& p_device,
+                           hal::steady_clock& p_clock,
+                           hal::time_duration p_max_age,
+                           mpl3115a2::mode p_mode)
+  : m_device(&p_device)
+  , m_clock(&p_clock)
+  , m_mode(p_mode)
+{
+  set_max_age(p_max_age);
+}
+
+hal::result<sample_cache::sample_t> sample_cache::read()
+{
+  auto now = m_clock->uptime().ticks;
+  if (fresh(now)) {
+    m_coalesced++;
+    return *m_sample;
+  }
+
+  if (m_pending && !within_max_age(now, *m_pending)) {
+    // The conversion in progress was triggered too long ago, collect it and
+    // convert a new sample
+    auto stale = m_device->read_sample();
+    m_pending.reset();
+    if (!stale) {
+      return stale.error();
+    }
+  }
+
+  if (m_pending) {
+    // Another reader already triggered the conversion
+    m_coalesced++;
+  } else {
+    HAL_CHECK(start_conversion(now));
+  }
+
+  auto raw = m_device->read_sample();
+  if (!raw) {
+    // The conversion may be lost, e.g. after a brown-out reset, so the next
+    // read triggers a new one
+    m_pending.reset();
+    return raw.error();
+  }
+  m_sample = sample_t{ .raw = *raw, .timestamp = *m_pending };
+  m_pending.reset();
+  return *m_sample;
+}
+
+hal::result<std::optional<sample_cache::sample_t>> sample_cache::try_read()
+{
+  auto now = m_clock->uptime().ticks;
+  if (fresh(now)) {
+    m_coalesced++;
+    return m_sample;
+  }
+
+  if (m_pending && !within_max_age(now, *m_pending)) {
+    // The conversion in progress was triggered too long ago, collect it once
+    // complete and convert a new sample
+    auto stale = m_device->try_read_sample();
+    if (!stale) {
+      m_pending.reset();
+      return stale.error();
+    }
+    if (!*stale) {
+      return std::optional<sample_t>{};
+    }
+    m_pending.reset();
+  }
+
+  if (!m_pending) {
+    HAL_CHECK(start_conversion(now));
+  }
+
+  auto polled = m_device->try_read_sample();
+  if (!polled) {
+    m_pending.reset();
+    return polled.error();
+  }
+  auto raw = *polled;
+  if (!raw) {
+    return std::optional<sample_t>{};
+  }
+  m_sample = sample_t{ .raw = *raw, .timestamp = *m_pending };
+  m_pending.reset();
+  return m_sample;
+}
+
+void sample_cache::invalidate()
+{
+  m_sample.reset();
+}
+
+void sample_cache::set_max_age(hal::time_duration p_max_age)
+{
+  auto frequency = m_clock->frequency().operating_frequency;
+  auto seconds = std::chrono::duration<double>(p_max_age).count();
+  m_max_age_ticks = static_cast<std::uint64_t>(seconds * frequency);
+}
+
+std::uint32_t sample_cache::conversions() const
+{
+  return m_conversions;
+}
+
+std::uint32_t sample_cache::coalesced() const
+{
+  return m_coalesced;
+}
+
+bool sample_cache::fresh(std::uint64_t p_now) const
+{
+  return m_sample.has_value() && within_max_age(p_now, m_sample->timestamp);
+}
+
+bool sample_cache::within_max_age(std::uint64_t p_now,
+                                  std::uint64_t p_timestamp) const
+{
+  return p_now - p_timestamp <= m_max_age_ticks;
+}
+
+hal::status sample_cache::start_conversion(std::uint64_t p_now)
+{
+  HAL_CHECK(m_device->trigger_conversion(m_mode));
+  m_pending = p_now;
+  m_conversions++;
+  return hal::success();
+}
+}  // namespace hal::mpl
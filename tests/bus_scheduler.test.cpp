@@ -0,0 +1,226 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-mpl/bus_scheduler.hpp>
+
+#include <array>
+#include <optional>
+#include <vector>
+
+#include <boost/ut.hpp>
+
+#include "mpl3115a2_simulator.hpp"
+
+namespace hal::mpl {
+namespace {
+constexpr hal::byte imu_address = 0x68;
+
+/// Microsecond clock that only moves when the test advances it
+class manual_clock : public hal::steady_clock
+{
+public:
+  std::uint64_t ticks = 0;
+
+private:
+  frequency_t driver_frequency() override
+  {
+    return frequency_t{ .operating_frequency = 1'000'000.0f };
+  }
+
+  uptime_t driver_uptime() override
+  {
+    return uptime_t{ .ticks = ticks };
+  }
+};
+
+/// Bus that, like a DMA transfer, only completes the transaction on it when
+/// the test calls `complete()`
+class manual_bus : public async_i2c
+{
+public:
+  void complete()
+  {
+    auto on_complete = std::move(m_on_complete);
+    m_on_complete = {};
+    on_complete(hal::success());
+  }
+
+  std::vector<hal::byte> started;
+
+private:
+  hal::status driver_transaction(
+    hal::byte p_address,
+    std::span<const hal::byte>,
+    std::span<hal::byte>,
+    hal::callback<completion_handler> p_on_complete) override
+  {
+    started.push_back(p_address);
+    m_on_complete = std::move(p_on_complete);
+    return hal::success();
+  }
+
+  hal::callback<completion_handler> m_on_complete;
+};
+}  // namespace
+
+void bus_scheduler_test()
+{
+  using namespace boost::ut;
+  using namespace std::literals;
+
+  "hal::mpl::bus_scheduler runs the earliest deadline first"_test = []() {
+    // Setup
+    manual_clock clock;
+    manual_bus bus;
+    bus_scheduler scheduler(bus, clock);
+    bus_scheduler::channel barometer(scheduler, 10ms);
+    bus_scheduler::channel imu(scheduler, 1ms);
+    std::vector<hal::byte> completed;
+    auto record = [&completed](hal::byte p_address) {
+      return [&completed, p_address](hal::status) {
+        completed.push_back(p_address);
+      };
+    };
+
+    // Exercise
+    (void)barometer.transaction(device_address, {}, {}, record(device_address));
+    clock.ticks = 100;
+    (void)imu.transaction(imu_address, {}, {}, record(imu_address));
+    scheduler.run();
+    bus.complete();
+    scheduler.run();
+    bus.complete();
+    auto handlers = scheduler.run();
+
+    // Verify
+    expect(that % 2U == bus.started.size());
+    expect(that % imu_address == bus.started[0]);
+    expect(that % device_address == bus.started[1]);
+    expect(that % 1U == handlers);
+    expect(that % 2U == completed.size());
+    expect(that % imu_address == completed[0]);
+    expect(scheduler.idle());
+    expect(that % 0U == scheduler.statistics().missed);
+  };
+
+  "hal::mpl::bus_scheduler reports missed deadlines"_test = []() {
+    // Setup
+    manual_clock clock;
+    manual_bus bus;
+    bus_scheduler scheduler(bus, clock);
+    bus_scheduler::channel barometer(scheduler, 10ms);
+    bus_scheduler::channel imu(scheduler, 1ms);
+
+    // Exercise
+    // The barometer holds the bus when the IMU job arrives, and is not
+    // preempted
+    (void)barometer.transaction(device_address, {}, {}, [](hal::status) {});
+    scheduler.run();
+    (void)imu.transaction(imu_address, {}, {}, [](hal::status) {});
+    clock.ticks = 1'500;
+    bus.complete();
+    scheduler.run();
+    bus.complete();
+    scheduler.run();
+    auto statistics = scheduler.statistics();
+
+    // Verify
+    expect(that % 2U == statistics.completed);
+    expect(that % 1U == statistics.missed);
+    expect(that % 500U == statistics.max_lateness);
+    expect(that % 1U == imu.missed());
+    expect(that % 0U == barometer.missed());
+    expect(that % 1U == barometer.completed());
+  };
+
+  "hal::mpl::bus_scheduler rejects jobs beyond capacity"_test = []() {
+    // Setup
+    manual_clock clock;
+    manual_bus bus;
+    bus_scheduler scheduler(bus, clock);
+    bus_scheduler::channel imu(scheduler, 1ms);
+    for (std::size_t i = 0; i < bus_scheduler::capacity; i++) {
+      (void)imu.transaction(imu_address, {}, {}, [](hal::status) {});
+    }
+
+    // Exercise
+    auto rejected = imu.transaction(imu_address, {}, {}, [](hal::status) {});
+    scheduler.run();
+    auto accepted = imu.transaction(imu_address, {}, {}, [](hal::status) {});
+
+    // Verify
+    expect(!rejected.has_value());
+    expect(accepted.has_value());
+  };
+
+  "hal::mpl::bus_scheduler::blocking_channel drives the mpl3115a2"_test =
+    []() {
+      // Setup
+      mpl3115a2_simulator simulator;
+      sync_i2c_adapter bus(simulator);
+      manual_clock clock;
+      bus_scheduler scheduler(bus, clock);
+      bus_scheduler::blocking_channel barometer(scheduler, 10ms);
+      bus_scheduler::channel imu(scheduler, 1ms);
+      std::optional<std::uint32_t> barometer_transactions_before_imu;
+      auto device = mpl3115a2::create(barometer).value();
+      (void)device.trigger_conversion(mpl3115a2::mode::barometer);
+      simulator.transactions = 0;
+      auto completed_before = scheduler.statistics().completed;
+
+      // Exercise
+      // Queued before the barometer's reads, and runs first as it is due first.
+      // No IMU is on the simulated bus, so the transaction fails, which does
+      // not matter to the order.
+      (void)imu.transaction(imu_address, {}, {}, [&](hal::status) {
+        barometer_transactions_before_imu = simulator.transactions;
+      });
+      auto sample = device.read_sample();
+
+      // Verify
+      expect(sample.has_value());
+      expect(that % 0x62F350U == sample.value().pressure);
+      expect(barometer_transactions_before_imu == 0U);
+      expect(that % (simulator.transactions + 1) ==
+             scheduler.statistics().completed - completed_before);
+      expect(scheduler.idle());
+    };
+
+  "hal::mpl::bus_scheduler::blocking_channel times out waiting"_test =
+    []() {
+      // Setup
+      manual_clock clock;
+      manual_bus bus;
+      bus_scheduler scheduler(bus, clock);
+      bus_scheduler::channel imu(scheduler, 1ms);
+      bus_scheduler::blocking_channel barometer(scheduler, 10ms);
+      std::array<hal::byte, 1> data{};
+      (void)imu.transaction(imu_address, {}, {}, [](hal::status) {});
+      scheduler.run();
+
+      // Exercise
+      auto outcome = barometer.transaction(
+        device_address, {}, data, []() -> hal::status {
+          return hal::new_error(std::errc::timed_out);
+        });
+      bus.complete();
+      scheduler.run();
+
+      // Verify
+      expect(!outcome.has_value());
+      expect(that % 1U == bus.started.size());
+      expect(scheduler.idle());
+    };
+};
+}  // namespace hal::mpl
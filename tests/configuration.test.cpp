@@ -0,0 +1,256 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-mpl/configuration.hpp>
+
+#include <libhal-mpl/conversion.hpp>
+
+#include <boost/ut.hpp>
+
+#include "mpl3115a2_simulator.hpp"
+
+namespace hal::mpl {
+void configuration_test()
+{
+  using namespace boost::ut;
+  using namespace std::chrono_literals;
+
+  "hal::mpl::default_configuration"_test = []() {
+    // Matches the configuration create() has always applied
+    static_assert(default_configuration.ctrl_reg1 == 0xB8);
+    static_assert(default_configuration.pt_data_cfg == 0x07);
+    static_assert(default_configuration.ctrl_reg2 == 0x00);
+    static_assert(default_configuration.f_setup == 0x00);
+    static_assert(default_configuration.conversion_time == 512ms);
+    static_assert(default_configuration.sample_period == 0ms);
+  };
+
+  "hal::mpl::make_configuration() derives registers and timing"_test = []() {
+    constexpr auto config = make_configuration<{
+      .mode = mpl3115a2::mode::barometer,
+      .oversampling = oversampling_ratio::os16,
+      .acquire = acquisition::fifo,
+      .sample_period_ms = 4000,
+      .fifo = fifo_mode::stop,
+      .fifo_watermark = 24,
+      .interrupts = {
+        .enabled = mpl3115a2::interrupt::fifo,
+        .route_to_int1 = mpl3115a2::interrupt::fifo,
+        .int1 = { .active_high = true, .open_drain = true },
+      },
+    }>();
+
+    static_assert(config.ctrl_reg1 == 0x21);
+    static_assert(config.ctrl_reg2 == 2);
+    static_assert(config.ctrl_reg3 == 0x30);
+    static_assert(config.ctrl_reg4 == 0x40);
+    static_assert(config.ctrl_reg5 == 0x40);
+    static_assert(config.f_setup == 0x98);
+    static_assert(config.conversion_time == 66ms);
+    static_assert(config.sample_period == 4s);
+  };
+
+  "mpl3115a2::create() with a configuration"_test = []() {
+    // Setup
+    constexpr auto config = make_configuration<{
+      .mode = mpl3115a2::mode::barometer,
+      .oversampling = oversampling_ratio::os2,
+      .acquire = acquisition::continuous,
+    }>();
+    mpl3115a2_simulator simulator;
+    simulator.conversion_reads = 3;
+
+    // Exercise
+    auto device = mpl3115a2::create(simulator, config);
+    simulator.transactions = 0;
+    auto pressure = device.value().read_pressure();
+
+    // Verify
+    expect(that % 0x09 == simulator.registers[ctrl_reg1]);
+    expect(that % 0x07 == simulator.registers[pt_data_cfg_r]);
+    expect(pressure.has_value());
+    // No one-shot trigger in active mode: 3 status polls and the data read
+    expect(that % 4U == simulator.transactions);
+  };
+
+  "mpl3115a2 switches modes in continuous acquisition"_test = []() {
+    // Setup
+    constexpr auto config = make_configuration<{
+      .acquire = acquisition::continuous,
+    }>();
+    mpl3115a2_simulator simulator;
+    auto device = mpl3115a2::create(simulator, config).value();
+    // An altitude sample is ready when the mode switches
+    simulator.conversion_reads = 2;
+    simulator.convert();
+
+    // Exercise
+    auto pressure = device.read_pressure();
+    auto pressure_ctrl_reg1 = simulator.registers[ctrl_reg1];
+    auto altitude = device.read_altitude();
+
+    // Verify
+    expect(that % 0U == simulator.active_control_writes);
+    expect(that % 0x39 == pressure_ctrl_reg1);
+    expect(that % 0xB9 == simulator.registers[ctrl_reg1]);
+    // The sample of the previous mode is discarded
+    expect(that % to_pascals(simulator.pressure) == pressure.value().pressure);
+    expect(that % to_meters(simulator.altitude) == altitude.value().altitude);
+  };
+
+  "mpl3115a2::configure() holds the device in standby"_test = []() {
+    // Setup
+    constexpr auto config = make_configuration<{
+      .acquire = acquisition::fifo,
+      .fifo_watermark = 8,
+    }>();
+    mpl3115a2_simulator simulator;
+    auto device = mpl3115a2::create(simulator).value();
+    simulator.transactions = 0;
+
+    // Exercise
+    auto status = device.configure(config);
+    auto pressure = device.read_pressure();
+
+    // Verify
+    expect(status.has_value());
+    // CTRL_REG1 (standby), F_SETUP, PT_DATA_CFG, CTRL_REG2-5, CTRL_REG1
+    expect(that % 5U == simulator.transactions);
+    expect(that % 0xB9 == simulator.registers[ctrl_reg1]);
+    expect(that % 0x48 == simulator.registers[f_setup_r]);
+    // OUT_P/OUT_T alias the FIFO
+    expect(!pressure.has_value());
+  };
+
+  "mpl3115a2::configure() disables the fifo to change its mode"_test = []() {
+    // Setup
+    constexpr auto circular = make_configuration<{
+      .acquire = acquisition::fifo,
+      .fifo = fifo_mode::circular,
+    }>();
+    constexpr auto stop = make_configuration<{
+      .acquire = acquisition::fifo,
+      .fifo = fifo_mode::stop,
+      .fifo_watermark = 8,
+    }>();
+    mpl3115a2_simulator simulator;
+    auto device = mpl3115a2::create(simulator, circular).value();
+    simulator.transactions = 0;
+
+    // Exercise
+    auto to_stop = device.configure(stop);
+    auto stop_transactions = simulator.transactions;
+    auto stop_f_setup = simulator.registers[f_setup_r];
+    auto to_circular = device.configure(circular);
+
+    // Verify
+    expect(to_stop.has_value());
+    expect(to_circular.has_value());
+    expect(that % 0U == simulator.rejected_fifo_mode_changes);
+    expect(that % 0U == simulator.active_control_writes);
+    // SBYB cleared, CTRL_REG1 (standby), F_SETUP disabled, F_SETUP,
+    // PT_DATA_CFG, CTRL_REG2-5, CTRL_REG1
+    expect(that % 7U == stop_transactions);
+    expect(that % stop.f_setup == stop_f_setup);
+    expect(that % circular.f_setup == simulator.registers[f_setup_r]);
+  };
+
+  "mpl3115a2::apply() switches profiles"_test = []() {
+    // Setup
+    constexpr auto fast = make_profile<{
+      .mode = mpl3115a2::mode::barometer,
+      .oversampling = oversampling_ratio::os2,
+      .acquire = acquisition::continuous,
+      .interrupts = { .enabled = mpl3115a2::interrupt::data_ready },
+    }>();
+    constexpr auto precise = make_profile<{
+      .mode = mpl3115a2::mode::barometer,
+    }>();
+    static_assert(fast.control_block[0] == 0x08);
+    static_assert(fast.config.ctrl_reg1 == 0x09);
+    mpl3115a2_simulator simulator;
+    auto device = mpl3115a2::create(simulator).value();
+
+    // Exercise
+    simulator.transactions = 0;
+    auto to_fast = device.apply(fast);
+    auto fast_transactions = simulator.transactions;
+    auto fast_ctrl_reg1 = simulator.registers[ctrl_reg1];
+    auto fast_ctrl_reg4 = simulator.registers[ctrl_reg4];
+    simulator.transactions = 0;
+    auto to_precise = device.apply(precise);
+    auto precise_transactions = simulator.transactions;
+    auto pressure = device.read_pressure();
+
+    // Verify
+    expect(to_fast.has_value());
+    expect(to_precise.has_value());
+    // Control block burst, then SBYB once the block is in place
+    expect(that % 2U == fast_transactions);
+    expect(that % 0x09 == fast_ctrl_reg1);
+    expect(that % 0x80 == fast_ctrl_reg4);
+    // SBYB cleared on its own, then the control block burst
+    expect(that % 2U == precise_transactions);
+    expect(that % 0x38 == simulator.registers[ctrl_reg1]);
+    expect(that % 0x00 == simulator.registers[ctrl_reg4]);
+    expect(that % 0U == simulator.active_control_writes);
+    expect(that % 512ms == device.conversion_time());
+    expect(pressure.has_value());
+  };
+
+  "mpl3115a2::apply() keeps registers outside the control block"_test = []() {
+    // Setup
+    // Data ready events for pressure only
+    constexpr auto pressure_events = [] {
+      auto config = make_configuration<{}>();
+      config.pt_data_cfg = 0x06;
+      return config;
+    }();
+    constexpr auto fast = make_profile<{
+      .oversampling = oversampling_ratio::os2,
+    }>();
+    mpl3115a2_simulator simulator;
+    auto device = mpl3115a2::create(simulator, pressure_events).value();
+
+    // Exercise
+    auto status = device.apply(fast);
+    auto snapshot = device.snapshot();
+    auto resumed = mpl3115a2::resume(simulator, snapshot);
+
+    // Verify
+    expect(status.has_value());
+    expect(that % 0x06 == simulator.registers[pt_data_cfg_r]);
+    expect(that % 0x06 == snapshot.pt_data_cfg);
+    expect(resumed.has_value());
+  };
+
+  "mpl3115a2::apply() requires leaving fifo acquisition"_test = []() {
+    // Setup
+    constexpr auto config = make_configuration<{
+      .acquire = acquisition::fifo,
+    }>();
+    constexpr auto precise = make_profile<{}>();
+    mpl3115a2_simulator simulator;
+    auto device = mpl3115a2::create(simulator, config).value();
+    simulator.transactions = 0;
+
+    // Exercise
+    auto status = device.apply(precise);
+
+    // Verify
+    expect(!status.has_value());
+    expect(that % 0U == simulator.transactions);
+  };
+};
+}  // namespace hal::mpl
@@ -0,0 +1,75 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-mpl/conversion.hpp>
+#include <libhal-mpl/filter.hpp>
+
+#include <boost/ut.hpp>
+
+namespace hal::mpl {
+void conversion_test()
+{
+  using namespace boost::ut;
+
+  "hal::mpl::to_pascals()"_test = []() {
+    // Setup
+    // 101325.25 Pa -> Q18.2 = 405301, shifted left by 4
+    constexpr auto raw = to_raw_pressure(0x62, 0xF3, 0x50);
+
+    // Exercise
+    constexpr auto pascals = to_pascals(raw);
+
+    // Verify
+    static_assert(raw == 0x62F350);
+    expect(that % 101325.25f == pascals);
+  };
+
+  "hal::mpl::to_meters()"_test = []() {
+    // Setup
+    // +256.5 m and -1.5 m in Q16.4, shifted left by 4
+    constexpr auto positive = to_raw_pressure(0x01, 0x00, 0x80);
+    constexpr auto negative = to_raw_pressure(0xFF, 0xFE, 0x80);
+
+    // Exercise & Verify
+    expect(that % 256.5f == to_meters(positive));
+    expect(that % -1.5f == to_meters(negative));
+  };
+
+  "hal::mpl::to_celsius()"_test = []() {
+    // Setup
+    constexpr auto positive = to_raw_temperature(0x19, 0x40);
+    constexpr auto negative = to_raw_temperature(0xF6, 0xC0);
+
+    // Exercise & Verify
+    expect(that % 25.25f == to_celsius(positive));
+    expect(that % -9.25f == to_celsius(negative));
+  };
+
+  "hal::mpl::low_pass_filter"_test = []() {
+    // Setup
+    low_pass_filter filter(0.5f);
+
+    // Exercise
+    auto first = filter.update(100.0f);
+    auto second = filter.update(200.0f);
+    filter.reset();
+    auto after_reset = filter.update(50.0f);
+
+    // Verify
+    expect(that % 100.0f == first);
+    expect(that % 150.0f == second);
+    expect(that % 50.0f == after_reset);
+  };
+};
+}  // namespace hal::mpl
@@ -0,0 +1,145 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-mpl/differential_pressure.hpp>
+
+#include <boost/ut.hpp>
+
+#include "mpl3115a2_simulator.hpp"
+
+namespace hal::mpl {
+namespace {
+/// Clock that advances one tick every time it is read
+class counting_clock : public hal::steady_clock
+{
+public:
+  std::uint64_t ticks = 1000;
+
+private:
+  frequency_t driver_frequency() override
+  {
+    return frequency_t{ .operating_frequency = 1'000'000.0f };
+  }
+
+  uptime_t driver_uptime() override
+  {
+    return uptime_t{ .ticks = ticks++ };
+  }
+};
+/// Clock that counts the transactions on two buses
+class transaction_clock : public hal::steady_clock
+{
+public:
+  transaction_clock(mpl3115a2_simulator& p_high, mpl3115a2_simulator& p_low)
+    : m_high(&p_high)
+    , m_low(&p_low)
+  {
+  }
+
+private:
+  frequency_t driver_frequency() override
+  {
+    return frequency_t{ .operating_frequency = 1'000'000.0f };
+  }
+
+  uptime_t driver_uptime() override
+  {
+    return uptime_t{ .ticks = m_high->transactions + m_low->transactions };
+  }
+
+  mpl3115a2_simulator* m_high;
+  mpl3115a2_simulator* m_low;
+};
+}  // namespace
+
+void differential_pressure_test()
+{
+  using namespace boost::ut;
+
+  "hal::mpl::differential_pressure::read()"_test = []() {
+    // Setup
+    mpl3115a2_simulator high_bus;
+    mpl3115a2_simulator low_bus;
+    counting_clock clock;
+    auto high = mpl3115a2::create(high_bus).value();
+    auto low = mpl3115a2::create(low_bus).value();
+    differential_pressure pair(high, low, clock);
+    // 101325.25 Pa and 101300.00 Pa
+    high_bus.pressure = 0x62F350;
+    low_bus.pressure = 0x62ED00;
+    high_bus.conversion_reads = 2;
+    low_bus.conversion_reads = 2;
+
+    // Exercise
+    auto reading = pair.read();
+
+    // Verify
+    expect(reading.has_value());
+    expect(that % 25.25f == reading.value().difference);
+    expect(that % 101325.25f == reading.value().high);
+    expect(that % 101300.0f == reading.value().low);
+    expect(that % 1U == reading.value().skew);
+    expect(that % 1000U == reading.value().timestamp);
+  };
+
+  "hal::mpl::differential_pressure times the conversion starts"_test = []() {
+    // Setup
+    mpl3115a2_simulator high_bus;
+    mpl3115a2_simulator low_bus;
+    transaction_clock clock(high_bus, low_bus);
+    auto high = mpl3115a2::create(high_bus).value();
+    auto low = mpl3115a2::create(low_bus).value();
+    differential_pressure pair(high, low, clock);
+    high_bus.transactions = 0;
+    low_bus.transactions = 0;
+    // The low device reports its previous conversion busy on the mode switch
+    // read and on two OST polls
+    low_bus.stuck_ost_reads = 3;
+
+    // Exercise
+    auto reading = pair.read();
+
+    // Verify
+    expect(reading.has_value());
+    // High: mode switch read and write, OST poll, OST read and write.
+    // Low: the same with two more OST polls. The high OST write ends at 5.
+    expect(that % 7U == reading.value().skew);
+    expect(that % 8U == reading.value().timestamp);
+  };
+
+  "hal::mpl::differential_pressure::calibrate()"_test = []() {
+    // Setup
+    mpl3115a2_simulator high_bus;
+    mpl3115a2_simulator low_bus;
+    counting_clock clock;
+    auto high = mpl3115a2::create(high_bus).value();
+    auto low = mpl3115a2::create(low_bus).value();
+    differential_pressure pair(high, low, clock);
+    // Same pressure, but the high device reads 4 Pa higher
+    high_bus.pressure = 0x62F350 + (16 << 4);
+    low_bus.pressure = 0x62F350;
+
+    // Exercise
+    auto offset = pair.calibrate(8);
+    auto reading = pair.read();
+    auto no_samples = pair.calibrate(0);
+
+    // Verify
+    expect(that % 4.0f == offset.value());
+    expect(that % 4.0f == pair.offset());
+    expect(that % 0.0f == reading.value().difference);
+    expect(!no_samples.has_value());
+  };
+};
+}  // namespace hal::mpl
@@ -0,0 +1,153 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-mpl/drift_compensation.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include <libhal-mpl/conversion.hpp>
+
+#include <boost/ut.hpp>
+
+namespace hal::mpl {
+namespace {
+/// Stationary sample at 101325 Pa that drifts by p_drift Pa/°C around 25 °C
+mpl3115a2::raw_sample_t drifting_sample(std::uint32_t p_index, float p_drift)
+{
+  // Temperature sweeps 20 °C to 30 °C and back over 400 samples
+  auto phase = static_cast<std::int32_t>(p_index % 400);
+  auto centi = phase < 200 ? phase * 5 : (400 - phase) * 5;
+  auto temperature = static_cast<std::int16_t>((2000 + centi) * 256 / 100);
+  auto celsius = static_cast<float>(temperature) / 256.0f;
+  auto pascals = 101325.0f + p_drift * (celsius - 25.0f);
+  return {
+    .pressure = static_cast<std::uint32_t>(std::lround(pascals * 64.0f)),
+    .temperature = temperature,
+  };
+}
+}  // namespace
+
+void drift_compensation_test()
+{
+  using namespace boost::ut;
+
+  "hal::mpl::drift_compensator learns the drift"_test = []() {
+    // Setup
+    drift_compensator compensator(25 * 256);
+
+    // Exercise
+    for (std::uint32_t i = 0; i < 1000; i++) {
+      compensator.learn(drifting_sample(i, 3.0f));
+    }
+    auto hot = compensator.compensate(drifting_sample(200, 3.0f));
+    auto cold = compensator.compensate(drifting_sample(0, 3.0f));
+
+    // Verify
+    expect(that % 1000U == compensator.samples());
+    expect(std::abs(compensator.coefficient() - 3.0f) < 0.01f);
+    // 15 Pa of drift between 20 °C and 30 °C is reduced below 0.25 Pa
+    expect(std::abs(to_pascals(hot) - 101325.0f) < 0.25f);
+    expect(std::abs(to_pascals(cold) - 101325.0f) < 0.25f);
+  };
+
+  "hal::mpl::drift_compensator::compensate() in fixed point"_test = []() {
+    // Setup
+    drift_compensator compensator(25 * 256);
+    compensator.set_coefficient(2.0f);
+
+    // Exercise
+    // 4 °C above the reference at 101325.25 Pa
+    auto corrected =
+      compensator.compensate({ .pressure = 0x62F350, .temperature = 29 * 256 });
+    auto at_reference =
+      compensator.compensate({ .pressure = 0x62F350, .temperature = 25 * 256 });
+
+    // Verify
+    expect(that % 101317.25f == to_pascals(corrected));
+    expect(that % 0x62F350U == at_reference);
+  };
+
+  "hal::mpl::drift_compensator without temperature change"_test = []() {
+    // Setup
+    drift_compensator compensator(25 * 256);
+    compensator.set_coefficient(1.5f);
+
+    // Exercise
+    for (std::uint32_t i = 0; i < 10'000; i++) {
+      compensator.learn({ .pressure = 0x62F350, .temperature = 25 * 256 });
+    }
+
+    // Verify
+    expect(that % 1.5f == compensator.coefficient());
+  };
+
+  "hal::mpl::drift_compensator after a long constant temperature"_test =
+    []() {
+      // Setup
+      // 101325 Pa drifting by 5 Pa/°C around 25 °C
+      auto sample = [](std::int16_t p_temperature) {
+        auto celsius = static_cast<float>(p_temperature) / 256.0f;
+        auto pascals = 101325.0f + 5.0f * (celsius - 25.0f);
+        return mpl3115a2::raw_sample_t{
+          .pressure = static_cast<std::uint32_t>(std::lround(pascals * 64.0f)),
+          .temperature = p_temperature,
+        };
+      };
+      drift_compensator compensator(25 * 256);
+      for (std::uint32_t i = 0; i < 1'000'000; i++) {
+        compensator.learn(sample(27 * 256));
+      }
+      auto state = compensator.state();
+
+      // Exercise
+      // Steps to 25.27 °C and 28.73 °C
+      float worst_error = 0.0f;
+      for (std::uint32_t i = 0; i < 20; i++) {
+        auto stepped = sample(i % 2 == 0 ? 6469 : 7355);
+        compensator.learn(stepped);
+        auto error = to_pascals(compensator.compensate(stepped)) - 101325.0f;
+        worst_error = std::max(worst_error, std::abs(error));
+      }
+
+      // Verify
+      expect(state.p01 * state.p01 <= state.p00 * state.p11);
+      expect(std::abs(compensator.coefficient() - 5.0f) < 0.05f);
+      expect(worst_error < 0.25f);
+    };
+
+  "hal::mpl::drift_compensator sample count saturates"_test = []() {
+    // Setup
+    drift_compensator learned(25 * 256);
+    for (std::uint32_t i = 0; i < 1000; i++) {
+      learned.learn(drifting_sample(i, 3.0f));
+    }
+    auto state = learned.state();
+    state.samples = UINT32_MAX - 1;
+    drift_compensator compensator(25 * 256);
+    compensator.restore(state);
+
+    // Exercise
+    for (std::uint32_t i = 0; i < 4; i++) {
+      compensator.learn(drifting_sample(i, 3.0f));
+    }
+
+    // Verify
+    expect(that % UINT32_MAX == compensator.samples());
+    expect(that % state.pressure_base == compensator.state().pressure_base);
+    expect(std::abs(compensator.coefficient() - 3.0f) < 0.01f);
+  };
+};
+}  // namespace hal::mpl
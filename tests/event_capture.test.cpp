@@ -0,0 +1,155 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-mpl/event_capture.hpp>
+
+#include <libhal-mpl/configuration.hpp>
+
+#include <boost/ut.hpp>
+
+#include "mpl3115a2_simulator.hpp"
+
+namespace hal::mpl {
+namespace {
+constexpr auto capture_configuration = make_configuration<{
+  .mode = mpl3115a2::mode::barometer,
+  .oversampling = oversampling_ratio::os16,
+  .acquire = acquisition::fifo,
+  .sample_period_ms = 1000,
+  .fifo = fifo_mode::circular,
+  .interrupts = {
+    .enabled = mpl3115a2::interrupt::pressure_threshold,
+    .route_to_int1 = mpl3115a2::interrupt::pressure_threshold,
+  },
+}>();
+
+// 100000 Pa in 1/64 Pa units
+constexpr std::uint32_t base_pressure = 100000 << 6;
+
+/// Run `p_count` conversions, each 1 Pa above the previous one
+void convert(mpl3115a2_simulator& p_simulator,
+             std::uint32_t& p_next,
+             std::uint32_t p_count)
+{
+  for (std::uint32_t i = 0; i < p_count; i++) {
+    p_simulator.pressure = base_pressure + (p_next++ << 6);
+    p_simulator.convert();
+  }
+}
+}  // namespace
+
+void event_capture_test()
+{
+  using namespace boost::ut;
+
+  "hal::mpl::event_capture::service() without a trigger"_test = []() {
+    // Setup
+    mpl3115a2_simulator simulator;
+    auto device = mpl3115a2::create(simulator, capture_configuration).value();
+    event_capture<8, 4> capture(device);
+    std::uint32_t next = 0;
+    convert(simulator, next, 40);
+    auto transactions_before = simulator.transactions;
+
+    // Exercise
+    auto result = capture.service();
+
+    // Verify
+    expect(result.value() == event_capture<8, 4>::state::armed);
+    expect(that % transactions_before == simulator.transactions);
+  };
+
+  "hal::mpl::event_capture::service() captures around the trigger"_test =
+    []() {
+      // Setup
+      using capture_t = event_capture<8, 4>;
+      mpl3115a2_simulator simulator;
+      auto device =
+        mpl3115a2::create(simulator, capture_configuration).value();
+      capture_t capture(device);
+      std::uint32_t next = 0;
+      // Wrap the circular FIFO
+      convert(simulator, next, 40);
+
+      // Exercise
+      capture.trigger();
+      auto triggered = capture.service();
+      convert(simulator, next, 3);
+      auto partial = capture.service();
+      convert(simulator, next, 2);
+      auto complete = capture.service();
+      capture.trigger();
+      convert(simulator, next, 1);
+      auto ignored = capture.service();
+
+      // Verify
+      expect(triggered.value() == capture_t::state::collecting);
+      expect(partial.value() == capture_t::state::collecting);
+      expect(complete.value() == capture_t::state::captured);
+      expect(ignored.value() == capture_t::state::captured);
+      expect(!capture.overflow());
+
+      expect(that % 8U == capture.pre_trigger().size());
+      for (std::uint32_t i = 0; i < 8; i++) {
+        expect(that % (base_pressure + ((32 + i) << 6)) ==
+               capture.pre_trigger()[i].pressure);
+      }
+      expect(that % 4U == capture.post_trigger().size());
+      for (std::uint32_t i = 0; i < 4; i++) {
+        expect(that % (base_pressure + ((40 + i) << 6)) ==
+               capture.post_trigger()[i].pressure);
+      }
+    };
+
+  "hal::mpl::event_capture::service() on a threshold interrupt"_test = []() {
+    // Setup
+    using capture_t = event_capture<4, 0>;
+    mpl3115a2_simulator simulator;
+    simulator.pressure = base_pressure;
+    auto device = mpl3115a2::create(simulator, capture_configuration).value();
+    capture_t capture(device);
+    std::uint32_t next = 0;
+    auto target_result = device.set_pressure_target(100010.0f);
+    convert(simulator, next, 10);
+
+    // Exercise
+    auto before_crossing = device.read_interrupt_source().value();
+    convert(simulator, next, 1);
+    auto after_crossing = device.read_interrupt_source().value();
+    // Stands in for the INT1 edge handler installed by attach()
+    capture.trigger();
+    auto captured = capture.service();
+
+    // Verify
+    expect(target_result.has_value());
+    // 100010 Pa in 2 Pa units
+    expect(that % 0xC3 == simulator.registers[0x16]);
+    expect(that % 0x55 == simulator.registers[0x17]);
+    expect(that % 0 == before_crossing);
+    expect(that % mpl3115a2::interrupt::pressure_threshold == after_crossing);
+    expect(captured.value() == capture_t::state::captured);
+    expect(that % 4U == capture.pre_trigger().size());
+    expect(that % (base_pressure + (10 << 6)) ==
+           capture.pre_trigger().back().pressure);
+    expect(that % 0U == capture.post_trigger().size());
+
+    // Exercise
+    capture.rearm();
+
+    // Verify
+    expect(capture.current_state() == capture_t::state::armed);
+    expect(that % 0U == capture.pre_trigger().size());
+  };
+};
+}  // namespace hal::mpl
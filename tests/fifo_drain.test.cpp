@@ -0,0 +1,190 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-mpl/fifo_drain.hpp>
+
+#include <array>
+#include <functional>
+#include <optional>
+
+#include <libhal-mpl/configuration.hpp>
+
+#include <boost/ut.hpp>
+
+#include "mpl3115a2_simulator.hpp"
+
+namespace hal::mpl {
+namespace {
+constexpr auto drain_configuration = make_configuration<{
+  .mode = mpl3115a2::mode::barometer,
+  .acquire = acquisition::fifo,
+  .fifo = fifo_mode::stop,
+}>();
+
+/// Bus that, like a DMA transfer, completes one queued transaction per call
+/// to `complete_next()`
+class deferred_i2c : public async_i2c
+{
+public:
+  explicit deferred_i2c(hal::i2c& p_i2c)
+    : m_i2c(&p_i2c)
+  {
+  }
+
+  bool complete_next()
+  {
+    if (!m_pending) {
+      return false;
+    }
+    auto pending = std::move(*m_pending);
+    m_pending.reset();
+    auto outcome = m_i2c->transaction(
+      pending.address, pending.data_out, pending.data_in, hal::never_timeout());
+    if (outcome) {
+      pending.on_complete(hal::success());
+    } else {
+      pending.on_complete(outcome.error());
+    }
+    return true;
+  }
+
+  std::size_t started = 0;
+
+private:
+  struct pending_t
+  {
+    hal::byte address;
+    std::span<const hal::byte> data_out;
+    std::span<hal::byte> data_in;
+    hal::callback<completion_handler> on_complete;
+  };
+
+  hal::status driver_transaction(
+    hal::byte p_address,
+    std::span<const hal::byte> p_data_out,
+    std::span<hal::byte> p_data_in,
+    hal::callback<completion_handler> p_on_complete) override
+  {
+    if (m_pending) {
+      return hal::new_error(std::errc::device_or_resource_busy);
+    }
+    started++;
+    m_pending = pending_t{
+      .address = p_address,
+      .data_out = p_data_out,
+      .data_in = p_data_in,
+      .on_complete = std::move(p_on_complete),
+    };
+    return hal::success();
+  }
+
+  hal::i2c* m_i2c;
+  std::optional<pending_t> m_pending;
+};
+
+void fill_fifo(mpl3115a2_simulator& p_simulator, std::uint32_t p_count)
+{
+  // Discard the sample converted when the device entered active mode
+  p_simulator.fifo.clear();
+  for (std::uint32_t i = 0; i < p_count; i++) {
+    p_simulator.pressure = 0x62F350 + (i << 4);
+    p_simulator.convert();
+  }
+}
+}  // namespace
+
+void fifo_drain_test()
+{
+  using namespace boost::ut;
+
+  "hal::mpl::fifo_drain with sync_i2c_adapter"_test = []() {
+    // Setup
+    mpl3115a2_simulator simulator;
+    auto device = mpl3115a2::create(simulator, drain_configuration).value();
+    sync_i2c_adapter bus(simulator);
+    fifo_drain drain(device, bus);
+    std::array<mpl3115a2::raw_sample_t, 32> samples{};
+    std::size_t calls = 0;
+    std::size_t read_count = 0;
+    bool overflow = false;
+    fill_fifo(simulator, 33);
+    simulator.transactions = 0;
+
+    // Exercise
+    auto status = drain.start(samples, [&](auto p_read) {
+      calls++;
+      read_count = p_read.value().samples.size();
+      overflow = p_read.value().overflow;
+    });
+
+    // Verify
+    expect(status.has_value());
+    expect(that % 1U == calls);
+    expect(that % 32U == read_count);
+    expect(overflow);
+    expect(!drain.busy());
+    expect(that % 2U == simulator.transactions);
+    expect(that % 0x62F350U == samples[0].pressure);
+    expect(that % (0x62F350U + (31 << 4)) == samples[31].pressure);
+  };
+
+  "hal::mpl::fifo_drain completes from bus callbacks"_test = []() {
+    // Setup
+    mpl3115a2_simulator simulator;
+    auto device = mpl3115a2::create(simulator, drain_configuration).value();
+    deferred_i2c bus(simulator);
+    fifo_drain drain(device, bus);
+    std::array<mpl3115a2::raw_sample_t, 4> samples{};
+    std::size_t read_count = 0;
+    fill_fifo(simulator, 6);
+
+    // Exercise
+    auto status = drain.start(samples, [&](auto p_read) {
+      read_count = p_read.value().samples.size();
+    });
+    auto busy_after_start = drain.busy();
+    auto second = drain.start(samples, [](auto) {});
+    bus.complete_next();
+    auto busy_after_status = drain.busy();
+    bus.complete_next();
+
+    // Verify
+    expect(status.has_value());
+    expect(busy_after_start);
+    expect(!second.has_value());
+    expect(busy_after_status);
+    expect(!drain.busy());
+    expect(that % 2U == bus.started);
+    expect(that % 4U == read_count);
+    // The two samples that did not fit remain in the FIFO
+    expect(that % 10U == simulator.fifo.size());
+  };
+
+  "hal::mpl::fifo_drain requires fifo acquisition"_test = []() {
+    // Setup
+    mpl3115a2_simulator simulator;
+    auto device = mpl3115a2::create(simulator).value();
+    sync_i2c_adapter bus(simulator);
+    fifo_drain drain(device, bus);
+    std::array<mpl3115a2::raw_sample_t, 4> samples{};
+
+    // Exercise
+    auto status = drain.start(samples, [](auto) {});
+
+    // Verify
+    expect(!status.has_value());
+    expect(!drain.busy());
+  };
+};
+}  // namespace hal::mpl
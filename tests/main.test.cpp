@@ -14,9 +14,43 @@
 
 namespace hal::mpl {
 extern void mpl3115a2_test();
+extern void conversion_test();
+extern void sample_log_test();
+extern void shared_interrupt_test();
+extern void worst_case_test();
+extern void configuration_test();
+extern void differential_pressure_test();
+extern void event_capture_test();
+extern void polling_test();
+extern void fifo_drain_test();
+extern void pressure_codec_test();
+extern void sample_cache_test();
+extern void sample_history_test();
+extern void mpsc_queue_test();
+extern void drift_compensation_test();
+extern void qnh_tracker_test();
+extern void bus_scheduler_test();
+extern void swinging_door_test();
 }  // namespace hal::mpl
 
 int main()
 {
   hal::mpl::mpl3115a2_test();
+  hal::mpl::conversion_test();
+  hal::mpl::sample_log_test();
+  hal::mpl::shared_interrupt_test();
+  hal::mpl::worst_case_test();
+  hal::mpl::configuration_test();
+  hal::mpl::differential_pressure_test();
+  hal::mpl::event_capture_test();
+  hal::mpl::polling_test();
+  hal::mpl::fifo_drain_test();
+  hal::mpl::pressure_codec_test();
+  hal::mpl::sample_cache_test();
+  hal::mpl::sample_history_test();
+  hal::mpl::mpsc_queue_test();
+  hal::mpl::drift_compensation_test();
+  hal::mpl::qnh_tracker_test();
+  hal::mpl::bus_scheduler_test();
+  hal::mpl::swinging_door_test();
 }
\ No newline at end of file
@@ -12,10 +12,15 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <libhal-mpl/configuration.hpp>
 #include <libhal-mpl/mpl3115a2.hpp>
 
+#include <array>
+
 #include <boost/ut.hpp>
 
+#include "mpl3115a2_simulator.hpp"
+
 namespace hal::mpl {
 void mpl3115a2_test()
 {
@@ -27,5 +32,276 @@ void mpl3115a2_test()
     // Exercise
     // Verify
   };
+
+  "mpl3115a2::configure_interrupts()"_test = []() {
+    // Setup
+    mpl3115a2_simulator simulator;
+    auto device = mpl3115a2::create(simulator).value();
+    simulator.transactions = 0;
+
+    // Exercise
+    auto status = device.configure_interrupts({
+      .enabled = mpl3115a2::interrupt::data_ready |
+                 mpl3115a2::interrupt::pressure_threshold,
+      .route_to_int1 = mpl3115a2::interrupt::data_ready |
+                       mpl3115a2::interrupt::fifo,
+      .int1 = { .active_high = false, .open_drain = true },
+      .int2 = { .active_high = true, .open_drain = false },
+    });
+    simulator.registers[int_source_r] = mpl3115a2::interrupt::data_ready;
+    auto source = device.read_interrupt_source();
+
+    // Verify
+    expect(status.has_value());
+    expect(that % 0x12 == simulator.registers[ctrl_reg3]);
+    expect(that % 0x88 == simulator.registers[ctrl_reg4]);
+    expect(that % 0x80 == simulator.registers[ctrl_reg5]);
+    expect(that % mpl3115a2::interrupt::data_ready == source.value());
+    expect(that % 2U == simulator.transactions);
+  };
+
+  "mpl3115a2::read_fifo()"_test = []() {
+    // Setup
+    constexpr auto config = make_configuration<{
+      .mode = mpl3115a2::mode::barometer,
+      .acquire = acquisition::fifo,
+      .fifo = fifo_mode::circular,
+    }>();
+    mpl3115a2_simulator simulator;
+    auto device = mpl3115a2::create(simulator, config).value();
+    for (int i = 0; i < 34; i++) {
+      simulator.pressure = 0x62F350 + static_cast<std::uint32_t>(i << 4);
+      simulator.convert();
+    }
+    std::array<mpl3115a2::raw_sample_t, 32> samples{};
+    simulator.transactions = 0;
+
+    // Exercise
+    auto full = device.read_fifo(samples);
+    auto empty = device.read_fifo(samples);
+
+    // Verify
+    expect(that % 32U == full.value().samples.size());
+    expect(full.value().overflow);
+    // The two oldest samples were discarded by the circular FIFO
+    expect(that % (0x62F350U + (2 << 4)) == samples[0].pressure);
+    expect(that % (0x62F350U + (33 << 4)) == samples[31].pressure);
+    expect(that % 0x1940 == samples[31].temperature);
+    expect(that % 0U == empty.value().samples.size());
+    expect(!empty.value().overflow);
+    // F_STATUS + one 160 byte burst, then F_STATUS only
+    expect(that % 3U == simulator.transactions);
+  };
+
+  "mpl3115a2::read_fifo() without FIFO acquisition"_test = []() {
+    // Setup
+    mpl3115a2_simulator simulator;
+    auto device = mpl3115a2::create(simulator).value();
+    std::array<mpl3115a2::raw_sample_t, 4> samples{};
+
+    // Exercise
+    auto result = device.read_fifo(samples);
+
+    // Verify
+    expect(!result.has_value());
+  };
+
+  "mpl3115a2::on_conversion_wait()"_test = []() {
+    // Setup
+    constexpr auto config = make_configuration<{
+      .mode = mpl3115a2::mode::barometer,
+      .oversampling = oversampling_ratio::os32,
+    }>();
+    mpl3115a2_simulator simulator;
+    auto device = mpl3115a2::create(simulator, config).value();
+    // Polling alone would need this many status reads
+    simulator.conversion_reads = 1000;
+    std::array<hal::time_duration, 4> sleeps{};
+    std::size_t sleep_count = 0;
+    device.on_conversion_wait([&](hal::time_duration p_duration) {
+      sleeps[sleep_count++] = p_duration;
+      // The conversion completes while the caller sleeps
+      simulator.convert();
+    });
+    simulator.transactions = 0;
+
+    // Exercise
+    auto pressure = device.read_pressure();
+    auto sample_transactions = simulator.transactions;
+    device.on_conversion_wait({});
+    simulator.conversion_reads = 3;
+    simulator.transactions = 0;
+    auto polled = device.read_pressure();
+
+    // Verify
+    expect(pressure.has_value());
+    expect(polled.has_value());
+    expect(that % 1U == sleep_count);
+    expect(130ms == sleeps[0]);
+    // OST poll, OST set, one status read and the data read
+    expect(that % 5U == sample_transactions);
+    // Without the sleep function the status register is polled 3 times
+    expect(that % 7U == simulator.transactions);
+  };
+
+  "mpl3115a2::resume() without a check"_test = []() {
+    // Setup
+    constexpr auto config = make_configuration<{
+      .mode = mpl3115a2::mode::barometer,
+      .oversampling = oversampling_ratio::os16,
+      .acquire = acquisition::continuous,
+    }>();
+    mpl3115a2_simulator simulator;
+    auto snapshot = mpl3115a2::create(simulator, config).value().snapshot();
+    simulator.transactions = 0;
+
+    // Exercise
+    auto device = mpl3115a2::resume(
+      simulator, snapshot, mpl3115a2::resume_check::none);
+    auto resume_transactions = simulator.transactions;
+    auto sample = device.value().read_sample();
+
+    // Verify
+    expect(that % 0U == resume_transactions);
+    expect(that % 66ms == device.value().conversion_time());
+    expect(sample.has_value());
+    // Continuous barometer: no mode switch or trigger, one status read and
+    // the data read
+    expect(that % 2U == simulator.transactions);
+  };
+
+  "mpl3115a2::resume() keeps a pending one-shot conversion"_test = []() {
+    // Setup
+    mpl3115a2_simulator simulator;
+    auto device = mpl3115a2::create(simulator).value();
+    simulator.conversion_reads = 1000;
+    std::size_t sleeps = 0;
+    (void)device.trigger_conversion(mpl3115a2::mode::altimeter);
+    auto snapshot = device.snapshot();
+    simulator.transactions = 0;
+
+    // Exercise
+    auto resumed = mpl3115a2::resume(simulator, snapshot).value();
+    auto resume_transactions = simulator.transactions;
+    resumed.on_conversion_wait([&](hal::time_duration) {
+      sleeps++;
+      simulator.convert();
+    });
+    auto sample = resumed.read_sample();
+
+    // Verify
+    expect(that % 1U == resume_transactions);
+    expect(sample.has_value());
+    expect(that % 1U == sleeps);
+    expect(that % mpl3115a2::snapshot_one_shot_pending == snapshot.flags);
+  };
+
+  "mpl3115a2::resume() detects a reset device"_test = []() {
+    // Setup
+    // CTRL_REG1 of this configuration equals its reset value
+    constexpr auto config = make_configuration<{
+      .mode = mpl3115a2::mode::barometer,
+      .oversampling = oversampling_ratio::os1,
+    }>();
+    mpl3115a2_simulator simulator;
+    auto snapshot = mpl3115a2::create(simulator, config).value().snapshot();
+    auto stale = snapshot;
+    stale.version++;
+
+    // Exercise
+    auto matching = mpl3115a2::resume(simulator, snapshot);
+    auto other_version = mpl3115a2::resume(simulator, stale);
+    simulator.reset();
+    auto after_reset = mpl3115a2::resume(simulator, snapshot);
+
+    // Verify
+    expect(that % 0 == config.ctrl_reg1);
+    expect(matching.has_value());
+    expect(!other_version.has_value());
+    expect(!after_reset.has_value());
+  };
+
+  "mpl3115a2::snapshot() holds calibration and interrupt registers"_test =
+    []() {
+      // Setup
+      mpl3115a2_simulator simulator;
+      auto device = mpl3115a2::create(simulator).value();
+      (void)device.set_sea_pressure(100000.0f);
+      (void)device.set_pressure_target(90000.0f);
+      (void)device.set_altitude_offset(-3);
+      (void)device.configure_interrupts({
+        .enabled = mpl3115a2::interrupt::pressure_threshold,
+        .route_to_int1 = mpl3115a2::interrupt::pressure_threshold,
+        .int1 = { .active_high = true },
+      });
+
+      // Exercise
+      auto snapshot = device.snapshot();
+      auto resumed = mpl3115a2::resume(simulator, snapshot);
+
+      // Verify
+      expect(that % 0xC3 == snapshot.bar_in[0]);
+      expect(that % 0x50 == snapshot.bar_in[1]);
+      expect(that % 0xAF == snapshot.p_tgt[0]);
+      expect(that % 0xC8 == snapshot.p_tgt[1]);
+      expect(that % 0xFD == snapshot.offsets[2]);
+      expect(that % simulator.registers[ctrl_reg3] == snapshot.control[2]);
+      expect(that % mpl3115a2::interrupt::pressure_threshold ==
+             snapshot.control[3]);
+      expect(that % mpl3115a2::interrupt::pressure_threshold ==
+             snapshot.control[4]);
+      expect(resumed.has_value());
+      auto again = resumed.value().snapshot();
+      expect(snapshot.bar_in == again.bar_in);
+      expect(snapshot.p_tgt == again.p_tgt);
+      expect(snapshot.control == again.control);
+      expect(snapshot.offsets == again.offsets);
+    };
+
+  "mpl3115a2::resume() detects lost calibration"_test = []() {
+    // Setup
+    mpl3115a2_simulator simulator;
+    auto device = mpl3115a2::create(simulator).value();
+    (void)device.set_sea_pressure(100000.0f);
+    (void)device.set_altitude_offset(5);
+    auto snapshot = device.snapshot();
+
+    // Exercise
+    auto matching = mpl3115a2::resume(simulator, snapshot);
+    simulator.registers[off_h_r] = 0;
+    auto lost_offset = mpl3115a2::resume(simulator, snapshot);
+    simulator.registers[off_h_r] = 5;
+    simulator.registers[bar_in_lsb_r] = 0xE7;
+    auto lost_sea_pressure = mpl3115a2::resume(simulator, snapshot);
+
+    // Verify
+    expect(matching.has_value());
+    expect(!lost_offset.has_value());
+    expect(!lost_sea_pressure.has_value());
+  };
+
+  "mpl3115a2::resume() checks F_SETUP in FIFO acquisition"_test = []() {
+    // Setup
+    constexpr auto config = make_configuration<{
+      .mode = mpl3115a2::mode::barometer,
+      .oversampling = oversampling_ratio::os1,
+      .acquire = acquisition::fifo,
+    }>();
+    mpl3115a2_simulator simulator;
+    auto snapshot = mpl3115a2::create(simulator, config).value().snapshot();
+    simulator.transactions = 0;
+
+    // Exercise
+    auto matching = mpl3115a2::resume(simulator, snapshot);
+    auto resume_transactions = simulator.transactions;
+    simulator.registers[f_setup_r] = 0;
+    auto fifo_off = mpl3115a2::resume(simulator, snapshot);
+
+    // Verify
+    expect(that % 0 != config.f_setup);
+    expect(matching.has_value());
+    expect(that % 2U == resume_transactions);
+    expect(!fifo_off.has_value());
+  };
 };
 }  // namespace hal::mpl
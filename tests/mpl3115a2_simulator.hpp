@@ -0,0 +1,368 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <span>
+
+#include <libhal-mpl/mpl3115a2.hpp>
+#include <libhal/i2c.hpp>
+
+#include "../src/mpl3115a2_reg.hpp"
+
+namespace hal::mpl {
+/**
+ * @brief Register level model of an MPL3115A2 behind a hal::i2c bus
+ *
+ * Models the register file with auto-increment addressing, software reset,
+ * one-shot and active mode conversions, the data ready flags, the FIFO and
+ * the pressure threshold interrupt source. Every
+ * transaction is counted and its bus time modeled so tests can make assertions
+ * about bus traffic.
+ * The timing knobs let tests play an adversarial device that keeps the driver
+ * polling for as long as possible.
+ */
+class mpl3115a2_simulator : public hal::i2c
+{
+public:
+  mpl3115a2_simulator()
+  {
+    reset();
+  }
+
+  /// Raw OUT_P word produced by conversions in barometer mode
+  std::uint32_t pressure = 0x62F350;
+  /// Raw OUT_P word produced by conversions in altimeter mode
+  std::uint32_t altitude = 0x010080;
+  /// Raw OUT_T word produced by conversions
+  std::int16_t temperature = 0x1940;
+  /// Number of status register reads before a triggered conversion completes
+  std::uint32_t conversion_reads = 0;
+  /// Number of upcoming CTRL_REG1 reads that report a previous conversion
+  /// still in progress with the OST bit set. Triggers are ignored meanwhile.
+  std::uint32_t stuck_ost_reads = 0;
+  /// Number of transactions NACKed by the device after a software reset
+  std::uint32_t reset_nack_transactions = 0;
+
+  /// Register file
+  std::array<hal::byte, 256> registers{};
+  /// Total transactions addressed to the device
+  std::uint32_t transactions = 0;
+  /// Total bytes written and read by transactions to the device
+  std::uint32_t bytes = 0;
+  /// Total bit times the bus was occupied by transactions to the device
+  std::uint64_t bus_bits = 0;
+  /// Control register changes made while active, which the datasheet only
+  /// allows in standby
+  std::uint32_t active_control_writes = 0;
+  /// Direct changes between circular and stop FIFO mode, which the device
+  /// rejects as the datasheet requires disabling the FIFO in between
+  std::uint32_t rejected_fifo_mode_changes = 0;
+
+  /**
+   * @brief Modeled bus occupancy of all transactions so far
+   *
+   * Every byte, including the address byte, takes 9 bit times with its
+   * acknowledge. Start, repeated start and stop conditions take one bit time.
+   *
+   * @param p_clock_rate - I2C clock rate
+   * @return std::chrono::microseconds - time the bus was occupied
+   */
+  std::chrono::microseconds bus_time(hal::hertz p_clock_rate) const
+  {
+    return std::chrono::microseconds(
+      static_cast<std::int64_t>(static_cast<double>(bus_bits) * 1e6 /
+                                static_cast<double>(p_clock_rate)));
+  }
+
+  /**
+   * @brief Complete a conversion immediately, as happens every time step in
+   * active mode. With the FIFO enabled the sample is also queued in the FIFO.
+   */
+  void convert()
+  {
+    m_conversion_pending = true;
+    m_reads_until_ready = 0;
+    complete_conversion_if_ready();
+  }
+
+  static constexpr auto fifo_sample_size = mpl3115a2::fifo_sample_size;
+
+  /// Samples queued in the FIFO, fifo_sample_size bytes each
+  std::deque<hal::byte> fifo;
+  /// Set when a sample was dropped or discarded because the FIFO was full
+  bool fifo_overflow = false;
+
+  void reset()
+  {
+    fifo.clear();
+    fifo_overflow = false;
+    registers.fill(0);
+    registers[whoami_r] = 0xC4;
+    // BAR_IN resets to 101,326 Pa in 2 Pa units
+    registers[bar_in_msb_r] = 0xC5;
+    registers[bar_in_lsb_r] = 0xE7;
+    m_conversion_pending = false;
+    m_reads_until_ready = 0;
+    m_nacks_remaining = reset_nack_transactions;
+    m_previous_pressure.reset();
+  }
+
+private:
+  status driver_configure(const settings&) override
+  {
+    return hal::success();
+  }
+
+  result<transaction_t> driver_transaction(
+    hal::byte p_address,
+    std::span<const hal::byte> p_data_out,
+    std::span<hal::byte> p_data_in,
+    hal::function_ref<hal::timeout_function>) override
+  {
+    if (p_address != device_address) {
+      return hal::new_error(std::errc::no_such_device_or_address);
+    }
+
+    transactions++;
+    if (m_nacks_remaining > 0) {
+      // start + address + stop
+      bus_bits += 11;
+      m_nacks_remaining--;
+      return hal::new_error(std::errc::no_such_device_or_address);
+    }
+
+    bytes += static_cast<std::uint32_t>(p_data_out.size() + p_data_in.size());
+    // start + address + data + stop
+    bus_bits += 2 + 9 * (1 + p_data_out.size());
+    if (!p_data_in.empty()) {
+      // repeated start + address + data
+      bus_bits += 1 + 9 * (1 + p_data_in.size());
+    }
+
+    if (!p_data_out.empty()) {
+      m_pointer = p_data_out[0];
+      for (auto value : p_data_out.subspan(1)) {
+        write_register(m_pointer++, value);
+      }
+    }
+
+    for (auto& value : p_data_in) {
+      value = read_register(m_pointer);
+      // F_DATA is read repeatedly from the same address
+      if (!(fifo_enabled() && m_pointer == out_p_msb_r)) {
+        m_pointer++;
+      }
+    }
+
+    return transaction_t{};
+  }
+
+  void write_register(hal::byte p_register, hal::byte p_value)
+  {
+    check_standby(p_register, p_value);
+    if (p_register == f_setup_r) {
+      auto previous_mode = registers[f_setup_r] >> 6;
+      auto mode = p_value >> 6;
+      if (previous_mode != 0 && mode != 0 && previous_mode != mode) {
+        rejected_fifo_mode_changes++;
+        return;
+      }
+    }
+    if (p_register == ctrl_reg1) {
+      if (p_value & ctrl_reg1_rst) {
+        reset();
+        return;
+      }
+      if ((p_value & ctrl_reg1_ost) && stuck_ost_reads > 0) {
+        // A conversion is still in progress, the trigger is ignored
+        p_value &= ~ctrl_reg1_ost;
+      } else if (p_value & (ctrl_reg1_ost | ctrl_reg1_sbyb)) {
+        m_conversion_pending = true;
+        m_reads_until_ready = conversion_reads;
+      }
+    }
+    registers[p_register] = p_value;
+    complete_conversion_if_ready();
+  }
+
+  void check_standby(hal::byte p_register, hal::byte p_value)
+  {
+    if ((registers[ctrl_reg1] & ctrl_reg1_sbyb) == 0) {
+      return;
+    }
+    if (p_register == ctrl_reg1) {
+      // Only SBYB, OST and RST may change while active, including in the
+      // write that leaves active mode
+      constexpr hal::byte free_bits =
+        ctrl_reg1_sbyb | ctrl_reg1_ost | ctrl_reg1_rst;
+      if (((registers[ctrl_reg1] ^ p_value) & ~free_bits) != 0) {
+        active_control_writes++;
+      }
+    } else if (p_register >= ctrl_reg2 && p_register <= ctrl_reg5 &&
+               registers[p_register] != p_value) {
+      active_control_writes++;
+    }
+  }
+
+  bool fifo_enabled() const
+  {
+    return (registers[f_setup_r] >> 6) != 0;
+  }
+
+  hal::byte read_fifo_register(hal::byte p_register)
+  {
+    if (p_register == status_r) {
+      auto count = static_cast<hal::byte>(fifo.size() / fifo_sample_size);
+      auto watermark = registers[f_setup_r] & f_status_cnt_mask;
+      hal::byte value = count;
+      if (fifo_overflow) {
+        value |= f_status_ovf;
+        fifo_overflow = false;
+      }
+      // Reading F_STATUS clears the FIFO interrupt source
+      registers[int_source_r] &= ~mpl3115a2::interrupt::fifo;
+      if (watermark != 0 && count >= watermark) {
+        value |= f_status_wmrk;
+      }
+      return value;
+    }
+
+    if (fifo.empty()) {
+      return 0;
+    }
+    auto value = fifo.front();
+    fifo.pop_front();
+    return value;
+  }
+
+  hal::byte read_register(hal::byte p_register)
+  {
+    if (fifo_enabled() &&
+        (p_register == status_r || p_register == out_p_msb_r)) {
+      return read_fifo_register(p_register);
+    }
+
+    if (p_register == status_r || p_register == ctrl_reg1) {
+      if (m_reads_until_ready > 0) {
+        m_reads_until_ready--;
+      }
+      complete_conversion_if_ready();
+    }
+
+    auto value = registers[p_register];
+    if (p_register == int_source_r) {
+      // Reading INT_SOURCE acknowledges the threshold source
+      registers[int_source_r] &= ~mpl3115a2::interrupt::pressure_threshold;
+    }
+    if (p_register == ctrl_reg1 && stuck_ost_reads > 0) {
+      stuck_ost_reads--;
+      value |= ctrl_reg1_ost;
+    }
+
+    // Reading the MSB of an output register clears its data ready flag
+    if (p_register == out_p_msb_r) {
+      registers[status_r] &= ~status_pdr;
+    } else if (p_register == out_t_msb_r) {
+      registers[status_r] &= ~status_tdr;
+    }
+    if ((registers[status_r] & (status_pdr | status_tdr)) == 0) {
+      registers[status_r] &= ~status_ptdr;
+    }
+
+    return value;
+  }
+
+  void complete_conversion_if_ready()
+  {
+    if (!m_conversion_pending || m_reads_until_ready > 0) {
+      return;
+    }
+
+    auto word = (registers[ctrl_reg1] & ctrl_reg1_alt) ? altitude : pressure;
+    registers[out_p_msb_r] = hal::byte(word >> 16);
+    registers[out_p_csb_r] = hal::byte(word >> 8);
+    registers[out_p_lsb_r] = hal::byte(word);
+    registers[out_t_msb_r] = hal::byte(std::uint16_t(temperature) >> 8);
+    registers[out_t_lsb_r] = hal::byte(temperature);
+    registers[status_r] |= status_pdr | status_tdr | status_ptdr;
+
+    if (!(registers[ctrl_reg1] & ctrl_reg1_alt)) {
+      detect_pressure_threshold(word);
+    }
+
+    if (fifo_enabled()) {
+      push_fifo_sample();
+    }
+
+    if (registers[ctrl_reg1] & ctrl_reg1_sbyb) {
+      // Active mode schedules the next conversion immediately
+      m_reads_until_ready = conversion_reads;
+      return;
+    }
+    registers[ctrl_reg1] &= ~ctrl_reg1_ost;
+    m_conversion_pending = false;
+  }
+
+  void detect_pressure_threshold(std::uint32_t p_word)
+  {
+    // OUT_P holds 1/64 Pa units and P_TGT holds 2 Pa units
+    auto current = static_cast<std::uint16_t>(p_word >> 7);
+    auto target = static_cast<std::uint16_t>(registers[p_tgt_msb_r] << 8 |
+                                             registers[p_tgt_lsb_r]);
+    bool enabled =
+      registers[ctrl_reg4] & mpl3115a2::interrupt::pressure_threshold;
+
+    if (enabled && m_previous_pressure.has_value() &&
+        (*m_previous_pressure < target) != (current < target)) {
+      registers[int_source_r] |= mpl3115a2::interrupt::pressure_threshold;
+    }
+    m_previous_pressure = current;
+  }
+
+  void push_fifo_sample()
+  {
+    if (fifo.size() >= mpl3115a2::fifo_capacity * fifo_sample_size) {
+      fifo_overflow = true;
+      if ((registers[f_setup_r] >> 6) == 2) {
+        // Stop mode: new samples are discarded
+        return;
+      }
+      // Circular mode: the oldest sample is discarded
+      fifo.erase(fifo.begin(), fifo.begin() + fifo_sample_size);
+    }
+
+    for (auto index :
+         { out_p_msb_r, out_p_csb_r, out_p_lsb_r, out_t_msb_r, out_t_lsb_r }) {
+      fifo.push_back(registers[index]);
+    }
+
+    auto watermark = registers[f_setup_r] & f_status_cnt_mask;
+    if (watermark != 0 && fifo.size() >= watermark * fifo_sample_size) {
+      registers[int_source_r] |= mpl3115a2::interrupt::fifo;
+    }
+  }
+
+  hal::byte m_pointer = 0;
+  bool m_conversion_pending = false;
+  std::uint32_t m_reads_until_ready = 0;
+  std::uint32_t m_nacks_remaining = 0;
+  std::optional<std::uint16_t> m_previous_pressure;
+};
+}  // namespace hal::mpl
@@ -0,0 +1,97 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-mpl/mpsc_queue.hpp>
+
+#include <array>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <boost/ut.hpp>
+
+namespace hal::mpl {
+void mpsc_queue_test()
+{
+  using namespace boost::ut;
+
+  "hal::mpl::mpsc_queue order and capacity"_test = []() {
+    // Setup
+    mpsc_queue<int, 4> queue;
+    std::vector<int> popped;
+
+    // Exercise
+    auto empty = queue.try_pop();
+    for (int i = 0; i < 4; i++) {
+      (void)queue.try_push(i);
+    }
+    auto full = queue.try_push(4);
+    popped.push_back(queue.try_pop().value());
+    auto refill = queue.try_push(5);
+    while (auto value = queue.try_pop()) {
+      popped.push_back(*value);
+    }
+
+    // Verify
+    expect(!empty.has_value());
+    expect(!full);
+    expect(refill);
+    expect(std::vector{ 0, 1, 2, 3, 5 } == popped);
+    expect(that % 0U == queue.size_approx());
+  };
+
+  "hal::mpl::mpsc_queue with concurrent producers"_test = []() {
+    // Setup
+    constexpr std::uint32_t producers = 4;
+    constexpr std::uint32_t per_producer = 20'000;
+    mpsc_queue<std::uint32_t, 64> queue;
+    std::vector<std::thread> threads;
+    std::array<std::uint32_t, producers> next{};
+    bool ordered = true;
+
+    // Exercise
+    for (std::uint32_t id = 0; id < producers; id++) {
+      threads.emplace_back([&queue, id]() {
+        for (std::uint32_t i = 0; i < per_producer; i++) {
+          while (!queue.try_push(id << 24 | i)) {
+            std::this_thread::yield();
+          }
+        }
+      });
+    }
+    for (std::uint32_t received = 0; received < producers * per_producer;) {
+      auto value = queue.try_pop();
+      if (!value) {
+        std::this_thread::yield();
+        continue;
+      }
+      // Values from one producer arrive in the order they were pushed
+      auto id = *value >> 24;
+      ordered = ordered && (*value & 0xFFFFFF) == next[id];
+      next[id]++;
+      received++;
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    // Verify
+    expect(ordered);
+    for (auto count : next) {
+      expect(that % per_producer == count);
+    }
+    expect(!queue.try_pop().has_value());
+  };
+};
+}  // namespace hal::mpl
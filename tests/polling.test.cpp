@@ -0,0 +1,206 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-mpl/polling.hpp>
+
+#include <array>
+#include <chrono>
+
+#include <libhal-mpl/configuration.hpp>
+
+#include <boost/ut.hpp>
+
+#include "mpl3115a2_simulator.hpp"
+
+namespace hal::mpl {
+namespace {
+constexpr auto polling_configuration = make_configuration<{
+  .mode = mpl3115a2::mode::barometer,
+  .oversampling = oversampling_ratio::os8,
+}>();
+
+/// Records every requested sleep
+struct sleep_log
+{
+  std::array<hal::time_duration, 16> sleeps{};
+  std::size_t count = 0;
+
+  auto sleeper()
+  {
+    return [this](hal::time_duration p_duration) {
+      sleeps[count++] = p_duration;
+    };
+  }
+};
+}  // namespace
+
+void polling_test()
+{
+  using namespace boost::ut;
+  using namespace std::chrono_literals;
+
+  "hal::mpl::read_sample() with polling::immediate"_test = []() {
+    // Setup
+    mpl3115a2_simulator simulator;
+    auto device = mpl3115a2::create(simulator, polling_configuration).value();
+    simulator.conversion_reads = 4;
+    polling::immediate policy;
+    (void)device.trigger_conversion(mpl3115a2::mode::barometer);
+    simulator.transactions = 0;
+
+    // Exercise
+    auto sample = read_sample(device, policy);
+
+    // Verify
+    expect(that % simulator.pressure == sample.value().pressure);
+    // 4 status reads and the data read
+    expect(that % 5U == simulator.transactions);
+  };
+
+  "hal::mpl::read_sample() with polling::fixed_delay"_test = []() {
+    // Setup
+    mpl3115a2_simulator simulator;
+    auto device = mpl3115a2::create(simulator, polling_configuration).value();
+    simulator.conversion_reads = 3;
+    sleep_log log;
+    polling::fixed_delay policy(log.sleeper(), 2ms);
+    (void)device.trigger_conversion(mpl3115a2::mode::barometer);
+
+    // Exercise
+    auto sample = read_sample(device, policy);
+
+    // Verify
+    expect(sample.has_value());
+    expect(that % 2U == log.count);
+    expect(2ms == log.sleeps[0]);
+    expect(2ms == log.sleeps[1]);
+  };
+
+  "hal::mpl::read_sample() with polling::exponential_backoff"_test = []() {
+    // Setup
+    mpl3115a2_simulator simulator;
+    auto device = mpl3115a2::create(simulator, polling_configuration).value();
+    simulator.conversion_reads = 6;
+    sleep_log log;
+    polling::exponential_backoff policy(log.sleeper(), 1ms, 8ms);
+    (void)device.trigger_conversion(mpl3115a2::mode::barometer);
+
+    // Exercise
+    auto sample = read_sample(device, policy);
+    simulator.conversion_reads = 2;
+    (void)device.trigger_conversion(mpl3115a2::mode::barometer);
+    auto restarted = read_sample(device, policy);
+
+    // Verify
+    expect(sample.has_value());
+    expect(restarted.has_value());
+    expect(that % 6U == log.count);
+    expect(1ms == log.sleeps[0]);
+    expect(2ms == log.sleeps[1]);
+    expect(4ms == log.sleeps[2]);
+    expect(8ms == log.sleeps[3]);
+    expect(8ms == log.sleeps[4]);
+    // Every wait starts again from the initial delay
+    expect(1ms == log.sleeps[5]);
+  };
+
+  "hal::mpl::read_sample() with polling::expected_time"_test = []() {
+    // Setup
+    mpl3115a2_simulator simulator;
+    auto device = mpl3115a2::create(simulator, polling_configuration).value();
+    sleep_log log;
+    polling::expected_time policy([&](hal::time_duration p_duration) {
+      log.sleeper()(p_duration);
+      // The conversion completes while the caller sleeps
+      simulator.convert();
+    });
+    simulator.conversion_reads = 1000;
+    (void)device.trigger_conversion(mpl3115a2::mode::barometer);
+    simulator.transactions = 0;
+
+    // Exercise
+    auto sample = read_sample(device, policy);
+
+    // Verify
+    expect(sample.has_value());
+    expect(that % 1U == log.count);
+    expect(34ms == log.sleeps[0]);
+    // A single status read and the data read
+    expect(that % 2U == simulator.transactions);
+  };
+
+  "hal::mpl::read_sample() gives up after the maximum attempts"_test = []() {
+    // Setup
+    mpl3115a2_simulator simulator;
+    auto device = mpl3115a2::create(simulator, polling_configuration).value();
+    simulator.conversion_reads = 1000;
+    polling::immediate policy;
+    (void)device.trigger_conversion(mpl3115a2::mode::barometer);
+    simulator.transactions = 0;
+
+    // Exercise
+    auto sample = read_sample(device, policy, 10);
+
+    // Verify
+    expect(!sample.has_value());
+    expect(that % 10U == simulator.transactions);
+  };
+
+  "mpl3115a2::set_wait_policy() applies to every wait"_test = []() {
+    // Setup
+    mpl3115a2_simulator simulator;
+    auto device = mpl3115a2::create(simulator, polling_configuration).value();
+    sleep_log log;
+    polling::exponential_backoff policy(log.sleeper(), 1ms, 8ms);
+    device.set_wait_policy(policy);
+    // The previous one-shot is still in progress for 2 reads
+    simulator.stuck_ost_reads = 2;
+    simulator.conversion_reads = 3;
+
+    // Exercise
+    auto pressure = device.read_pressure();
+
+    // Verify
+    expect(pressure.has_value());
+    // 2 waits for OST to clear, then 2 waits for the conversion
+    expect(that % 4U == log.count);
+    expect(1ms == log.sleeps[0]);
+    expect(2ms == log.sleeps[1]);
+    expect(1ms == log.sleeps[2]);
+    expect(2ms == log.sleeps[3]);
+  };
+
+  "mpl3115a2::create() waits for the reset with a policy"_test = []() {
+    // Setup
+    mpl3115a2_simulator simulator;
+    simulator.reset_nack_transactions = 3;
+    sleep_log log;
+    polling::fixed_delay policy(log.sleeper(), 1ms);
+
+    // Exercise
+    auto device = mpl3115a2::create(simulator, polling_configuration, policy);
+    auto count_after_create = log.count;
+    simulator.conversion_reads = 2;
+    auto pressure = device.value().read_pressure();
+
+    // Verify
+    expect(device.has_value());
+    // One wait after each NACKed check
+    expect(that % 3U == count_after_create);
+    expect(pressure.has_value());
+    // The policy stays in use, one wait for the conversion
+    expect(that % 4U == log.count);
+  };
+};
+}  // namespace hal::mpl
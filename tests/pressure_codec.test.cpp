@@ -0,0 +1,201 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-mpl/pressure_codec.hpp>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <boost/ut.hpp>
+
+namespace hal::mpl {
+namespace {
+/// Slowly drifting pressure with a few counts of noise, in 1/4 Pa units
+std::vector<std::uint32_t> weather(std::size_t p_count)
+{
+  std::vector<std::uint32_t> samples(p_count);
+  std::uint32_t state = 12345;
+  std::int32_t pressure = 101325 * 4;
+  for (auto& sample : samples) {
+    state = state * 1664525 + 1013904223;
+    pressure += static_cast<std::int32_t>(state >> 29) - 3;
+    sample = static_cast<std::uint32_t>(pressure);
+  }
+  return samples;
+}
+
+/// Pressure whose changes ring like a resonance, which linear prediction of
+/// the changes follows much better than a polynomial
+std::vector<std::uint32_t> resonance(std::size_t p_count)
+{
+  std::vector<std::uint32_t> samples(p_count);
+  std::uint32_t state = 777;
+  std::int32_t pressure = 101325 * 4;
+  std::int32_t change = 0;
+  std::int32_t previous_change = 0;
+  for (auto& sample : samples) {
+    state = state * 1664525 + 1013904223;
+    auto next = (13 * change - 7 * previous_change) / 8 +
+                static_cast<std::int32_t>(state >> 27) - 16;
+    previous_change = change;
+    change = next;
+    pressure += change;
+    sample = static_cast<std::uint32_t>(pressure);
+  }
+  return samples;
+}
+
+/// Samples spanning the full 20-bit range
+std::vector<std::uint32_t> noise(std::size_t p_count)
+{
+  std::vector<std::uint32_t> samples(p_count);
+  std::uint32_t state = 99;
+  for (auto& sample : samples) {
+    state = state * 1664525 + 1013904223;
+    sample = state >> 12;
+  }
+  return samples;
+}
+}  // namespace
+
+void pressure_codec_test()
+{
+  using namespace boost::ut;
+
+  "hal::mpl::encode_pressure_block() round trip"_test = []() {
+    for (const auto& samples :
+         { weather(max_pressure_block_samples), noise(1000), weather(1) }) {
+      // Setup
+      std::vector<hal::byte> block(max_pressure_block_size(samples.size()));
+      std::vector<std::uint32_t> decoded(samples.size());
+
+      // Exercise
+      auto size = encode_pressure_block(samples, block);
+      auto result = decode_pressure_block(block, decoded);
+
+      // Verify
+      expect(size.has_value());
+      expect(result.has_value());
+      expect(that % samples.size() == result.value().size());
+      expect(samples == decoded);
+    }
+  };
+
+  "hal::mpl::encode_pressure_block() compresses slow drift"_test = []() {
+    // Setup
+    auto samples = weather(max_pressure_block_samples);
+    std::vector<hal::byte> block(max_pressure_block_size(samples.size()));
+
+    // Exercise
+    auto size = encode_pressure_block(samples, block).value();
+
+    // Verify
+    // Residuals span 8 values, so 3 bits per sample is the entropy bound and
+    // packing without compression takes 20 bits per sample
+    expect(size * 8 < samples.size() * 5);
+  };
+
+  "hal::mpl::encode_pressure_block() linear prediction"_test = []() {
+    // Setup
+    auto samples = resonance(max_pressure_block_samples);
+    std::vector<hal::byte> lpc(max_pressure_block_size(samples.size()));
+    std::vector<hal::byte> polynomial(lpc.size());
+    std::vector<std::uint32_t> decoded(samples.size());
+
+    // Exercise
+    auto lpc_size = encode_pressure_block(samples, lpc);
+    auto polynomial_size = encode_pressure_block(samples, polynomial, 0);
+    auto result = decode_pressure_block(lpc, decoded);
+    auto info = read_pressure_block_header(lpc);
+
+    // Verify
+    expect(result.has_value());
+    expect(samples == decoded);
+    expect(that % 0 !=
+           (info.value().predictor & pressure_block_info::lpc_predictor));
+    expect(that % pressure_block_info::lpc_predictor >
+           read_pressure_block_header(polynomial).value().predictor);
+    expect(that % lpc_size.value() < polynomial_size.value());
+  };
+
+  "hal::mpl::pressure_block_decoder streams into a small buffer"_test = []() {
+    // Setup
+    auto samples = weather(1000);
+    std::vector<hal::byte> block(max_pressure_block_size(samples.size()));
+    (void)encode_pressure_block(samples, block).value();
+    auto decoder = pressure_block_decoder::create(block).value();
+    std::array<std::uint32_t, 7> buffer{};
+    std::vector<std::uint32_t> decoded;
+
+    // Exercise
+    while (true) {
+      auto chunk = decoder.read(buffer).value();
+      if (chunk.empty()) {
+        break;
+      }
+      decoded.insert(decoded.end(), chunk.begin(), chunk.end());
+    }
+
+    // Verify
+    expect(samples == decoded);
+    expect(that % 0U == decoder.remaining());
+  };
+
+  "hal::mpl::encode_pressure_block() rejects invalid input"_test = []() {
+    // Setup
+    std::array<std::uint32_t, 2> wide{ 0x100000, 0 };
+    std::array<hal::byte, 64> block{};
+    std::array<hal::byte, 9> small{};
+    auto samples = weather(100);
+
+    // Exercise
+    auto wide_result = encode_pressure_block(wide, block);
+    auto empty_result = encode_pressure_block({}, block);
+    auto small_result = encode_pressure_block(samples, small);
+
+    // Verify
+    expect(!wide_result.has_value());
+    expect(!empty_result.has_value());
+    expect(!small_result.has_value());
+  };
+
+  "hal::mpl::decode_pressure_block() rejects corrupt blocks"_test = []() {
+    // Setup
+    auto samples = weather(500);
+    std::vector<hal::byte> block(max_pressure_block_size(samples.size()));
+    auto size = encode_pressure_block(samples, block).value();
+    std::vector<std::uint32_t> decoded(samples.size());
+    auto truncated = std::span(block).first(size - 1);
+    auto bad_order = block;
+    bad_order[2] = 7;
+    // Claim fewer payload bytes than the samples need
+    auto short_payload = block;
+    short_payload[4] = hal::byte(short_payload[4] - 8);
+
+    // Exercise
+    auto truncated_result = decode_pressure_block(truncated, decoded);
+    auto order_result = decode_pressure_block(bad_order, decoded);
+    auto payload_result = decode_pressure_block(short_payload, decoded);
+    auto small_result =
+      decode_pressure_block(block, std::span(decoded).first(10));
+
+    // Verify
+    expect(!truncated_result.has_value());
+    expect(!order_result.has_value());
+    expect(!payload_result.has_value());
+    expect(!small_result.has_value());
+  };
+};
+}  // namespace hal::mpl
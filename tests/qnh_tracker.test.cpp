@@ -0,0 +1,108 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-mpl/qnh_tracker.hpp>
+
+#include <cmath>
+
+#include <boost/ut.hpp>
+
+#include "mpl3115a2_simulator.hpp"
+
+namespace hal::mpl {
+namespace {
+/// Pressure at p_altitude when the sea level pressure is p_sea_pressure
+float station_pressure(float p_sea_pressure, float p_altitude)
+{
+  return p_sea_pressure * std::pow(1.0f - p_altitude / 44330.77f, 5.255877f);
+}
+
+std::uint16_t bar_in(const mpl3115a2_simulator& p_simulator)
+{
+  return static_cast<std::uint16_t>(p_simulator.registers[bar_in_msb_r] << 8 |
+                                    p_simulator.registers[bar_in_lsb_r]);
+}
+}  // namespace
+
+void qnh_tracker_test()
+{
+  using namespace boost::ut;
+
+  "hal::mpl::qnh_tracker::update_pressure()"_test = []() {
+    // Setup
+    mpl3115a2_simulator simulator;
+    auto device = mpl3115a2::create(simulator).value();
+    qnh_tracker tracker(device, { .alpha = 0.1f, .sea_pressure = 101326.0f });
+    simulator.transactions = 0;
+
+    // Exercise
+    // Weather has moved sea level pressure to 100900 Pa
+    for (int i = 0; i < 200; i++) {
+      auto altitude = 500.0f + static_cast<float>(i % 7);
+      auto pressure = station_pressure(100900.0f, altitude);
+      auto status = tracker.update_pressure(pressure, altitude);
+      expect(status.has_value());
+    }
+
+    // Verify
+    expect(std::abs(tracker.sea_pressure() - 100900.0f) < 2.0f);
+    expect(std::abs(tracker.written_sea_pressure() - 100900.0f) < 4.0f);
+    expect(that % (tracker.written_sea_pressure() / 2.0f) ==
+           static_cast<float>(bar_in(simulator)));
+    // One two byte write per 2 Pa step, far fewer than the updates
+    expect(that % tracker.writes() == simulator.transactions);
+    expect(that % 40U > tracker.writes());
+  };
+
+  "hal::mpl::qnh_tracker ignores changes below 2 Pa"_test = []() {
+    // Setup
+    mpl3115a2_simulator simulator;
+    auto device = mpl3115a2::create(simulator).value();
+    qnh_tracker tracker(device, { .alpha = 1.0f, .sea_pressure = 101326.0f });
+    simulator.transactions = 0;
+
+    // Exercise
+    auto small = tracker.update_pressure(101327.5f, 0.0f);
+    auto small_writes = tracker.writes();
+    auto large = tracker.update_pressure(101330.5f, 0.0f);
+
+    // Verify
+    expect(small.has_value());
+    expect(large.has_value());
+    expect(that % 0U == small_writes);
+    expect(that % 1U == tracker.writes());
+    expect(that % 1U == simulator.transactions);
+    expect(that % 50665U == bar_in(simulator));
+    expect(that % 101330.0f == tracker.written_sea_pressure());
+  };
+
+  "hal::mpl::qnh_tracker::update_altitude()"_test = []() {
+    // Setup
+    mpl3115a2_simulator simulator;
+    auto device = mpl3115a2::create(simulator).value();
+    qnh_tracker tracker(device, { .alpha = 1.0f, .sea_pressure = 101326.0f });
+
+    // Exercise
+    // With BAR_IN at 101326 Pa the device reads 120 m where GNSS says 100 m
+    auto status = tracker.update_altitude(120.0f, 100.0f);
+    auto corrected = station_pressure(tracker.written_sea_pressure(), 100.0f);
+
+    // Verify
+    expect(status.has_value());
+    expect(that % 1U == tracker.writes());
+    // The new BAR_IN maps the measured pressure to the reference altitude
+    expect(std::abs(corrected - station_pressure(101326.0f, 120.0f)) < 2.0f);
+  };
+};
+}  // namespace hal::mpl
@@ -0,0 +1,203 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-mpl/sample_cache.hpp>
+
+#include <boost/ut.hpp>
+
+#include "mpl3115a2_simulator.hpp"
+
+namespace hal::mpl {
+namespace {
+/// Microsecond clock that only moves when the test advances it
+class manual_clock : public hal::steady_clock
+{
+public:
+  std::uint64_t ticks = 0;
+
+private:
+  frequency_t driver_frequency() override
+  {
+    return frequency_t{ .operating_frequency = 1'000'000.0f };
+  }
+
+  uptime_t driver_uptime() override
+  {
+    return uptime_t{ .ticks = ticks };
+  }
+};
+}  // namespace
+
+void sample_cache_test()
+{
+  using namespace boost::ut;
+  using namespace std::literals;
+
+  "hal::mpl::sample_cache::read() reuses fresh samples"_test = []() {
+    // Setup
+    mpl3115a2_simulator simulator;
+    manual_clock clock;
+    auto device = mpl3115a2::create(simulator).value();
+    sample_cache cache(device, clock, 100ms);
+
+    // Exercise
+    auto first = cache.read();
+    simulator.transactions = 0;
+    simulator.pressure = 0x62ED00;
+    clock.ticks = 100'000;
+    auto cached = cache.read();
+    auto cached_transactions = simulator.transactions;
+    clock.ticks = 100'001;
+    auto refreshed = cache.read();
+
+    // Verify
+    expect(first.has_value());
+    expect(that % 0x62F350U == cached.value().raw.pressure);
+    expect(that % 0U == cached.value().timestamp);
+    expect(that % 0U == cached_transactions);
+    expect(that % 0x62ED00U == refreshed.value().raw.pressure);
+    expect(that % 100'001U == refreshed.value().timestamp);
+    expect(that % 2U == cache.conversions());
+    expect(that % 1U == cache.coalesced());
+  };
+
+  "hal::mpl::sample_cache::try_read() coalesces readers"_test = []() {
+    // Setup
+    mpl3115a2_simulator simulator;
+    manual_clock clock;
+    auto device = mpl3115a2::create(simulator).value();
+    sample_cache cache(device, clock, 10ms);
+    simulator.conversion_reads = 8;
+    std::uint32_t polls = 0;
+
+    // Exercise
+    // Two readers take turns polling until the conversion completes
+    auto first = cache.try_read();
+    auto second = cache.try_read();
+    hal::result<std::optional<sample_cache::sample_t>> last = first;
+    while (!last.value().has_value() && polls < 20) {
+      last = cache.try_read();
+      polls++;
+    }
+    auto other = cache.try_read();
+
+    // Verify
+    expect(!first.value().has_value());
+    expect(!second.value().has_value());
+    expect(that % 20U > polls);
+    expect(other.value().has_value());
+    expect(that % 0x62F350U == other.value()->raw.pressure);
+    expect(that % 1U == cache.conversions());
+    expect(that % 1U == cache.coalesced());
+  };
+
+  "hal::mpl::sample_cache::read() waits on a started conversion"_test = []() {
+    // Setup
+    mpl3115a2_simulator simulator;
+    manual_clock clock;
+    auto device = mpl3115a2::create(simulator).value();
+    sample_cache cache(device, clock, 1ms);
+    simulator.conversion_reads = 3;
+
+    // Exercise
+    auto polled = cache.try_read();
+    clock.ticks = 5;
+    auto waited = cache.read();
+    cache.invalidate();
+    auto converted = cache.read();
+
+    // Verify
+    expect(!polled.value().has_value());
+    expect(waited.has_value());
+    // The sample dates from the trigger issued by try_read()
+    expect(that % 0U == waited.value().timestamp);
+    expect(that % 5U == converted.value().timestamp);
+    expect(that % 2U == cache.conversions());
+    expect(that % 1U == cache.coalesced());
+  };
+
+  "hal::mpl::sample_cache does not wait on an old conversion"_test = []() {
+    // Setup
+    mpl3115a2_simulator simulator;
+    manual_clock clock;
+    auto device = mpl3115a2::create(simulator).value();
+    sample_cache cache(device, clock, 10ms);
+    // Completes a conversion started 20 ms ago with the pressure of that
+    // time, then samples p_pressure
+    auto age = [&](std::uint32_t p_pressure) {
+      clock.ticks += 20'000;
+      simulator.convert();
+      simulator.pressure = p_pressure;
+      simulator.conversion_reads = 0;
+    };
+
+    // Exercise
+    simulator.conversion_reads = 1000;
+    auto polled = cache.try_read();
+    age(0x62ED00);
+    auto read = cache.read();
+    cache.invalidate();
+    simulator.conversion_reads = 1000;
+    (void)cache.try_read();
+    age(0x62E000);
+    auto polled_again = cache.try_read();
+
+    // Verify
+    expect(!polled.value().has_value());
+    expect(that % 0x62ED00U == read.value().raw.pressure);
+    expect(that % 20'000U == read.value().timestamp);
+    expect(that % 0x62E000U == polled_again.value()->raw.pressure);
+    expect(that % 40'000U == polled_again.value()->timestamp);
+    expect(that % 4U == cache.conversions());
+    expect(that % 0U == cache.coalesced());
+  };
+
+  "hal::mpl::sample_cache triggers again after a bus error"_test = []() {
+    // Setup
+    mpl3115a2_simulator simulator;
+    manual_clock clock;
+    auto device = mpl3115a2::create(simulator).value();
+    sample_cache cache(device, clock, 0ms);
+    // A brown-out resets the device, losing the conversion, and the next
+    // transaction is NACKed while it restarts
+    auto brown_out = [&simulator]() {
+      simulator.reset_nack_transactions = 1;
+      simulator.reset();
+    };
+    simulator.conversion_reads = 1000;
+
+    // Exercise
+    auto polled = cache.try_read();
+    brown_out();
+    auto polled_failure = cache.try_read();
+    simulator.conversion_reads = 0;
+    auto polled_recovery = cache.try_read();
+    simulator.conversion_reads = 1000;
+    cache.invalidate();
+    (void)cache.try_read();
+    brown_out();
+    auto read_failure = cache.read();
+    simulator.conversion_reads = 0;
+    auto read_recovery = cache.read();
+
+    // Verify
+    expect(!polled.value().has_value());
+    expect(!polled_failure.has_value());
+    expect(polled_recovery.value().has_value());
+    expect(!read_failure.has_value());
+    expect(read_recovery.has_value());
+    expect(that % 4U == cache.conversions());
+  };
+};
+}  // namespace hal::mpl
@@ -0,0 +1,91 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-mpl/sample_history.hpp>
+
+#include <boost/ut.hpp>
+
+namespace hal::mpl {
+void sample_history_test()
+{
+  using namespace boost::ut;
+
+  "hal::mpl::sample_history::at() interpolates"_test = []() {
+    // Setup
+    sample_history<4> history;
+    (void)history.push({ .timestamp = 100,
+                         .pressure = 101300.0f,
+                         .altitude = 10.0f,
+                         .temperature = 20.0f });
+    (void)history.push({ .timestamp = 200,
+                         .pressure = 101320.0f,
+                         .altitude = 8.0f,
+                         .temperature = 21.0f });
+
+    // Exercise
+    auto exact = history.at(100);
+    auto quarter = history.at(125);
+    auto newest = history.at(200);
+    auto before = history.at(99);
+    auto after = history.at(201);
+
+    // Verify
+    expect(that % 101300.0f == exact.value().pressure);
+    expect(that % 125U == quarter.value().timestamp);
+    expect(that % 101305.0f == quarter.value().pressure);
+    expect(that % 9.5f == quarter.value().altitude);
+    expect(that % 20.25f == quarter.value().temperature);
+    expect(that % 21.0f == newest.value().temperature);
+    expect(!before.has_value());
+    expect(!after.has_value());
+  };
+
+  "hal::mpl::sample_history wraps around"_test = []() {
+    // Setup
+    sample_history<4> history;
+
+    // Exercise
+    for (std::uint64_t i = 1; i <= 6; i++) {
+      (void)history.push({ .timestamp = i * 10,
+                           .pressure = static_cast<float>(i),
+                           .altitude = 0.0f,
+                           .temperature = 0.0f });
+    }
+    auto stale = history.push({ .timestamp = 60,
+                                .pressure = 0.0f,
+                                .altitude = 0.0f,
+                                .temperature = 0.0f });
+
+    // Verify
+    expect(!stale.has_value());
+    expect(that % 4U == history.size());
+    expect(that % 30U == history.oldest().value().timestamp);
+    expect(that % 60U == history.newest().value().timestamp);
+    expect(!history.at(29).has_value());
+    expect(that % 5.5f == history.at(55).value().pressure);
+    expect(that % 3.0f == history.at(30).value().pressure);
+  };
+
+  "hal::mpl::sample_history empty"_test = []() {
+    // Setup
+    sample_history<2> history;
+
+    // Exercise
+    // Verify
+    expect(!history.at(0).has_value());
+    expect(!history.oldest().has_value());
+    expect(!history.newest().has_value());
+  };
+};
+}  // namespace hal::mpl
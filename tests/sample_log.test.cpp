@@ -0,0 +1,43 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-mpl/sample_log.hpp>
+
+#include <boost/ut.hpp>
+
+namespace hal::mpl {
+void sample_log_test()
+{
+  using namespace boost::ut;
+
+  "hal::mpl::encode() & decode()"_test = []() {
+    // Setup
+    constexpr sample_record record{
+      .timestamp = 0x12345678,
+      .pressure = 0x62F350,
+      .temperature = -2368,
+    };
+
+    // Exercise
+    constexpr auto bytes = encode(record);
+    constexpr auto decoded = decode(bytes);
+
+    // Verify
+    expect(bytes[0] == 0x78 && bytes[3] == 0x12);
+    expect(bytes[4] == 0x50 && bytes[6] == 0x62 && bytes[7] == 0x00);
+    expect(bytes[8] == 0xC0 && bytes[9] == 0xF6);
+    expect(record == decoded);
+  };
+};
+}  // namespace hal::mpl
@@ -0,0 +1,194 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-mpl/shared_interrupt.hpp>
+
+#include <array>
+
+#include <boost/ut.hpp>
+
+#include "mpl3115a2_simulator.hpp"
+
+namespace hal::mpl {
+namespace {
+/// Active low wired-OR line driven by every simulator with a pending source
+class shared_line : public hal::input_pin
+{
+public:
+  explicit shared_line(std::span<mpl3115a2_simulator> p_devices)
+    : m_devices(p_devices)
+  {
+  }
+
+  std::uint32_t reads = 0;
+
+private:
+  status driver_configure(const settings&) override
+  {
+    return hal::success();
+  }
+
+  result<level_t> driver_level() override
+  {
+    reads++;
+    for (auto& device : m_devices) {
+      if (device.registers[int_source_r] != 0) {
+        return level_t{ .state = false };
+      }
+    }
+    return level_t{ .state = true };
+  }
+
+  std::span<mpl3115a2_simulator> m_devices;
+};
+}  // namespace
+
+void shared_interrupt_test()
+{
+  using namespace boost::ut;
+
+  constexpr auto drdy = mpl3115a2::interrupt::data_ready;
+
+  "hal::mpl::shared_interrupt services only devices that fired"_test = []() {
+    // Setup
+    std::array<mpl3115a2_simulator, 3> simulators{};
+    shared_line line(simulators);
+    std::array devices{ mpl3115a2::create(simulators[0]).value(),
+                        mpl3115a2::create(simulators[1]).value(),
+                        mpl3115a2::create(simulators[2]).value() };
+    shared_interrupt<3> dispatcher(&line);
+    std::array<int, 3> calls{};
+
+    for (std::size_t i = 0; i < devices.size(); i++) {
+      auto added = dispatcher.add(
+        devices[i], drdy, [&simulators, &calls, i](mpl3115a2&, hal::byte) {
+          calls[i]++;
+          simulators[i].registers[int_source_r] = 0;
+        });
+      expect(added.has_value());
+    }
+    for (auto& simulator : simulators) {
+      simulator.transactions = 0;
+    }
+    simulators[1].registers[int_source_r] = drdy;
+
+    // Exercise
+    auto before_notify = dispatcher.service();
+    dispatcher.notify();
+    auto serviced = dispatcher.service();
+
+    // Verify
+    expect(that % 0U == before_notify.value());
+    expect(that % 1U == serviced.value());
+    expect(calls == std::array{ 0, 1, 0 });
+    // Device 2 is never read because the line was released after device 1
+    expect(that % 1U == simulators[0].transactions);
+    expect(that % 1U == simulators[1].transactions);
+    expect(that % 0U == simulators[2].transactions);
+    expect(!dispatcher.pending());
+  };
+
+  "hal::mpl::shared_interrupt rescans for a device that fires again"_test =
+    []() {
+      // Setup
+      std::array<mpl3115a2_simulator, 3> simulators{};
+      shared_line line(simulators);
+      std::array devices{ mpl3115a2::create(simulators[0]).value(),
+                          mpl3115a2::create(simulators[1]).value(),
+                          mpl3115a2::create(simulators[2]).value() };
+      shared_interrupt<3> dispatcher(&line);
+      std::array<int, 3> calls{};
+      for (std::size_t i = 0; i < devices.size(); i++) {
+        (void)dispatcher.add(
+          devices[i], drdy, [&simulators, &calls, i](mpl3115a2&, hal::byte) {
+            calls[i]++;
+            simulators[i].registers[int_source_r] = 0;
+            if (i == 1 && calls[0] == 1) {
+              // Device 0 fires again while device 1 is serviced
+              simulators[0].registers[int_source_r] = drdy;
+            }
+          });
+      }
+      simulators[0].registers[int_source_r] = drdy;
+      simulators[1].registers[int_source_r] = drdy;
+
+      // Exercise
+      dispatcher.notify();
+      auto serviced = dispatcher.service();
+      simulators[2].registers[int_source_r] =
+        mpl3115a2::interrupt::pressure_change;
+      auto held = dispatcher.dispatch();
+
+      // Verify
+      expect(that % 3U == serviced.value());
+      expect(calls == std::array{ 2, 1, 0 });
+      // A source without a handler holds the line, the next service() retries
+      expect(that % 0U == held.value());
+      expect(dispatcher.pending());
+    };
+
+  "hal::mpl::shared_interrupt reads the busiest device first"_test = []() {
+    // Setup
+    std::array<mpl3115a2_simulator, 2> simulators{};
+    shared_line line(simulators);
+    std::array devices{ mpl3115a2::create(simulators[0]).value(),
+                        mpl3115a2::create(simulators[1]).value() };
+    shared_interrupt<2> dispatcher(&line);
+    for (std::size_t i = 0; i < devices.size(); i++) {
+      (void)dispatcher.add(
+        devices[i], drdy, [&simulators, i](mpl3115a2&, hal::byte) {
+          simulators[i].registers[int_source_r] = 0;
+        });
+    }
+
+    // Exercise
+    simulators[1].registers[int_source_r] = drdy;
+    (void)dispatcher.dispatch();
+    simulators[0].transactions = 0;
+    simulators[1].transactions = 0;
+    simulators[1].registers[int_source_r] = drdy;
+    auto serviced = dispatcher.dispatch();
+
+    // Verify
+    expect(that % 1U == serviced.value());
+    expect(that % 0U == simulators[0].transactions);
+    expect(that % 1U == simulators[1].transactions);
+  };
+
+  "hal::mpl::shared_interrupt without a line level checks every device"_test =
+    []() {
+      // Setup
+      std::array<mpl3115a2_simulator, 2> simulators{};
+      auto device0 = mpl3115a2::create(simulators[0]).value();
+      auto device1 = mpl3115a2::create(simulators[1]).value();
+      shared_interrupt<1> dispatcher;
+      hal::byte seen = 0;
+      (void)dispatcher.add(
+        device0, drdy, [&seen](mpl3115a2&, hal::byte p_sources) {
+          seen = p_sources;
+        });
+      simulators[0].registers[int_source_r] =
+        drdy | mpl3115a2::interrupt::pressure_change;
+
+      // Exercise
+      auto full = dispatcher.add(device1, drdy, [](mpl3115a2&, hal::byte) {});
+      auto serviced = dispatcher.dispatch();
+
+      // Verify
+      expect(!full.has_value());
+      expect(that % 1U == serviced.value());
+      expect(that % drdy == seen);
+    };
+};
+}  // namespace hal::mpl
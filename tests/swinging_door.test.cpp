@@ -0,0 +1,171 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-mpl/swinging_door.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include <boost/ut.hpp>
+
+namespace hal::mpl {
+namespace {
+using point = swinging_door::point;
+
+/// Compress `p_samples` and return every emitted point, flushed at the end
+std::vector<point> compress(swinging_door& p_door,
+                            const std::vector<point>& p_samples)
+{
+  std::vector<point> emitted;
+  for (const auto& sample : p_samples) {
+    if (auto output = p_door.update(sample)) {
+      emitted.push_back(*output);
+    }
+  }
+  if (auto output = p_door.flush()) {
+    emitted.push_back(*output);
+  }
+  return emitted;
+}
+
+/// Largest difference between a sample and its reconstruction
+float max_error(const std::vector<point>& p_samples,
+                const std::vector<point>& p_emitted)
+{
+  float worst = 0.0f;
+  std::size_t segment = 0;
+  for (const auto& sample : p_samples) {
+    while (segment + 2 < p_emitted.size() &&
+           p_emitted[segment + 1].timestamp < sample.timestamp) {
+      segment++;
+    }
+    auto value = sample.timestamp == p_emitted[segment].timestamp
+                   ? p_emitted[segment].value
+                   : swinging_door::interpolate(p_emitted[segment],
+                                                p_emitted[segment + 1],
+                                                sample.timestamp);
+    worst = std::max(worst, std::abs(value - sample.value));
+  }
+  return worst;
+}
+
+/// Stationary node: slow weather drift plus +-0.5 Pa of noise at 1 Hz
+std::vector<point> quiet_day(std::size_t p_count)
+{
+  std::vector<point> samples;
+  std::uint32_t state = 1;
+  for (std::size_t i = 0; i < p_count; i++) {
+    state = state * 1664525 + 1013904223;
+    auto noise = static_cast<float>(state >> 8) / float(1 << 24) - 0.5f;
+    auto drift = 30.0f * std::sin(static_cast<float>(i) / 6000.0f);
+    samples.push_back({ .timestamp = 1'000'000 * i,
+                        .value = 101325.0f + drift + noise });
+  }
+  return samples;
+}
+}  // namespace
+
+void swinging_door_test()
+{
+  using namespace boost::ut;
+
+  "hal::mpl::swinging_door emits the ends of a constant stream"_test = []() {
+    // Setup
+    swinging_door door({ .tolerance = 1.0f });
+    std::vector<point> samples;
+    for (std::uint64_t i = 0; i < 100; i++) {
+      samples.push_back({ .timestamp = i, .value = 101325.0f });
+    }
+
+    // Exercise
+    auto emitted = compress(door, samples);
+
+    // Verify
+    expect(that % 2U == emitted.size());
+    expect(that % 0U == emitted.front().timestamp);
+    expect(that % 99U == emitted.back().timestamp);
+    expect(that % 101325.0f == emitted.back().value);
+  };
+
+  "hal::mpl::swinging_door stays within tolerance"_test = []() {
+    // Setup
+    constexpr float tolerance = 1.0f;
+    swinging_door door({ .tolerance = tolerance });
+    auto samples = quiet_day(20'000);
+
+    // Exercise
+    auto emitted = compress(door, samples);
+
+    // Verify
+    // Allow for the float resolution of sea level pressure
+    expect(max_error(samples, emitted) <= tolerance + 0.02f);
+    expect(emitted.size() * 10 < samples.size())
+      << "emitted" << emitted.size();
+  };
+
+  "hal::mpl::swinging_door follows a step"_test = []() {
+    // Setup
+    swinging_door door({ .tolerance = 1.0f });
+    std::vector<point> samples;
+    for (std::uint64_t i = 0; i < 20; i++) {
+      samples.push_back(
+        { .timestamp = i, .value = i < 10 ? 100.0f : 150.0f });
+    }
+
+    // Exercise
+    auto emitted = compress(door, samples);
+
+    // Verify
+    expect(that % 4U == emitted.size());
+    expect(max_error(samples, emitted) <= 1.0f);
+  };
+
+  "hal::mpl::swinging_door emits every max_interval"_test = []() {
+    // Setup
+    swinging_door door({ .tolerance = 1.0f, .max_interval = 10 });
+    std::vector<point> samples;
+    for (std::uint64_t i = 0; i <= 100; i++) {
+      samples.push_back({ .timestamp = i, .value = 20.0f });
+    }
+
+    // Exercise
+    auto emitted = compress(door, samples);
+
+    // Verify
+    expect(that % 11U == emitted.size());
+    for (std::size_t i = 1; i < emitted.size(); i++) {
+      expect(emitted[i].timestamp - emitted[i - 1].timestamp <= 10U);
+    }
+  };
+
+  "hal::mpl::swinging_door ignores samples out of order"_test = []() {
+    // Setup
+    swinging_door door({ .tolerance = 1.0f });
+    (void)door.update({ .timestamp = 10, .value = 5.0f });
+    (void)door.update({ .timestamp = 20, .value = 5.0f });
+
+    // Exercise
+    auto stale = door.update({ .timestamp = 20, .value = 50.0f });
+    auto older = door.update({ .timestamp = 15, .value = 50.0f });
+    auto flushed = door.flush();
+
+    // Verify
+    expect(!stale.has_value());
+    expect(!older.has_value());
+    expect(that % 20U == flushed.value().timestamp);
+    expect(that % 5.0f == flushed.value().value);
+  };
+};
+}  // namespace hal::mpl
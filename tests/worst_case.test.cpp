@@ -0,0 +1,367 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <libhal-mpl/configuration.hpp>
+#include <libhal-mpl/mpl3115a2.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <optional>
+
+#include <boost/ut.hpp>
+
+#include "mpl3115a2_simulator.hpp"
+
+namespace hal::mpl {
+namespace {
+using namespace std::chrono_literals;
+
+/**
+ * The worst case specification of each API. Each bound is derived from the
+ * transactions the driver issues, with `n` polling reads allowed per wait:
+ *
+ *   register read (1 byte)  39 bits    register write (1 byte)  29 bits
+ *   register read (2 bytes) 48 bits    register write (2 bytes) 38 bits
+ *   register read (3 bytes) 57 bits    register write (3 bytes) 47 bits
+ *   register read (5 bytes) 75 bits    register write (4 bytes) 56 bits
+ *   register read (k bytes) 30 + 9k    register write (k bytes) 20 + 9k
+ *   NACKed address          11 bits
+ *
+ * If a change makes any API exceed its bound, these tests fail. Lower the
+ * bounds when the driver improves.
+ */
+constexpr std::uint64_t n = mpl3115a2::default_max_polling_retries;
+
+struct bound
+{
+  std::uint64_t transactions;
+  std::uint64_t bus_bits;
+};
+
+// whoami + reset (read, write) + n reset polls + CTRL_REG1 write +
+// PT_DATA_CFG write
+constexpr bound create_bound{ n + 5, 39 + 68 + 39 * n + 29 + 29 };
+// OST wait + OST set (read, write) + status wait + 2 byte data read
+constexpr bound read_temperature_bound{ 2 * n + 3, 78 * n + 68 + 48 };
+// mode switch (read, write) + OST wait + OST set + status wait + 3 byte read
+constexpr bound read_pressure_bound{ 2 * n + 5, 68 + 78 * n + 68 + 57 };
+constexpr bound read_altitude_bound = read_pressure_bound;
+constexpr bound single_write_bound{ 1, 47 };
+constexpr bound single_read_bound{ 1, 39 };
+// mode switch (read, write) + OST wait + OST set (read, write)
+constexpr bound trigger_conversion_bound{ n + 4, 68 + 39 * n + 68 };
+// status wait + OUT_P/OUT_T burst
+constexpr bound read_sample_bound{ n + 1, 39 * n + 75 };
+// status read + OUT_P/OUT_T burst
+constexpr bound try_read_sample_bound{ 2, 39 + 75 };
+// F_STATUS read + every sample of a full FIFO in one F_DATA burst
+constexpr bound read_fifo_bound{
+  2,
+  39 + 30 + 9 * mpl3115a2::fifo_capacity * mpl3115a2::fifo_sample_size
+};
+// standby from active + CTRL_REG1 (standby) + F_SETUP disabled + F_SETUP +
+// PT_DATA_CFG + CTRL_REG2-5 + CTRL_REG1 (active)
+constexpr bound configure_bound{ 7, 29 * 6 + 56 };
+// standby from active + CTRL_REG1-5 + CTRL_REG1 (active)
+constexpr bound apply_bound{ 3, 29 + 65 + 29 };
+// PT_DATA_CFG through OFF_H + F_SETUP
+constexpr bound resume_bound{ 2, 30 + 9 * (0x2D - 0x13 + 1) + 39 };
+
+constexpr auto circular_fifo = make_configuration<{
+  .acquire = acquisition::fifo,
+  .fifo = fifo_mode::circular,
+}>();
+constexpr auto stop_fifo = make_configuration<{
+  .acquire = acquisition::fifo,
+  .fifo = fifo_mode::stop,
+}>();
+
+struct adversary
+{
+  std::uint32_t stuck_ost_reads;
+  std::uint32_t conversion_reads;
+  std::uint32_t reset_nack_transactions;
+  /// Perform one good read in this mode before the measured call, so mode
+  /// switches and stale data ready flags are covered.
+  std::optional<mpl3115a2::mode> warm_up;
+};
+
+/// Every combination of timing that finishes on the first read, finishes on
+/// the last allowed read or never finishes within the retry limit.
+constexpr auto adversaries = []() {
+  constexpr std::array<std::uint32_t, 3> ost{ 0, n - 1, n };
+  constexpr std::array<std::uint32_t, 4> conversion{ 0, 1, n, n + 1 };
+  constexpr std::array<std::uint32_t, 3> reset{ 0, n - 1, n };
+  std::array<adversary, ost.size() * conversion.size() * reset.size() * 3>
+    result{};
+  std::size_t i = 0;
+  for (auto ost_reads : ost) {
+    for (auto conversion_reads : conversion) {
+      for (auto reset_transactions : reset) {
+        for (auto warm_up : { std::optional<mpl3115a2::mode>{},
+                              std::optional{ mpl3115a2::mode::barometer },
+                              std::optional{ mpl3115a2::mode::altimeter } }) {
+          result[i++] = { ost_reads, conversion_reads, reset_transactions,
+                          warm_up };
+        }
+      }
+    }
+  }
+  return result;
+}();
+
+/**
+ * @brief Run an API against every adversary and return the most expensive
+ * call observed.
+ *
+ * `p_setup` runs once the adversary is in place and before the measured
+ * call, e.g. to trigger the conversion that the call waits for.
+ */
+template<class Api, class Setup>
+bound measure(Api p_api, Setup p_setup)
+{
+  bound worst{ 0, 0 };
+
+  for (const auto& timing : adversaries) {
+    mpl3115a2_simulator simulator;
+    simulator.reset_nack_transactions = timing.reset_nack_transactions;
+
+    auto device = mpl3115a2::create(simulator);
+    if (!device) {
+      continue;
+    }
+    if (timing.warm_up == mpl3115a2::mode::barometer) {
+      (void)device.value().read_pressure();
+    } else if (timing.warm_up == mpl3115a2::mode::altimeter) {
+      (void)device.value().read_altitude();
+    }
+
+    simulator.stuck_ost_reads = timing.stuck_ost_reads;
+    simulator.conversion_reads = timing.conversion_reads;
+    p_setup(device.value(), simulator);
+    simulator.transactions = 0;
+    simulator.bus_bits = 0;
+
+    (void)p_api(device.value());
+
+    worst.transactions =
+      std::max<std::uint64_t>(worst.transactions, simulator.transactions);
+    worst.bus_bits = std::max(worst.bus_bits, simulator.bus_bits);
+  }
+
+  return worst;
+}
+
+template<class Api>
+bound measure(Api p_api)
+{
+  return measure(p_api, [](mpl3115a2&, mpl3115a2_simulator&) {});
+}
+}  // namespace
+
+void worst_case_test()
+{
+  using namespace boost::ut;
+
+  "mpl3115a2::create() worst case"_test = []() {
+    bound worst{ 0, 0 };
+    for (const auto& timing : adversaries) {
+      mpl3115a2_simulator simulator;
+      simulator.reset_nack_transactions = timing.reset_nack_transactions;
+      (void)mpl3115a2::create(simulator);
+      worst.transactions =
+        std::max<std::uint64_t>(worst.transactions, simulator.transactions);
+      worst.bus_bits = std::max(worst.bus_bits, simulator.bus_bits);
+    }
+
+    expect(that % create_bound.transactions == worst.transactions);
+    expect(le(worst.bus_bits, create_bound.bus_bits));
+  };
+
+  "mpl3115a2::read_temperature() worst case"_test = []() {
+    auto worst = measure([](mpl3115a2& p_device) {
+      return p_device.read_temperature();
+    });
+
+    expect(that % read_temperature_bound.transactions == worst.transactions);
+    expect(that % read_temperature_bound.bus_bits == worst.bus_bits);
+  };
+
+  "mpl3115a2::read_pressure() worst case"_test = []() {
+    auto worst = measure([](mpl3115a2& p_device) {
+      return p_device.read_pressure();
+    });
+
+    expect(that % read_pressure_bound.transactions == worst.transactions);
+    expect(that % read_pressure_bound.bus_bits == worst.bus_bits);
+  };
+
+  "mpl3115a2::read_altitude() worst case"_test = []() {
+    auto worst = measure([](mpl3115a2& p_device) {
+      return p_device.read_altitude();
+    });
+
+    expect(that % read_altitude_bound.transactions == worst.transactions);
+    expect(that % read_altitude_bound.bus_bits == worst.bus_bits);
+  };
+
+  "mpl3115a2 register access APIs worst case"_test = []() {
+    auto sea_pressure = measure([](mpl3115a2& p_device) {
+      return p_device.set_sea_pressure(101325.0f);
+    });
+    auto offset = measure([](mpl3115a2& p_device) {
+      return p_device.set_altitude_offset(-10);
+    });
+    auto target = measure([](mpl3115a2& p_device) {
+      return p_device.set_pressure_target(90000.0f);
+    });
+    auto interrupts = measure([](mpl3115a2& p_device) {
+      return p_device.configure_interrupts({});
+    });
+    auto source = measure([](mpl3115a2& p_device) {
+      return p_device.read_interrupt_source();
+    });
+
+    for (const auto& worst : { sea_pressure, offset, target, interrupts }) {
+      expect(le(worst.transactions, single_write_bound.transactions));
+      expect(le(worst.bus_bits, single_write_bound.bus_bits));
+    }
+    expect(le(source.transactions, single_read_bound.transactions));
+    expect(le(source.bus_bits, single_read_bound.bus_bits));
+  };
+
+  "mpl3115a2 triggered conversion APIs worst case"_test = []() {
+    auto trigger = [](mpl3115a2& p_device, mpl3115a2_simulator&) {
+      (void)p_device.trigger_conversion(mpl3115a2::mode::barometer);
+    };
+
+    auto triggered = measure([](mpl3115a2& p_device) {
+      return p_device.trigger_conversion(mpl3115a2::mode::barometer);
+    });
+    auto waited = measure(
+      [](mpl3115a2& p_device) { return p_device.read_sample(); }, trigger);
+    auto polled = measure(
+      [](mpl3115a2& p_device) { return p_device.try_read_sample(); }, trigger);
+
+    expect(that % trigger_conversion_bound.transactions ==
+           triggered.transactions);
+    expect(that % trigger_conversion_bound.bus_bits == triggered.bus_bits);
+    expect(that % read_sample_bound.transactions == waited.transactions);
+    expect(that % read_sample_bound.bus_bits == waited.bus_bits);
+    expect(that % try_read_sample_bound.transactions == polled.transactions);
+    expect(that % try_read_sample_bound.bus_bits == polled.bus_bits);
+  };
+
+  "mpl3115a2::read_fifo() worst case"_test = []() {
+    auto worst = measure(
+      [](mpl3115a2& p_device) {
+        std::array<mpl3115a2::raw_sample_t, mpl3115a2::fifo_capacity> samples{};
+        return p_device.read_fifo(samples);
+      },
+      [](mpl3115a2& p_device, mpl3115a2_simulator& p_simulator) {
+        (void)p_device.configure(circular_fifo);
+        p_simulator.fifo.assign(
+          mpl3115a2::fifo_capacity * mpl3115a2::fifo_sample_size, 0x55);
+      });
+
+    expect(that % read_fifo_bound.transactions == worst.transactions);
+    expect(that % read_fifo_bound.bus_bits == worst.bus_bits);
+  };
+
+  "mpl3115a2 configuration APIs worst case"_test = []() {
+    constexpr auto first = make_profile<{
+      .oversampling = oversampling_ratio::os2,
+      .acquire = acquisition::continuous,
+    }>();
+    constexpr auto second = make_profile<{
+      .acquire = acquisition::continuous,
+    }>();
+
+    // A FIFO mode change from active acquisition writes every register
+    auto configured = measure(
+      [](mpl3115a2& p_device) { return p_device.configure(stop_fifo); },
+      [](mpl3115a2& p_device, mpl3115a2_simulator&) {
+        (void)p_device.configure(circular_fifo);
+      });
+    auto applied = measure(
+      [&second](mpl3115a2& p_device) { return p_device.apply(second); },
+      [&first](mpl3115a2& p_device, mpl3115a2_simulator&) {
+        (void)p_device.apply(first);
+      });
+
+    expect(that % configure_bound.transactions == configured.transactions);
+    expect(that % configure_bound.bus_bits == configured.bus_bits);
+    expect(that % apply_bound.transactions == applied.transactions);
+    expect(that % apply_bound.bus_bits == applied.bus_bits);
+  };
+
+  "mpl3115a2::resume() worst case"_test = []() {
+    // Setup
+    // FIFO acquisition adds the F_SETUP check to the register burst
+    mpl3115a2_simulator simulator;
+    auto snapshot =
+      mpl3115a2::create(simulator, circular_fifo).value().snapshot();
+    simulator.transactions = 0;
+    simulator.bus_bits = 0;
+
+    // Exercise
+    auto resumed = mpl3115a2::resume(simulator, snapshot);
+
+    // Verify
+    expect(resumed.has_value());
+    expect(that % resume_bound.transactions == simulator.transactions);
+    expect(that % resume_bound.bus_bits == simulator.bus_bits);
+  };
+
+  "mpl3115a2 exhausted polling reports an error"_test = []() {
+    // Setup
+    mpl3115a2_simulator simulator;
+    auto device = mpl3115a2::create(simulator).value();
+    simulator.conversion_reads = n + 1;
+
+    // Exercise
+    auto pressure = device.read_pressure();
+
+    // Verify
+    expect(!pressure.has_value());
+  };
+
+  "mpl3115a2 worst case modeled bus time at 100kHz"_test = []() {
+    // Setup
+    // The slowest read that still succeeds: a mode switch, a stuck OST bit
+    // and a conversion that finishes on the last allowed status read. The
+    // device also stays busy after reset for almost the whole retry limit.
+    mpl3115a2_simulator simulator;
+    simulator.reset_nack_transactions = n - 1;
+    auto device = mpl3115a2::create(simulator).value();
+    auto create_time = simulator.bus_time(100'000.0f);
+    (void)device.read_altitude();
+    simulator.stuck_ost_reads = n - 1;
+    simulator.conversion_reads = n;
+    simulator.bus_bits = 0;
+
+    // Exercise
+    auto pressure = device.read_pressure();
+    auto read_time = simulator.bus_time(100'000.0f);
+
+    // Verify
+    expect(pressure.has_value());
+    expect(le(create_time, 3'905'000us));
+    expect(le(read_time, 7'802'000us));
+    // Within 1% of the bound, so the scenario above really is worst case
+    expect(gt(read_time, 7'724'000us));
+  };
+};
+}  // namespace hal::mpl
@@ -0,0 +1,294 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+#include <vector>
+
+#include <libhal-mpl/configuration.hpp>
+#include <libhal-mpl/mpl3115a2.hpp>
+#include <libhal-mpl/polling.hpp>
+
+#include "mpl3115a2_simulator.hpp"
+
+namespace {
+using namespace hal::mpl;
+using namespace std::chrono_literals;
+
+struct options
+{
+  std::size_t samples = 256;
+  hal::hertz i2c_clock = 400'000.0f;
+  /// Supply voltage of the MCU and device
+  double supply_volts = 3.3;
+  /// MCU current while running, including while blocked on I2C transfers
+  double run_amps = 5e-3;
+  /// MCU current while sleeping between conversions
+  double sleep_amps = 5e-6;
+};
+
+struct run_result
+{
+  std::string_view strategy;
+  std::string_view oversampling;
+  std::size_t samples = 0;
+  std::uint64_t transactions = 0;
+  std::uint64_t bytes = 0;
+  /// Modeled time the bus was busy, the MCU runs while transfers block
+  double bus_seconds = 0.0;
+  /// Modeled time the MCU slept waiting for conversions
+  double sleep_seconds = 0.0;
+  /// Host CPU time spent in the driver and simulator
+  double host_seconds = 0.0;
+  /// Charge drawn by the device for its conversions
+  double device_coulombs = 0.0;
+};
+
+/// Simulated device plus a modeled clock that advances with bus traffic and
+/// requested sleeps
+struct bench
+{
+  mpl3115a2_simulator simulator;
+  double sleep_seconds = 0.0;
+
+  /// Sleep, at the end of which the conversion in progress has completed
+  auto sleeper()
+  {
+    return [this](hal::time_duration p_duration) {
+      sleep_seconds += std::chrono::duration<double>(p_duration).count();
+      simulator.convert();
+    };
+  }
+};
+
+/**
+ * @brief Charge drawn per conversion from the datasheet integrated current at
+ * one update per second
+ */
+constexpr double conversion_coulombs(oversampling_ratio p_ratio)
+{
+  switch (p_ratio) {
+    case oversampling_ratio::os1:
+      return 8.5e-6;
+    case oversampling_ratio::os16:
+      return 40e-6;
+    case oversampling_ratio::os128:
+      return 265e-6;
+    default:
+      return std::nan("");
+  }
+}
+
+template<oversampling_ratio Ratio>
+void run_oversampling(std::string_view p_name,
+                      const options& p_options,
+                      std::vector<run_result>& p_results)
+{
+  constexpr auto one_shot = make_configuration<{
+    .mode = mpl3115a2::mode::barometer,
+    .oversampling = Ratio,
+  }>();
+  constexpr auto continuous = make_configuration<{
+    .mode = mpl3115a2::mode::barometer,
+    .oversampling = Ratio,
+    .acquire = acquisition::continuous,
+  }>();
+  constexpr std::size_t watermark = 16;
+  constexpr auto fifo = make_configuration<{
+    .mode = mpl3115a2::mode::barometer,
+    .oversampling = Ratio,
+    .acquire = acquisition::fifo,
+    .fifo = fifo_mode::stop,
+    .fifo_watermark = watermark,
+    .interrupts = {
+      .enabled = mpl3115a2::interrupt::fifo,
+      .route_to_int1 = mpl3115a2::interrupt::fifo,
+    },
+  }>();
+
+  // A status poll is a 1 byte write then a 1 byte read: 39 bit times
+  auto poll_seconds = 39.0 / static_cast<double>(p_options.i2c_clock);
+  auto busy_polls = static_cast<std::uint32_t>(std::ceil(
+    std::chrono::duration<double>(one_shot.conversion_time).count() /
+    poll_seconds));
+
+  auto run = [&](std::string_view p_strategy,
+                 const configuration& p_configuration,
+                 auto&& p_workload) {
+    bench state;
+    auto device =
+      mpl3115a2::create(state.simulator, p_configuration).value();
+    state.simulator.transactions = 0;
+    state.simulator.bytes = 0;
+    state.simulator.bus_bits = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    auto samples = p_workload(state, device);
+    auto host = std::chrono::steady_clock::now() - start;
+
+    auto bus = state.simulator.bus_time(p_options.i2c_clock);
+    p_results.push_back(run_result{
+      .strategy = p_strategy,
+      .oversampling = p_name,
+      .samples = samples,
+      .transactions = state.simulator.transactions,
+      .bytes = state.simulator.bytes,
+      .bus_seconds = std::chrono::duration<double>(bus).count(),
+      .sleep_seconds = state.sleep_seconds,
+      .host_seconds = std::chrono::duration<double>(host).count(),
+      .device_coulombs =
+        conversion_coulombs(Ratio) * static_cast<double>(samples),
+    });
+  };
+
+  run("one_shot/poll", one_shot, [&](bench& p_bench, mpl3115a2& p_device) {
+    // The driver reads the status register until the conversion completes
+    p_bench.simulator.conversion_reads = busy_polls;
+    polling::immediate policy;
+    for (std::size_t i = 0; i < p_options.samples; i++) {
+      (void)p_device.trigger_conversion(mpl3115a2::mode::barometer);
+      (void)read_sample(p_device, policy, UINT16_MAX).value();
+    }
+    return p_options.samples;
+  });
+
+  run("one_shot/sleep", one_shot, [&](bench& p_bench, mpl3115a2& p_device) {
+    polling::expected_time policy(p_bench.sleeper());
+    for (std::size_t i = 0; i < p_options.samples; i++) {
+      (void)p_device.trigger_conversion(mpl3115a2::mode::barometer);
+      (void)read_sample(p_device, policy).value();
+    }
+    return p_options.samples;
+  });
+
+  run("continuous", continuous, [&](bench& p_bench, mpl3115a2& p_device) {
+    auto sleep = p_bench.sleeper();
+    for (std::size_t i = 0; i < p_options.samples; i++) {
+      // Sleep until the next auto-acquisition time step
+      sleep(continuous.sample_period);
+      (void)p_device.read_sample().value();
+    }
+    return p_options.samples;
+  });
+
+  run("fifo", fifo, [&](bench& p_bench, mpl3115a2& p_device) {
+    auto sleep = p_bench.sleeper();
+    std::array<mpl3115a2::raw_sample_t, watermark> buffer{};
+    std::size_t collected = 0;
+    while (collected < p_options.samples) {
+      // Sleep until the watermark interrupt
+      for (std::size_t i = 0; i < watermark; i++) {
+        sleep(fifo.sample_period);
+      }
+      collected += p_device.read_fifo(buffer).value().samples.size();
+    }
+    return collected;
+  });
+}
+
+void print_results(const std::vector<run_result>& p_results,
+                   const options& p_options)
+{
+  std::printf("%-15s %-6s %10s %9s %9s %9s %12s %12s\n",
+              "strategy",
+              "osr",
+              "samples/s",
+              "txn/smp",
+              "bytes/smp",
+              "bus_us/smp",
+              "host_ns/smp",
+              "energy_uJ/smp");
+
+  for (const auto& result : p_results) {
+    auto samples = static_cast<double>(result.samples);
+    auto elapsed = result.bus_seconds + result.sleep_seconds;
+    auto charge = p_options.run_amps * result.bus_seconds +
+                  p_options.sleep_amps * result.sleep_seconds +
+                  result.device_coulombs;
+    auto energy = p_options.supply_volts * charge;
+
+    std::printf("%-15.*s %-6.*s %10.3f %9.2f %9.2f %9.1f %12.1f %12.2f\n",
+                static_cast<int>(result.strategy.size()),
+                result.strategy.data(),
+                static_cast<int>(result.oversampling.size()),
+                result.oversampling.data(),
+                samples / elapsed,
+                static_cast<double>(result.transactions) / samples,
+                static_cast<double>(result.bytes) / samples,
+                result.bus_seconds * 1e6 / samples,
+                result.host_seconds * 1e9 / samples,
+                energy * 1e6 / samples);
+  }
+}
+
+void print_usage(const char* p_program)
+{
+  std::fprintf(stderr,
+               "usage: %s [--samples N] [--i2c-hz F] [--volts V] [--run-ma I] "
+               "[--sleep-ua I]\n"
+               "  --samples N   samples per strategy (default 256)\n"
+               "  --i2c-hz F    I2C clock rate (default 400000)\n"
+               "  --volts V     supply voltage (default 3.3)\n"
+               "  --run-ma I    MCU run current in mA (default 5)\n"
+               "  --sleep-ua I  MCU sleep current in uA (default 5)\n",
+               p_program);
+}
+}  // namespace
+
+int main(int p_argc, char** p_argv)
+{
+  options settings;
+
+  for (int i = 1; i < p_argc; i++) {
+    std::string_view argument(p_argv[i]);
+    if (i + 1 >= p_argc) {
+      print_usage(p_argv[0]);
+      return EXIT_FAILURE;
+    }
+    if (argument == "--samples") {
+      settings.samples = std::strtoul(p_argv[++i], nullptr, 10);
+    } else if (argument == "--i2c-hz") {
+      settings.i2c_clock = std::strtof(p_argv[++i], nullptr);
+    } else if (argument == "--volts") {
+      settings.supply_volts = std::strtod(p_argv[++i], nullptr);
+    } else if (argument == "--run-ma") {
+      settings.run_amps = std::strtod(p_argv[++i], nullptr) / 1e3;
+    } else if (argument == "--sleep-ua") {
+      settings.sleep_amps = std::strtod(p_argv[++i], nullptr) / 1e6;
+    } else {
+      print_usage(p_argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (settings.samples == 0 || settings.i2c_clock <= 0.0f) {
+    print_usage(p_argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  // The datasheet gives the device supply current for these ratios
+  std::vector<run_result> results;
+  run_oversampling<oversampling_ratio::os1>("os1", settings, results);
+  run_oversampling<oversampling_ratio::os16>("os16", settings, results);
+  run_oversampling<oversampling_ratio::os128>("os128", settings, results);
+
+  print_results(results, settings);
+
+  return EXIT_SUCCESS;
+}
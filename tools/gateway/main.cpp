@@ -0,0 +1,367 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <libhal-mpl/conversion.hpp>
+#include <libhal-mpl/mpsc_queue.hpp>
+#include <libhal-mpl/sample_log.hpp>
+
+#include "statistics.hpp"
+
+namespace {
+using namespace hal::mpl;
+using namespace hal::mpl::tools;
+
+/// Records decoded from one node, the unit handed between threads
+struct sample_batch
+{
+  static constexpr std::size_t max_records = 64;
+
+  std::uint32_t node = 0;
+  std::uint32_t count = 0;
+  std::array<sample_record, max_records> records{};
+};
+
+constexpr std::size_t queue_capacity = 256;
+
+using lock_free_queue = mpsc_queue<sample_batch, queue_capacity>;
+
+/// The mutex protected queue the gateway used before, kept as the benchmark
+/// baseline
+class locked_queue
+{
+public:
+  bool try_push(const sample_batch& p_batch)
+  {
+    std::scoped_lock lock(m_lock);
+    if (m_batches.size() == queue_capacity) {
+      return false;
+    }
+    m_batches.push_back(p_batch);
+    return true;
+  }
+
+  std::optional<sample_batch> try_pop()
+  {
+    std::scoped_lock lock(m_lock);
+    if (m_batches.empty()) {
+      return std::nullopt;
+    }
+    auto batch = m_batches.front();
+    m_batches.pop_front();
+    return batch;
+  }
+
+private:
+  std::mutex m_lock;
+  std::deque<sample_batch> m_batches;
+};
+
+/**
+ * @brief Reassembles sample records from a byte stream that arrives in
+ * arbitrary chunks and pushes them to the queue in batches
+ */
+template<typename Queue>
+class stream_decoder
+{
+public:
+  stream_decoder(Queue& p_queue, std::uint32_t p_node)
+    : m_queue(&p_queue)
+  {
+    m_batch.node = p_node;
+  }
+
+  void feed(std::span<const hal::byte> p_bytes)
+  {
+    while (!p_bytes.empty()) {
+      auto take = std::min(p_bytes.size(), sample_record_size - m_partial);
+      std::copy_n(p_bytes.begin(), take, m_frame.begin() + m_partial);
+      m_partial += take;
+      p_bytes = p_bytes.subspan(take);
+
+      if (m_partial == sample_record_size) {
+        m_batch.records[m_batch.count++] = decode(m_frame);
+        m_partial = 0;
+        if (m_batch.count == sample_batch::max_records) {
+          flush();
+        }
+      }
+    }
+  }
+
+  /// Push the records decoded so far, waiting while the queue is full
+  void flush()
+  {
+    if (m_batch.count == 0) {
+      return;
+    }
+    while (!m_queue->try_push(m_batch)) {
+      std::this_thread::yield();
+    }
+    m_batch.count = 0;
+  }
+
+  /// Bytes of an incomplete record at the end of the stream
+  [[nodiscard]] std::size_t partial() const
+  {
+    return m_partial;
+  }
+
+private:
+  Queue* m_queue;
+  sample_batch m_batch{};
+  std::array<hal::byte, sample_record_size> m_frame{};
+  std::size_t m_partial = 0;
+};
+
+struct node_summary
+{
+  std::string source;
+  bool readable = true;
+  statistics pressure;
+  std::uint32_t last_timestamp = 0;
+  std::size_t out_of_order = 0;
+};
+
+/**
+ * @brief Pop batches on the calling thread until every producer finished and
+ * the queue is drained
+ */
+template<typename Queue>
+void consume(Queue& p_queue,
+             const std::atomic<std::size_t>& p_running,
+             std::span<node_summary> p_nodes)
+{
+  while (true) {
+    auto batch = p_queue.try_pop();
+    if (!batch) {
+      if (p_running.load(std::memory_order_acquire) == 0) {
+        // Producers are done, take anything pushed before they finished
+        batch = p_queue.try_pop();
+        if (!batch) {
+          return;
+        }
+      } else {
+        std::this_thread::yield();
+        continue;
+      }
+    }
+
+    auto& node = p_nodes[batch->node];
+    for (const auto& record :
+         std::span(batch->records).first(batch->count)) {
+      if (node.pressure.count != 0 && record.timestamp < node.last_timestamp) {
+        node.out_of_order++;
+      }
+      node.last_timestamp = record.timestamp;
+      node.pressure.add(to_pascals(record.pressure));
+    }
+  }
+}
+
+int ingest(std::span<const std::string> p_paths)
+{
+  lock_free_queue queue;
+  std::vector<node_summary> nodes(p_paths.size());
+  std::vector<std::size_t> truncated(p_paths.size());
+  std::atomic<std::size_t> running = p_paths.size();
+  std::vector<std::thread> producers;
+
+  auto start = std::chrono::steady_clock::now();
+  for (std::uint32_t node = 0; node < p_paths.size(); node++) {
+    nodes[node].source = p_paths[node];
+    producers.emplace_back([&, node]() {
+      // Works for regular files as well as named pipes fed by a receiver
+      std::ifstream stream(p_paths[node], std::ios::binary);
+      // Only this producer writes its flag and it is read after the join
+      nodes[node].readable = stream.is_open();
+      stream_decoder decoder(queue, node);
+      std::array<char, 4096> chunk{};
+      while (stream.read(chunk.data(), chunk.size()) || stream.gcount() > 0) {
+        auto bytes = std::as_bytes(
+          std::span(chunk).first(static_cast<std::size_t>(stream.gcount())));
+        decoder.feed(std::span(
+          reinterpret_cast<const hal::byte*>(bytes.data()), bytes.size()));
+      }
+      decoder.flush();
+      truncated[node] = decoder.partial();
+      running.fetch_sub(1, std::memory_order_release);
+    });
+  }
+
+  consume(queue, running, nodes);
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  auto seconds = std::chrono::duration<double>(
+                   std::chrono::steady_clock::now() - start)
+                   .count();
+
+  std::size_t total = 0;
+  std::size_t unreadable = 0;
+  for (std::size_t i = 0; i < nodes.size(); i++) {
+    const auto& node = nodes[i];
+    if (!node.readable) {
+      std::printf("%s: unreadable\n", node.source.c_str());
+      unreadable++;
+      continue;
+    }
+    total += node.pressure.count;
+    std::printf("%s: samples=%zu pressure_pa[mean=%.2f min=%.2f max=%.2f] "
+                "out_of_order=%zu truncated=%zuB\n",
+                node.source.c_str(),
+                node.pressure.count,
+                node.pressure.mean,
+                node.pressure.min,
+                node.pressure.max,
+                node.out_of_order,
+                truncated[i]);
+  }
+  std::printf("total: samples=%zu records_per_s=%.0f\n",
+              total,
+              static_cast<double>(total) / seconds);
+
+  return unreadable == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * @brief Records per second through a queue with `p_producers` threads
+ * decoding synthetic streams of `p_records` records each
+ */
+template<typename Queue>
+double measure(std::size_t p_producers, std::size_t p_records)
+{
+  // One shared stream, every producer decodes its own pass over it
+  std::vector<hal::byte> stream;
+  stream.reserve(p_records * sample_record_size);
+  for (std::uint32_t i = 0; i < p_records; i++) {
+    auto bytes = encode({ .timestamp = i,
+                          .pressure = 0x62F350 + ((i % 64) << 4),
+                          .temperature = 0x1940 });
+    stream.insert(stream.end(), bytes.begin(), bytes.end());
+  }
+
+  Queue queue;
+  std::vector<node_summary> nodes(p_producers);
+  std::atomic<std::size_t> running = p_producers;
+  std::vector<std::thread> producers;
+
+  auto start = std::chrono::steady_clock::now();
+  for (std::uint32_t node = 0; node < p_producers; node++) {
+    producers.emplace_back([&, node]() {
+      stream_decoder decoder(queue, node);
+      // Feed in uneven chunks so records straddle chunk boundaries
+      constexpr std::size_t chunk_size = 1500;
+      for (std::size_t offset = 0; offset < stream.size();
+           offset += chunk_size) {
+        auto size = std::min(chunk_size, stream.size() - offset);
+        decoder.feed(std::span(stream).subspan(offset, size));
+      }
+      decoder.flush();
+      running.fetch_sub(1, std::memory_order_release);
+    });
+  }
+  consume(queue, running, nodes);
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  auto seconds = std::chrono::duration<double>(
+                   std::chrono::steady_clock::now() - start)
+                   .count();
+
+  return static_cast<double>(p_producers * p_records) / seconds;
+}
+
+int benchmark(std::size_t p_max_producers, std::size_t p_records)
+{
+  std::printf("hardware_threads=%u records_per_producer=%zu\n",
+              std::thread::hardware_concurrency(),
+              p_records);
+  for (std::size_t producers = 1; producers <= p_max_producers;
+       producers *= 2) {
+    auto lock_free = measure<lock_free_queue>(producers, p_records);
+    auto locked = measure<locked_queue>(producers, p_records);
+    std::printf("producers=%zu lock_free_records_per_s=%.0f "
+                "mutex_records_per_s=%.0f\n",
+                producers,
+                lock_free,
+                locked);
+  }
+  return EXIT_SUCCESS;
+}
+
+void print_usage(const char* p_program)
+{
+  std::fprintf(stderr,
+               "usage: %s source...\n"
+               "       %s --bench [--producers N] [--records N]\n"
+               "  source         sample log file or named pipe, one node "
+               "each\n"
+               "  --bench        compare the lock-free queue with a mutex "
+               "queue for 1, 2, 4, ... producers\n"
+               "  --producers N  most producers benchmarked (default 8)\n"
+               "  --records N    records per producer (default 1000000)\n",
+               p_program,
+               p_program);
+}
+}  // namespace
+
+int main(int p_argc, char** p_argv)
+{
+  bool bench = false;
+  std::size_t max_producers = 8;
+  std::size_t records = 1'000'000;
+  std::vector<std::string> paths;
+
+  for (int i = 1; i < p_argc; i++) {
+    std::string_view argument(p_argv[i]);
+    if (argument == "--bench") {
+      bench = true;
+    } else if (argument == "--producers" && i + 1 < p_argc) {
+      max_producers = std::strtoul(p_argv[++i], nullptr, 10);
+    } else if (argument == "--records" && i + 1 < p_argc) {
+      records = std::strtoul(p_argv[++i], nullptr, 10);
+    } else if (argument.starts_with("--")) {
+      print_usage(p_argv[0]);
+      return EXIT_FAILURE;
+    } else {
+      paths.emplace_back(argument);
+    }
+  }
+
+  if (bench) {
+    return benchmark(std::max<std::size_t>(max_producers, 1), records);
+  }
+  if (paths.empty()) {
+    print_usage(p_argv[0]);
+    return EXIT_FAILURE;
+  }
+  return ingest(paths);
+}
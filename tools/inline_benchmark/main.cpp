@@ -0,0 +1,152 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <span>
+#include <string_view>
+
+#include <libhal-mpl/configuration.hpp>
+#include <libhal-mpl/hot_path.hpp>
+#include <libhal-mpl/mpl3115a2.hpp>
+
+/**
+ * Measures the per sample cost of the driver's read path with a bus that
+ * answers instantly, so what remains is call, virtual dispatch and result
+ * handling overhead rather than bus time:
+ *
+ *   library           mpl3115a2::try_read_sample(), out of line in the
+ *                     libhal-mpl library
+ *   inline_virtual    hot_path::try_read() through a hal::i2c reference
+ *   inline_final      hot_path::try_read() with the concrete final bus type,
+ *                     so the transactions are devirtualized and inlined
+ *
+ * Build the tools once with and once without LIBHAL_MPL_LTO to see how much
+ * of the gap link time optimization closes for the library path.
+ */
+namespace {
+using namespace hal::mpl;
+
+/// Register file that always has a fresh sample ready
+class loopback_i2c final : public hal::i2c
+{
+public:
+  loopback_i2c()
+  {
+    m_registers[0x0C] = 0xC4;  // WHOAMI
+  }
+
+  void start_sampling()
+  {
+    m_sampling = true;
+  }
+
+private:
+  hal::status driver_configure(const settings&) override
+  {
+    return hal::success();
+  }
+
+  hal::result<transaction_t> driver_transaction(
+    hal::byte,
+    std::span<const hal::byte> p_data_out,
+    std::span<hal::byte> p_data_in,
+    hal::function_ref<hal::timeout_function>) override
+  {
+    auto pointer = p_data_out.empty() ? 0 : p_data_out[0];
+    for (auto value : p_data_out.subspan(p_data_out.empty() ? 0 : 1)) {
+      // Reset and one-shot conversions complete instantly
+      m_registers[pointer] = pointer == 0x26 ? (value & ~0x06) : value;
+      pointer++;
+    }
+    if (m_sampling) {
+      // A new conversion completes for every read, with changing data so
+      // the reads cannot be hoisted out of the loop
+      m_registers[0x00] = 0x0E;
+      m_registers[0x03] = static_cast<hal::byte>(m_count++ << 4);
+    }
+    for (auto& value : p_data_in) {
+      value = m_registers[pointer++];
+    }
+    return transaction_t{};
+  }
+
+  std::array<hal::byte, 256> m_registers{};
+  std::uint32_t m_count = 0;
+  bool m_sampling = false;
+};
+
+template<typename Read>
+void measure(const char* p_name, std::uint32_t p_samples, Read&& p_read)
+{
+  using clock = std::chrono::steady_clock;
+  std::uint64_t checksum = 0;
+
+  auto start = clock::now();
+  for (std::uint32_t i = 0; i < p_samples; i++) {
+    auto sample = p_read();
+    if (!sample || !sample->has_value()) {
+      std::fprintf(stderr, "%s: read failed\n", p_name);
+      std::exit(EXIT_FAILURE);
+    }
+    checksum += sample->value().pressure;
+  }
+  auto elapsed = std::chrono::duration<double, std::nano>(clock::now() - start);
+
+  std::printf("%-15s ns_per_sample=%.2f checksum=%llu\n",
+              p_name,
+              elapsed.count() / p_samples,
+              static_cast<unsigned long long>(checksum));
+}
+}  // namespace
+
+int main(int p_argc, char** p_argv)
+{
+  std::uint32_t samples = 10'000'000;
+  for (int i = 1; i < p_argc; i++) {
+    std::string_view argument(p_argv[i]);
+    if (argument == "--samples" && i + 1 < p_argc) {
+      samples =
+        static_cast<std::uint32_t>(std::strtoul(p_argv[++i], nullptr, 10));
+    } else {
+      std::fprintf(stderr, "usage: %s [--samples N]\n", p_argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  constexpr auto continuous = make_configuration<{
+    .mode = mpl3115a2::mode::barometer,
+    .oversampling = oversampling_ratio::os1,
+    .acquire = acquisition::continuous,
+  }>();
+  loopback_i2c bus;
+  auto device = mpl3115a2::create(bus, continuous);
+  if (!device) {
+    std::fprintf(stderr, "create failed\n");
+    return EXIT_FAILURE;
+  }
+  bus.start_sampling();
+  hal::i2c& virtual_bus = bus;
+
+  measure("library", samples, [&] { return device->try_read_sample(); });
+  measure("inline_virtual", samples, [&] {
+    return hot_path::try_read(virtual_bus);
+  });
+  measure("inline_final", samples, [&] { return hot_path::try_read(bus); });
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,201 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <libhal-mpl/conversion.hpp>
+#include <libhal-mpl/filter.hpp>
+#include <libhal-mpl/sample_log.hpp>
+
+#include "statistics.hpp"
+#include "work_stealing_pool.hpp"
+
+namespace {
+using namespace hal::mpl;
+using namespace hal::mpl::tools;
+
+struct file_summary
+{
+  std::string path;
+  bool readable = false;
+  std::size_t trailing_bytes = 0;
+  std::uint32_t first_timestamp = 0;
+  std::uint32_t last_timestamp = 0;
+  /// Filtered pressure in pascals
+  statistics pressure;
+  /// Temperature in celsius
+  statistics temperature;
+  /// Largest drop of the filtered pressure between two samples in pascals
+  double largest_pressure_drop = 0.0;
+};
+
+file_summary summarize(const std::string& p_path, float p_alpha)
+{
+  file_summary summary;
+  summary.path = p_path;
+
+  std::ifstream file(p_path, std::ios::binary);
+  if (!file) {
+    return summary;
+  }
+  summary.readable = true;
+
+  std::vector<hal::byte> contents((std::istreambuf_iterator<char>(file)),
+                                  std::istreambuf_iterator<char>());
+  auto whole_records = contents.size() / sample_record_size;
+  summary.trailing_bytes = contents.size() % sample_record_size;
+
+  low_pass_filter pressure_filter(p_alpha);
+  std::span<const hal::byte> remaining(contents);
+
+  for (std::size_t i = 0; i < whole_records; i++) {
+    auto record =
+      decode(remaining.subspan(i * sample_record_size)
+               .first<sample_record_size>());
+
+    auto previous = pressure_filter.value();
+    auto pressure = pressure_filter.update(to_pascals(record.pressure));
+
+    if (i == 0) {
+      summary.first_timestamp = record.timestamp;
+    } else {
+      auto drop = static_cast<double>(previous - pressure);
+      summary.largest_pressure_drop =
+        std::max(summary.largest_pressure_drop, drop);
+    }
+    summary.last_timestamp = record.timestamp;
+    summary.pressure.add(pressure);
+    summary.temperature.add(to_celsius(record.temperature));
+  }
+
+  return summary;
+}
+
+void print_summary(const file_summary& p_summary)
+{
+  if (!p_summary.readable) {
+    std::printf("%s: unreadable\n", p_summary.path.c_str());
+    return;
+  }
+
+  std::printf("%s: samples=%zu span_ms=%u "
+              "pressure_pa[mean=%.2f sd=%.2f min=%.2f max=%.2f drop=%.2f] "
+              "temperature_c[mean=%.2f min=%.2f max=%.2f]",
+              p_summary.path.c_str(),
+              p_summary.pressure.count,
+              p_summary.last_timestamp - p_summary.first_timestamp,
+              p_summary.pressure.mean,
+              p_summary.pressure.standard_deviation(),
+              p_summary.pressure.min,
+              p_summary.pressure.max,
+              p_summary.largest_pressure_drop,
+              p_summary.temperature.mean,
+              p_summary.temperature.min,
+              p_summary.temperature.max);
+
+  if (p_summary.trailing_bytes != 0) {
+    std::printf(" truncated=%zuB", p_summary.trailing_bytes);
+  }
+  std::printf("\n");
+}
+
+void print_usage(const char* p_program)
+{
+  std::fprintf(stderr,
+               "usage: %s [--threads N] [--alpha A] log_file...\n"
+               "  --threads N  worker threads, 0 = hardware threads "
+               "(default 0)\n"
+               "  --alpha A    pressure low pass weight, 1.0 disables "
+               "filtering (default 0.25)\n",
+               p_program);
+}
+}  // namespace
+
+int main(int p_argc, char** p_argv)
+{
+  std::size_t thread_count = 0;
+  float alpha = 0.25f;
+  std::vector<std::string> paths;
+
+  for (int i = 1; i < p_argc; i++) {
+    std::string_view argument(p_argv[i]);
+    if (argument == "--threads" && i + 1 < p_argc) {
+      thread_count = std::strtoul(p_argv[++i], nullptr, 10);
+    } else if (argument == "--alpha" && i + 1 < p_argc) {
+      alpha = std::strtof(p_argv[++i], nullptr);
+    } else if (argument.starts_with("--")) {
+      print_usage(p_argv[0]);
+      return EXIT_FAILURE;
+    } else {
+      paths.emplace_back(argument);
+    }
+  }
+
+  if (paths.empty()) {
+    print_usage(p_argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  // Every task writes only to its own slot, so no locking is needed.
+  std::vector<file_summary> summaries(paths.size());
+  {
+    work_stealing_pool pool(thread_count);
+    for (std::size_t i = 0; i < paths.size(); i++) {
+      pool.submit([&summaries, &paths, i, alpha] {
+        summaries[i] = summarize(paths[i], alpha);
+      });
+    }
+    pool.wait();
+  }
+
+  file_summary merged;
+  merged.path = "merged";
+  merged.readable = true;
+  std::size_t unreadable = 0;
+
+  for (const auto& summary : summaries) {
+    print_summary(summary);
+    if (!summary.readable) {
+      unreadable++;
+      continue;
+    }
+    // The merged span runs from the earliest to the latest sample
+    if (merged.pressure.count == 0) {
+      merged.first_timestamp = summary.first_timestamp;
+      merged.last_timestamp = summary.last_timestamp;
+    } else if (summary.pressure.count != 0) {
+      merged.first_timestamp =
+        std::min(merged.first_timestamp, summary.first_timestamp);
+      merged.last_timestamp =
+        std::max(merged.last_timestamp, summary.last_timestamp);
+    }
+    merged.pressure.merge(summary.pressure);
+    merged.temperature.merge(summary.temperature);
+    merged.largest_pressure_drop =
+      std::max(merged.largest_pressure_drop, summary.largest_pressure_drop);
+    merged.trailing_bytes += summary.trailing_bytes;
+  }
+
+  print_summary(merged);
+
+  return unreadable == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
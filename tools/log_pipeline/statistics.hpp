@@ -0,0 +1,76 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+namespace hal::mpl::tools {
+/**
+ * @brief Single pass mean/variance/min/max accumulator
+ *
+ * Uses Welford's update for each sample and Chan's formula to merge two
+ * accumulators, so per-file results computed in parallel can be combined
+ * without revisiting the samples.
+ */
+struct statistics
+{
+  std::size_t count = 0;
+  double mean = 0.0;
+  double m2 = 0.0;
+  double min = std::numeric_limits<double>::infinity();
+  double max = -std::numeric_limits<double>::infinity();
+
+  void add(double p_sample)
+  {
+    count++;
+    double delta = p_sample - mean;
+    mean += delta / static_cast<double>(count);
+    m2 += delta * (p_sample - mean);
+    min = std::min(min, p_sample);
+    max = std::max(max, p_sample);
+  }
+
+  void merge(const statistics& p_other)
+  {
+    if (p_other.count == 0) {
+      return;
+    }
+    if (count == 0) {
+      *this = p_other;
+      return;
+    }
+
+    auto total = static_cast<double>(count + p_other.count);
+    double delta = p_other.mean - mean;
+    mean += delta * static_cast<double>(p_other.count) / total;
+    m2 += p_other.m2 + delta * delta * static_cast<double>(count) *
+                         static_cast<double>(p_other.count) / total;
+    count += p_other.count;
+    min = std::min(min, p_other.min);
+    max = std::max(max, p_other.max);
+  }
+
+  double standard_deviation() const
+  {
+    if (count < 2) {
+      return 0.0;
+    }
+    return std::sqrt(m2 / static_cast<double>(count - 1));
+  }
+};
+}  // namespace hal::mpl::tools
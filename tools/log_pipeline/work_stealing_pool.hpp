@@ -0,0 +1,191 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hal::mpl::tools {
+/**
+ * @brief Fixed size thread pool where idle workers steal queued tasks from
+ * busy workers.
+ *
+ * Each worker owns a deque. Submitted tasks are distributed round robin across
+ * the deques, a worker takes work from the front of its own deque and, when
+ * that is empty, steals from the back of the other workers' deques. This keeps
+ * every core busy when task durations vary widely, such as when log files
+ * differ greatly in size.
+ */
+class work_stealing_pool
+{
+public:
+  using task = std::function<void()>;
+
+  /**
+   * @brief Start the pool's worker threads
+   *
+   * @param p_thread_count - number of workers, 0 selects the number of
+   * hardware threads.
+   */
+  explicit work_stealing_pool(std::size_t p_thread_count)
+  {
+    if (p_thread_count == 0) {
+      p_thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (std::size_t i = 0; i < p_thread_count; i++) {
+      m_queues.emplace_back(std::make_unique<worker_queue>());
+    }
+    for (std::size_t i = 0; i < p_thread_count; i++) {
+      m_workers.emplace_back([this, i] { run(i); });
+    }
+  }
+
+  work_stealing_pool(const work_stealing_pool&) = delete;
+  work_stealing_pool& operator=(const work_stealing_pool&) = delete;
+
+  ~work_stealing_pool()
+  {
+    wait();
+    {
+      std::scoped_lock lock(m_state_lock);
+      m_stopping = true;
+    }
+    m_work_available.notify_all();
+  }
+
+  /**
+   * @brief Queue a task for execution on one of the workers
+   *
+   * @param p_task - task to run
+   */
+  void submit(task p_task)
+  {
+    auto index = m_next_queue.fetch_add(1) % m_queues.size();
+    {
+      std::scoped_lock lock(m_queues[index]->lock);
+      m_queues[index]->tasks.emplace_back(std::move(p_task));
+    }
+    {
+      std::scoped_lock lock(m_state_lock);
+      m_queued++;
+      m_unfinished++;
+    }
+    m_work_available.notify_one();
+  }
+
+  /**
+   * @brief Block until every submitted task has finished
+   */
+  void wait()
+  {
+    std::unique_lock lock(m_state_lock);
+    m_all_finished.wait(lock, [this] { return m_unfinished == 0; });
+  }
+
+  /**
+   * @return std::size_t - number of worker threads
+   */
+  std::size_t size() const
+  {
+    return m_queues.size();
+  }
+
+private:
+  struct worker_queue
+  {
+    std::mutex lock;
+    std::deque<task> tasks;
+  };
+
+  bool try_take(std::size_t p_index, task& p_task)
+  {
+    // Own work is taken from the front to keep submission order locally.
+    {
+      auto& own = *m_queues[p_index];
+      std::scoped_lock lock(own.lock);
+      if (!own.tasks.empty()) {
+        p_task = std::move(own.tasks.front());
+        own.tasks.pop_front();
+        return true;
+      }
+    }
+
+    // Stolen work is taken from the back to avoid contending with the owner.
+    for (std::size_t offset = 1; offset < m_queues.size(); offset++) {
+      auto& victim = *m_queues[(p_index + offset) % m_queues.size()];
+      std::scoped_lock lock(victim.lock);
+      if (!victim.tasks.empty()) {
+        p_task = std::move(victim.tasks.back());
+        victim.tasks.pop_back();
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  void run(std::size_t p_index)
+  {
+    while (true) {
+      {
+        std::unique_lock lock(m_state_lock);
+        m_work_available.wait(lock,
+                              [this] { return m_stopping || m_queued > 0; });
+        if (m_queued == 0) {
+          return;
+        }
+        // Claim one queued task before searching for it so that other idle
+        // workers do not wake up for the same task.
+        m_queued--;
+      }
+
+      task current;
+      while (!try_take(p_index, current)) {
+        // A claimed task is always queued somewhere, but the scan can race
+        // with other workers shuffling tasks, so retry until it is found.
+        std::this_thread::yield();
+      }
+
+      current();
+
+      std::scoped_lock lock(m_state_lock);
+      if (--m_unfinished == 0) {
+        m_all_finished.notify_all();
+      }
+    }
+  }
+
+  std::vector<std::unique_ptr<worker_queue>> m_queues;
+  std::atomic<std::size_t> m_next_queue = 0;
+  std::mutex m_state_lock;
+  std::condition_variable m_work_available;
+  std::condition_variable m_all_finished;
+  std::size_t m_queued = 0;
+  std::size_t m_unfinished = 0;
+  bool m_stopping = false;
+  // Declared last so the workers are joined before the state above is
+  // destroyed.
+  std::vector<std::jthread> m_workers;
+};
+}  // namespace hal::mpl::tools
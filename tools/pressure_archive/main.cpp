@@ -0,0 +1,374 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <libhal-mpl/conversion.hpp>
+#include <libhal-mpl/pressure_codec.hpp>
+#include <libhal-mpl/sample_log.hpp>
+
+/**
+ * Archive layout, little endian:
+ *
+ *   "MPLZ" | u32 samples per block | blocks... |
+ *   index: u64 offset of every block | u64 block count | u64 index offset |
+ *   "MPLZ"
+ *
+ * Every block but the last holds the same number of samples, so the block
+ * holding a sample is found by division and read through the index without
+ * touching the other blocks.
+ */
+namespace {
+using namespace hal::mpl;
+
+constexpr std::array<hal::byte, 4> archive_magic{ 'M', 'P', 'L', 'Z' };
+constexpr std::size_t archive_header_size = 8;
+constexpr std::size_t archive_footer_size = 20;
+
+using bytes = std::vector<hal::byte>;
+
+std::optional<bytes> read_file(const std::string& p_path)
+{
+  std::ifstream file(p_path, std::ios::binary);
+  if (!file) {
+    return std::nullopt;
+  }
+  return bytes((std::istreambuf_iterator<char>(file)),
+               std::istreambuf_iterator<char>());
+}
+
+bool write_file(const std::string& p_path, std::span<const hal::byte> p_data)
+{
+  std::ofstream file(p_path, std::ios::binary);
+  file.write(reinterpret_cast<const char*>(p_data.data()),
+             static_cast<std::streamsize>(p_data.size()));
+  return static_cast<bool>(file);
+}
+
+void put_u32(bytes& p_out, std::uint32_t p_value)
+{
+  for (int shift = 0; shift < 32; shift += 8) {
+    p_out.push_back(hal::byte(p_value >> shift));
+  }
+}
+
+void put_u64(bytes& p_out, std::uint64_t p_value)
+{
+  for (int shift = 0; shift < 64; shift += 8) {
+    p_out.push_back(hal::byte(p_value >> shift));
+  }
+}
+
+std::uint64_t get_u64(std::span<const hal::byte> p_in)
+{
+  std::uint64_t value = 0;
+  for (std::size_t i = 0; i < 8; i++) {
+    value |= std::uint64_t(p_in[i]) << (8 * i);
+  }
+  return value;
+}
+
+/// Raw 20-bit pressure of every whole record of a sample log
+std::vector<std::uint32_t> log_pressures(std::span<const hal::byte> p_log)
+{
+  std::vector<std::uint32_t> samples;
+  samples.reserve(p_log.size() / sample_record_size);
+  for (std::size_t offset = 0; offset + sample_record_size <= p_log.size();
+       offset += sample_record_size) {
+    auto record =
+      decode(p_log.subspan(offset).first<sample_record_size>());
+    samples.push_back(record.pressure >> 4);
+  }
+  return samples;
+}
+
+std::optional<bytes> compress(std::span<const std::uint32_t> p_samples,
+                              std::uint32_t p_block_samples)
+{
+  bytes archive(archive_magic.begin(), archive_magic.end());
+  put_u32(archive, p_block_samples);
+
+  std::vector<std::uint64_t> offsets;
+  bytes block(max_pressure_block_size(p_block_samples));
+  for (std::size_t first = 0; first < p_samples.size();
+       first += p_block_samples) {
+    auto count = std::min<std::size_t>(p_block_samples,
+                                       p_samples.size() - first);
+    auto size = encode_pressure_block(p_samples.subspan(first, count), block);
+    if (!size) {
+      return std::nullopt;
+    }
+    offsets.push_back(archive.size());
+    archive.insert(archive.end(), block.begin(), block.begin() + *size);
+  }
+
+  auto index_offset = archive.size();
+  for (auto offset : offsets) {
+    put_u64(archive, offset);
+  }
+  put_u64(archive, offsets.size());
+  put_u64(archive, index_offset);
+  archive.insert(archive.end(), archive_magic.begin(), archive_magic.end());
+
+  return archive;
+}
+
+struct archive_view
+{
+  std::span<const hal::byte> data;
+  std::uint32_t block_samples = 0;
+  std::vector<std::uint64_t> offsets;
+
+  std::span<const hal::byte> block(std::size_t p_index) const
+  {
+    return data.subspan(offsets[p_index]);
+  }
+};
+
+std::optional<archive_view> open_archive(std::span<const hal::byte> p_data)
+{
+  auto has_magic = [](std::span<const hal::byte> p_bytes) {
+    return std::equal(
+      archive_magic.begin(), archive_magic.end(), p_bytes.begin());
+  };
+  if (p_data.size() < archive_header_size + archive_footer_size ||
+      !has_magic(p_data.first(4)) || !has_magic(p_data.last(4))) {
+    return std::nullopt;
+  }
+
+  auto footer = p_data.last(archive_footer_size);
+  auto count = get_u64(footer);
+  auto index_offset = get_u64(footer.subspan(8));
+  auto index_end = p_data.size() - archive_footer_size;
+  if (index_offset > index_end || (index_end - index_offset) / 8 != count) {
+    return std::nullopt;
+  }
+
+  archive_view view{
+    .data = p_data.first(index_offset),
+    .block_samples = std::uint32_t(p_data[4]) |
+                     std::uint32_t(p_data[5]) << 8 |
+                     std::uint32_t(p_data[6]) << 16 |
+                     std::uint32_t(p_data[7]) << 24,
+    .offsets = {},
+  };
+  for (std::size_t i = 0; i < count; i++) {
+    auto offset = get_u64(p_data.subspan(index_offset + i * 8));
+    if (offset >= index_offset) {
+      return std::nullopt;
+    }
+    view.offsets.push_back(offset);
+  }
+  if (view.block_samples == 0 ||
+      view.block_samples > max_pressure_block_samples) {
+    return std::nullopt;
+  }
+
+  return view;
+}
+
+void print_sample(std::uint64_t p_index, std::uint32_t p_sample)
+{
+  std::printf("%llu %.2f\n",
+              static_cast<unsigned long long>(p_index),
+              static_cast<double>(to_pascals(p_sample << 4)));
+}
+
+/// Stream samples [p_first, p_first + p_count) through a small buffer,
+/// decoding only the blocks that hold them
+bool print_range(const archive_view& p_archive,
+                 std::uint64_t p_first,
+                 std::uint64_t p_count)
+{
+  std::array<std::uint32_t, 256> buffer{};
+  auto index = p_first;
+  auto end = p_first + p_count;
+
+  for (auto block = p_first / p_archive.block_samples;
+       block < p_archive.offsets.size() && index < end;
+       block++) {
+    auto decoder = pressure_block_decoder::create(p_archive.block(block));
+    if (!decoder) {
+      return false;
+    }
+    auto position = block * p_archive.block_samples;
+
+    while (index < end) {
+      auto chunk = decoder->read(buffer);
+      if (!chunk) {
+        return false;
+      }
+      if (chunk->empty()) {
+        break;
+      }
+      for (auto sample : *chunk) {
+        if (position >= index && index < end) {
+          print_sample(index++, sample);
+        }
+        position++;
+      }
+    }
+  }
+
+  return true;
+}
+
+int benchmark(std::span<const std::uint32_t> p_samples,
+              std::size_t p_log_bytes,
+              std::uint32_t p_block_samples)
+{
+  using clock = std::chrono::steady_clock;
+
+  auto encode_start = clock::now();
+  auto archive = compress(p_samples, p_block_samples);
+  auto encode_time = clock::now() - encode_start;
+  if (!archive) {
+    std::fprintf(stderr, "encoding failed\n");
+    return EXIT_FAILURE;
+  }
+
+  auto view = open_archive(*archive).value();
+  std::vector<std::uint32_t> decoded(p_samples.size());
+  auto decode_start = clock::now();
+  std::size_t position = 0;
+  for (std::size_t block = 0; block < view.offsets.size(); block++) {
+    auto result = decode_pressure_block(
+      view.block(block), std::span(decoded).subspan(position));
+    if (!result) {
+      std::fprintf(stderr, "decoding failed at block %zu\n", block);
+      return EXIT_FAILURE;
+    }
+    position += result->size();
+  }
+  auto decode_time = clock::now() - decode_start;
+
+  bool identical = std::equal(
+    p_samples.begin(), p_samples.end(), decoded.begin(), decoded.end());
+  auto samples = static_cast<double>(p_samples.size());
+  auto megabytes = samples * sizeof(std::uint32_t) / 1e6;
+  auto seconds = [](clock::duration p_duration) {
+    return std::chrono::duration<double>(p_duration).count();
+  };
+
+  std::printf("samples=%zu archive_bytes=%zu bits_per_sample=%.3f "
+              "ratio_vs_log=%.2f ratio_vs_packed_20bit=%.2f "
+              "encode_mb_s=%.1f decode_mb_s=%.1f lossless=%s\n",
+              p_samples.size(),
+              archive->size(),
+              static_cast<double>(archive->size()) * 8.0 / samples,
+              static_cast<double>(p_log_bytes) /
+                static_cast<double>(archive->size()),
+              samples * 2.5 / static_cast<double>(archive->size()),
+              megabytes / seconds(encode_time),
+              megabytes / seconds(decode_time),
+              identical ? "yes" : "NO");
+
+  return identical ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+void print_usage(const char* p_program)
+{
+  std::fprintf(stderr,
+               "usage: %s [--block N] command ...\n"
+               "  compress LOG ARCHIVE     archive the pressure of a sample "
+               "log\n"
+               "  print ARCHIVE [FIRST [COUNT]]\n"
+               "                           print samples in pascals\n"
+               "  bench LOG                report size and codec throughput\n"
+               "  --block N  samples per block, up to %zu (default 4096)\n",
+               p_program,
+               max_pressure_block_samples);
+}
+}  // namespace
+
+int main(int p_argc, char** p_argv)
+{
+  std::uint32_t block_samples = 4096;
+  std::vector<std::string> arguments;
+
+  for (int i = 1; i < p_argc; i++) {
+    std::string_view argument(p_argv[i]);
+    if (argument == "--block" && i + 1 < p_argc) {
+      block_samples =
+        static_cast<std::uint32_t>(std::strtoul(p_argv[++i], nullptr, 10));
+    } else if (argument.starts_with("--")) {
+      print_usage(p_argv[0]);
+      return EXIT_FAILURE;
+    } else {
+      arguments.emplace_back(argument);
+    }
+  }
+
+  if (arguments.size() < 2 || block_samples == 0 ||
+      block_samples > max_pressure_block_samples) {
+    print_usage(p_argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const auto& command = arguments[0];
+  auto input = read_file(arguments[1]);
+  if (!input) {
+    std::fprintf(stderr, "%s: unreadable\n", arguments[1].c_str());
+    return EXIT_FAILURE;
+  }
+
+  if (command == "compress" && arguments.size() == 3) {
+    auto archive = compress(log_pressures(*input), block_samples);
+    if (!archive || !write_file(arguments[2], *archive)) {
+      std::fprintf(stderr, "%s: write failed\n", arguments[2].c_str());
+      return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+  }
+
+  if (command == "print" && arguments.size() <= 4) {
+    auto archive = open_archive(*input);
+    if (!archive) {
+      std::fprintf(stderr, "%s: not an archive\n", arguments[1].c_str());
+      return EXIT_FAILURE;
+    }
+    std::uint64_t first = 0;
+    std::uint64_t count = UINT64_MAX - 1;
+    if (arguments.size() >= 3) {
+      first = std::strtoull(arguments[2].c_str(), nullptr, 10);
+    }
+    if (arguments.size() == 4) {
+      count = std::strtoull(arguments[3].c_str(), nullptr, 10);
+    }
+    if (!print_range(*archive, first, std::min(count, UINT64_MAX - first))) {
+      std::fprintf(stderr, "%s: corrupt block\n", arguments[1].c_str());
+      return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+  }
+
+  if (command == "bench" && arguments.size() == 2) {
+    return benchmark(log_pressures(*input), input->size(), block_samples);
+  }
+
+  print_usage(p_argv[0]);
+  return EXIT_FAILURE;
+}
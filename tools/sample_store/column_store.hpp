@@ -0,0 +1,495 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <libhal-mpl/pressure_codec.hpp>
+
+/**
+ * Column store layout, little endian:
+ *
+ *   "MPLC" | u32 version | blocks... | zone map of every block |
+ *   u64 block count | u64 zone map offset | "MPLC"
+ *
+ * Each block holds up to `max_pressure_block_samples` rows in three columns
+ * stored one after the other, so a query reads only the columns it needs:
+ *
+ *   timestamps: u64 first timestamp in milliseconds, then LEB128 varint
+ *               pairs of a difference from the previous timestamp, 0 for
+ *               the first row, and the number of rows it repeats for. A
+ *               steady sample rate takes a few bytes per block.
+ *   pressure:   raw 20-bit pressure, a `pressure_codec.hpp` block
+ *   temperature: raw OUT_T word offset by 0x8000, a `pressure_codec.hpp`
+ *               block. The offset keeps readings around 0 °C adjacent,
+ *               where the two's complement word jumps from 0xFFFF to 0.
+ *
+ * The zone map of a block records where its columns are and the minimum and
+ * maximum of every column, so a reader can skip blocks that cannot match a
+ * query without reading them.
+ */
+namespace hal::mpl::tools {
+/// Index entry of one block
+struct zone_map
+{
+  std::uint64_t offset;
+  std::uint32_t rows;
+  std::uint32_t timestamp_size;
+  std::uint32_t pressure_size;
+  std::uint32_t temperature_size;
+  /// Milliseconds
+  std::uint64_t min_timestamp;
+  std::uint64_t max_timestamp;
+  /// Raw 20-bit pressure
+  std::uint32_t min_pressure;
+  std::uint32_t max_pressure;
+  /// Raw OUT_T word
+  std::int16_t min_temperature;
+  std::int16_t max_temperature;
+};
+
+namespace column_format {
+constexpr std::array<hal::byte, 4> magic{ 'M', 'P', 'L', 'C' };
+constexpr std::uint32_t version = 2;
+constexpr std::size_t header_size = 8;
+constexpr std::size_t footer_size = 20;
+constexpr std::size_t zone_map_size = 52;
+
+using bytes = std::vector<hal::byte>;
+
+/// Temperature as stored in its column, ordered like the signed reading
+constexpr std::uint32_t temperature_word(std::int16_t p_temperature)
+{
+  return static_cast<std::uint32_t>(p_temperature + 0x8000);
+}
+
+constexpr std::int16_t temperature_from_word(std::uint32_t p_word)
+{
+  return static_cast<std::int16_t>(static_cast<std::int32_t>(p_word) - 0x8000);
+}
+
+inline void put(bytes& p_out, std::uint64_t p_value, std::size_t p_size)
+{
+  for (std::size_t i = 0; i < p_size; i++) {
+    p_out.push_back(hal::byte(p_value >> (8 * i)));
+  }
+}
+
+inline std::uint64_t get(std::span<const hal::byte> p_in,
+                         std::size_t& p_position,
+                         std::size_t p_size)
+{
+  std::uint64_t value = 0;
+  for (std::size_t i = 0; i < p_size; i++) {
+    value |= std::uint64_t(p_in[p_position++]) << (8 * i);
+  }
+  return value;
+}
+
+/// Unsigned LEB128
+inline void put_varint(bytes& p_out, std::uint64_t p_value)
+{
+  while (p_value > 0x7F) {
+    p_out.push_back(hal::byte((p_value & 0x7F) | 0x80));
+    p_value >>= 7;
+  }
+  p_out.push_back(hal::byte(p_value));
+}
+
+inline std::optional<std::uint64_t> get_varint(std::span<const hal::byte> p_in,
+                                               std::size_t& p_position)
+{
+  std::uint64_t value = 0;
+  for (unsigned shift = 0; shift < 64; shift += 7) {
+    if (p_position == p_in.size()) {
+      return std::nullopt;
+    }
+    auto next = p_in[p_position++];
+    value |= std::uint64_t(next & 0x7F) << shift;
+    if ((next & 0x80) == 0) {
+      return value;
+    }
+  }
+  return std::nullopt;
+}
+
+inline void put_zone_map(bytes& p_out, const zone_map& p_zone)
+{
+  put(p_out, p_zone.offset, 8);
+  put(p_out, p_zone.rows, 4);
+  put(p_out, p_zone.timestamp_size, 4);
+  put(p_out, p_zone.pressure_size, 4);
+  put(p_out, p_zone.temperature_size, 4);
+  put(p_out, p_zone.min_timestamp, 8);
+  put(p_out, p_zone.max_timestamp, 8);
+  put(p_out, p_zone.min_pressure, 4);
+  put(p_out, p_zone.max_pressure, 4);
+  put(p_out, static_cast<std::uint16_t>(p_zone.min_temperature), 2);
+  put(p_out, static_cast<std::uint16_t>(p_zone.max_temperature), 2);
+}
+
+inline zone_map get_zone_map(std::span<const hal::byte> p_in)
+{
+  std::size_t position = 0;
+  auto next = [&](std::size_t p_size) { return get(p_in, position, p_size); };
+  return zone_map{
+    .offset = next(8),
+    .rows = static_cast<std::uint32_t>(next(4)),
+    .timestamp_size = static_cast<std::uint32_t>(next(4)),
+    .pressure_size = static_cast<std::uint32_t>(next(4)),
+    .temperature_size = static_cast<std::uint32_t>(next(4)),
+    .min_timestamp = next(8),
+    .max_timestamp = next(8),
+    .min_pressure = static_cast<std::uint32_t>(next(4)),
+    .max_pressure = static_cast<std::uint32_t>(next(4)),
+    .min_temperature = static_cast<std::int16_t>(next(2)),
+    .max_temperature = static_cast<std::int16_t>(next(2)),
+  };
+}
+}  // namespace column_format
+
+/// One decoded row
+struct column_row
+{
+  std::uint64_t timestamp;
+  std::uint32_t pressure;
+  std::int16_t temperature;
+};
+
+/**
+ * @brief Appends rows to a column store file block by block
+ */
+class column_store_writer
+{
+public:
+  explicit column_store_writer(const std::string& p_path)
+    : m_file(p_path, std::ios::binary)
+  {
+    column_format::bytes header(column_format::magic.begin(),
+                                column_format::magic.end());
+    column_format::put(header, column_format::version, 4);
+    write(header);
+  }
+
+  /**
+   * @brief Buffer a row, writing a block whenever one fills up
+   *
+   * @return false - the row is older than the previous row, its pressure is
+   * not a raw OUT_P word or a write failed
+   */
+  bool append(const column_row& p_row)
+  {
+    if ((!m_rows.empty() || !m_zones.empty()) &&
+        p_row.timestamp < m_last_timestamp) {
+      return false;
+    }
+    if (p_row.pressure >> pressure_sample_bits) {
+      return false;
+    }
+    m_last_timestamp = p_row.timestamp;
+    m_rows.push_back(p_row);
+    if (m_rows.size() == max_pressure_block_samples) {
+      return flush_block();
+    }
+    return static_cast<bool>(m_file);
+  }
+
+  /**
+   * @brief Write the last block, the zone maps and the footer
+   */
+  bool finish()
+  {
+    if (!flush_block()) {
+      return false;
+    }
+
+    column_format::bytes index;
+    for (const auto& zone : m_zones) {
+      column_format::put_zone_map(index, zone);
+    }
+    column_format::put(index, m_zones.size(), 8);
+    column_format::put(index, m_position, 8);
+    index.insert(
+      index.end(), column_format::magic.begin(), column_format::magic.end());
+    write(index);
+    m_file.flush();
+    return static_cast<bool>(m_file);
+  }
+
+private:
+  bool flush_block()
+  {
+    if (m_rows.empty()) {
+      return static_cast<bool>(m_file);
+    }
+
+    zone_map zone{
+      .offset = m_position,
+      .rows = static_cast<std::uint32_t>(m_rows.size()),
+      .timestamp_size = 0,
+      .pressure_size = 0,
+      .temperature_size = 0,
+      .min_timestamp = m_rows.front().timestamp,
+      .max_timestamp = m_rows.back().timestamp,
+      .min_pressure = m_rows.front().pressure,
+      .max_pressure = m_rows.front().pressure,
+      .min_temperature = m_rows.front().temperature,
+      .max_temperature = m_rows.front().temperature,
+    };
+
+    column_format::bytes timestamps;
+    column_format::put(timestamps, m_rows.front().timestamp, 8);
+    std::vector<std::uint32_t> pressures;
+    std::vector<std::uint32_t> temperatures;
+    std::uint64_t previous = m_rows.front().timestamp;
+    std::uint64_t run_delta = 0;
+    std::uint64_t run_length = 0;
+    for (const auto& row : m_rows) {
+      auto delta = row.timestamp - previous;
+      if (run_length != 0 && delta != run_delta) {
+        column_format::put_varint(timestamps, run_delta);
+        column_format::put_varint(timestamps, run_length);
+        run_length = 0;
+      }
+      run_delta = delta;
+      run_length++;
+      previous = row.timestamp;
+
+      pressures.push_back(row.pressure);
+      temperatures.push_back(column_format::temperature_word(row.temperature));
+      zone.min_pressure = std::min(zone.min_pressure, row.pressure);
+      zone.max_pressure = std::max(zone.max_pressure, row.pressure);
+      zone.min_temperature = std::min(zone.min_temperature, row.temperature);
+      zone.max_temperature = std::max(zone.max_temperature, row.temperature);
+    }
+    column_format::put_varint(timestamps, run_delta);
+    column_format::put_varint(timestamps, run_length);
+
+    column_format::bytes pressure(max_pressure_block_size(m_rows.size()));
+    column_format::bytes temperature(pressure.size());
+    auto pressure_size = encode_pressure_block(pressures, pressure);
+    auto temperature_size = encode_pressure_block(temperatures, temperature);
+    if (!pressure_size || !temperature_size) {
+      return false;
+    }
+    pressure.resize(*pressure_size);
+    temperature.resize(*temperature_size);
+
+    zone.timestamp_size = static_cast<std::uint32_t>(timestamps.size());
+    zone.pressure_size = static_cast<std::uint32_t>(pressure.size());
+    zone.temperature_size = static_cast<std::uint32_t>(temperature.size());
+    write(timestamps);
+    write(pressure);
+    write(temperature);
+
+    m_zones.push_back(zone);
+    m_rows.clear();
+    return static_cast<bool>(m_file);
+  }
+
+  void write(std::span<const hal::byte> p_data)
+  {
+    m_file.write(reinterpret_cast<const char*>(p_data.data()),
+                 static_cast<std::streamsize>(p_data.size()));
+    m_position += p_data.size();
+  }
+
+  std::ofstream m_file;
+  std::uint64_t m_position = 0;
+  std::uint64_t m_last_timestamp = 0;
+  std::vector<column_row> m_rows;
+  std::vector<zone_map> m_zones;
+};
+
+/**
+ * @brief Reads the zone maps of a column store up front and individual
+ * columns of individual blocks on demand
+ */
+class column_store_reader
+{
+public:
+  static std::optional<column_store_reader> open(const std::string& p_path)
+  {
+    column_store_reader reader;
+    reader.m_file.open(p_path, std::ios::binary | std::ios::ate);
+    if (!reader.m_file) {
+      return std::nullopt;
+    }
+    auto size = static_cast<std::uint64_t>(reader.m_file.tellg());
+    if (size < column_format::header_size + column_format::footer_size) {
+      return std::nullopt;
+    }
+
+    column_format::bytes header(column_format::header_size);
+    column_format::bytes footer(column_format::footer_size);
+    if (!reader.read_at(0, header) ||
+        !reader.read_at(size - footer.size(), footer)) {
+      return std::nullopt;
+    }
+    auto has_magic = [](std::span<const hal::byte> p_bytes) {
+      return std::equal(column_format::magic.begin(),
+                        column_format::magic.end(),
+                        p_bytes.begin());
+    };
+    std::size_t position = 4;
+    if (!has_magic(header) || !has_magic(std::span(footer).last(4)) ||
+        column_format::get(header, position, 4) != column_format::version) {
+      return std::nullopt;
+    }
+
+    position = 0;
+    auto count = column_format::get(footer, position, 8);
+    auto index_offset = column_format::get(footer, position, 8);
+    auto index_end = size - column_format::footer_size;
+    if (index_offset < column_format::header_size || index_offset > index_end ||
+        (index_end - index_offset) / column_format::zone_map_size != count) {
+      return std::nullopt;
+    }
+
+    column_format::bytes index(index_end - index_offset);
+    if (!reader.read_at(index_offset, index)) {
+      return std::nullopt;
+    }
+    for (std::size_t i = 0; i < count; i++) {
+      auto zone = column_format::get_zone_map(
+        std::span(index).subspan(i * column_format::zone_map_size));
+      auto end = zone.offset + zone.timestamp_size + zone.pressure_size +
+                 zone.temperature_size;
+      if (zone.rows == 0 || zone.rows > max_pressure_block_samples ||
+          zone.offset < column_format::header_size || end > index_offset) {
+        return std::nullopt;
+      }
+      reader.m_zones.push_back(zone);
+    }
+    // Reading the header, footer and index is not charged to queries
+    reader.m_bytes_read = 0;
+
+    return reader;
+  }
+
+  [[nodiscard]] std::span<const zone_map> zones() const
+  {
+    return m_zones;
+  }
+
+  bool read_timestamps(std::size_t p_block, std::vector<std::uint64_t>& p_out)
+  {
+    const auto& zone = m_zones[p_block];
+    column_format::bytes column(zone.timestamp_size);
+    if (!read_column(zone.offset, column) || column.size() < 8) {
+      return false;
+    }
+
+    std::size_t position = 0;
+    auto timestamp = column_format::get(column, position, 8);
+    p_out.clear();
+    while (p_out.size() < zone.rows) {
+      auto delta = column_format::get_varint(column, position);
+      auto run_length = column_format::get_varint(column, position);
+      if (!delta || !run_length || *run_length == 0 ||
+          *run_length > zone.rows - p_out.size()) {
+        return false;
+      }
+      for (std::uint64_t i = 0; i < *run_length; i++) {
+        timestamp += *delta;
+        p_out.push_back(timestamp);
+      }
+    }
+    return true;
+  }
+
+  bool read_pressures(std::size_t p_block, std::vector<std::uint32_t>& p_out)
+  {
+    const auto& zone = m_zones[p_block];
+    return read_codec_column(
+      zone.offset + zone.timestamp_size, zone.pressure_size, zone.rows, p_out);
+  }
+
+  bool read_temperatures(std::size_t p_block, std::vector<std::int16_t>& p_out)
+  {
+    const auto& zone = m_zones[p_block];
+    std::vector<std::uint32_t> words;
+    if (!read_codec_column(zone.offset + zone.timestamp_size +
+                             zone.pressure_size,
+                           zone.temperature_size,
+                           zone.rows,
+                           words)) {
+      return false;
+    }
+    p_out.clear();
+    for (auto word : words) {
+      p_out.push_back(column_format::temperature_from_word(word));
+    }
+    return true;
+  }
+
+  /// Columns read by queries so far
+  [[nodiscard]] std::size_t columns_read() const
+  {
+    return m_columns_read;
+  }
+
+  /// Bytes read by queries so far
+  [[nodiscard]] std::uint64_t bytes_read() const
+  {
+    return m_bytes_read;
+  }
+
+private:
+  column_store_reader() = default;
+
+  bool read_codec_column(std::uint64_t p_offset,
+                         std::uint32_t p_size,
+                         std::uint32_t p_rows,
+                         std::vector<std::uint32_t>& p_out)
+  {
+    column_format::bytes column(p_size);
+    if (!read_column(p_offset, column)) {
+      return false;
+    }
+    p_out.resize(p_rows);
+    auto decoded = decode_pressure_block(column, p_out);
+    return decoded && decoded->size() == p_rows;
+  }
+
+  bool read_column(std::uint64_t p_offset, std::span<hal::byte> p_out)
+  {
+    m_columns_read++;
+    return read_at(p_offset, p_out);
+  }
+
+  bool read_at(std::uint64_t p_offset, std::span<hal::byte> p_out)
+  {
+    m_file.clear();
+    m_file.seekg(static_cast<std::streamoff>(p_offset));
+    m_file.read(reinterpret_cast<char*>(p_out.data()),
+                static_cast<std::streamsize>(p_out.size()));
+    m_bytes_read += p_out.size();
+    return static_cast<bool>(m_file);
+  }
+
+  std::ifstream m_file;
+  std::vector<zone_map> m_zones;
+  std::size_t m_columns_read = 0;
+  std::uint64_t m_bytes_read = 0;
+};
+}  // namespace hal::mpl::tools
@@ -0,0 +1,368 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iterator>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <libhal-mpl/conversion.hpp>
+#include <libhal-mpl/sample_log.hpp>
+
+#include "column_store.hpp"
+#include "statistics.hpp"
+
+namespace {
+using namespace hal::mpl;
+using namespace hal::mpl::tools;
+
+/// Raw 20-bit pressure counts per pascal
+constexpr double counts_per_pascal = 4.0;
+
+double to_pascals_20(std::uint32_t p_pressure)
+{
+  return static_cast<double>(to_pascals(p_pressure << 4));
+}
+
+int build(const std::string& p_store, std::span<const std::string> p_logs)
+{
+  column_store_writer writer(p_store);
+  std::uint64_t epoch = 0;
+  std::uint32_t previous = 0;
+  std::size_t rows = 0;
+
+  for (const auto& path : p_logs) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+      std::fprintf(stderr, "%s: unreadable\n", path.c_str());
+      return EXIT_FAILURE;
+    }
+    std::vector<hal::byte> log((std::istreambuf_iterator<char>(file)),
+                               std::istreambuf_iterator<char>());
+
+    for (std::size_t offset = 0; offset + sample_record_size <= log.size();
+         offset += sample_record_size) {
+      auto record =
+        decode(std::span(log).subspan(offset).first<sample_record_size>());
+      // Log timestamps are 32-bit milliseconds and wrap every 49.7 days
+      if (rows != 0 && record.timestamp < previous) {
+        epoch += std::uint64_t(1) << 32;
+      }
+      previous = record.timestamp;
+
+      if (!writer.append({ .timestamp = epoch + record.timestamp,
+                           .pressure = record.pressure >> 4,
+                           .temperature = record.temperature })) {
+        std::fprintf(stderr, "%s: failed at record %zu\n",
+                     path.c_str(),
+                     offset / sample_record_size);
+        return EXIT_FAILURE;
+      }
+      rows++;
+    }
+  }
+
+  if (!writer.finish()) {
+    std::fprintf(stderr, "%s: write failed\n", p_store.c_str());
+    return EXIT_FAILURE;
+  }
+  std::printf("rows=%zu\n", rows);
+  return EXIT_SUCCESS;
+}
+
+void print_io(const column_store_reader& p_reader, std::size_t p_blocks_read)
+{
+  std::fprintf(stderr,
+               "blocks_read=%zu/%zu columns_read=%zu bytes_read=%llu\n",
+               p_blocks_read,
+               p_reader.zones().size(),
+               p_reader.columns_read(),
+               static_cast<unsigned long long>(p_reader.bytes_read()));
+}
+
+/// Summary of the rows with timestamps in [p_from, p_to]
+int range(column_store_reader& p_reader,
+          std::uint64_t p_from,
+          std::uint64_t p_to)
+{
+  statistics pressure;
+  statistics temperature;
+  std::vector<std::uint64_t> timestamps;
+  std::vector<std::uint32_t> pressures;
+  std::vector<std::int16_t> temperatures;
+  std::size_t blocks_read = 0;
+
+  for (std::size_t block = 0; block < p_reader.zones().size(); block++) {
+    const auto& zone = p_reader.zones()[block];
+    if (zone.max_timestamp < p_from || zone.min_timestamp > p_to) {
+      continue;
+    }
+    blocks_read++;
+    if (!p_reader.read_timestamps(block, timestamps) ||
+        !p_reader.read_pressures(block, pressures) ||
+        !p_reader.read_temperatures(block, temperatures)) {
+      std::fprintf(stderr, "block %zu is corrupt\n", block);
+      return EXIT_FAILURE;
+    }
+    for (std::size_t row = 0; row < timestamps.size(); row++) {
+      if (timestamps[row] >= p_from && timestamps[row] <= p_to) {
+        pressure.add(to_pascals_20(pressures[row]));
+        temperature.add(static_cast<double>(to_celsius(temperatures[row])));
+      }
+    }
+  }
+
+  std::printf("rows=%zu pressure_pa[mean=%.2f min=%.2f max=%.2f] "
+              "temperature_c[mean=%.2f min=%.2f max=%.2f]\n",
+              pressure.count,
+              pressure.mean,
+              pressure.min,
+              pressure.max,
+              temperature.mean,
+              temperature.min,
+              temperature.max);
+  print_io(p_reader, blocks_read);
+  return EXIT_SUCCESS;
+}
+
+/// Collects consecutive matching rows into intervals and prints them
+class interval_printer
+{
+public:
+  void add(std::uint64_t p_timestamp, double p_value)
+  {
+    if (!m_open) {
+      m_open = true;
+      m_start = p_timestamp;
+      m_extreme = p_value;
+    }
+    m_end = p_timestamp;
+    m_extreme = std::max(m_extreme, p_value);
+  }
+
+  /// A row that does not match ends the current interval
+  void end()
+  {
+    if (m_open) {
+      std::printf("%llu %llu %.2f\n",
+                  static_cast<unsigned long long>(m_start),
+                  static_cast<unsigned long long>(m_end),
+                  m_extreme);
+      m_count++;
+    }
+    m_open = false;
+  }
+
+  [[nodiscard]] std::size_t count() const
+  {
+    return m_count;
+  }
+
+private:
+  bool m_open = false;
+  std::uint64_t m_start = 0;
+  std::uint64_t m_end = 0;
+  double m_extreme = 0.0;
+  std::size_t m_count = 0;
+};
+
+/// Intervals where pressure is below p_pascals, with their depth below it
+int below(column_store_reader& p_reader, double p_pascals)
+{
+  auto threshold = static_cast<std::uint32_t>(p_pascals * counts_per_pascal);
+  std::vector<std::uint64_t> timestamps;
+  std::vector<std::uint32_t> pressures;
+  interval_printer intervals;
+  std::size_t blocks_read = 0;
+
+  std::printf("# start_ms end_ms deepest_pa_below\n");
+  for (std::size_t block = 0; block < p_reader.zones().size(); block++) {
+    if (p_reader.zones()[block].min_pressure >= threshold) {
+      intervals.end();
+      continue;
+    }
+    blocks_read++;
+    if (!p_reader.read_timestamps(block, timestamps) ||
+        !p_reader.read_pressures(block, pressures)) {
+      std::fprintf(stderr, "block %zu is corrupt\n", block);
+      return EXIT_FAILURE;
+    }
+    for (std::size_t row = 0; row < timestamps.size(); row++) {
+      if (pressures[row] < threshold) {
+        intervals.add(timestamps[row],
+                      p_pascals - to_pascals_20(pressures[row]));
+      } else {
+        intervals.end();
+      }
+    }
+  }
+  intervals.end();
+
+  std::printf("# intervals=%zu\n", intervals.count());
+  print_io(p_reader, blocks_read);
+  return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Intervals where pressure is more than p_pascals below its maximum
+ * over the preceding p_window milliseconds
+ *
+ * A block can only hold the end of such a drop if its minimum is more than
+ * p_pascals below the maximum of the blocks overlapping its window. Only
+ * those blocks and the blocks in their windows are read.
+ */
+int drops(column_store_reader& p_reader,
+          double p_pascals,
+          std::uint64_t p_window)
+{
+  auto zones = p_reader.zones();
+  auto limit = p_pascals * counts_per_pascal;
+  std::vector<bool> needed(zones.size(), false);
+
+  std::size_t first = 0;
+  for (std::size_t block = 0; block < zones.size(); block++) {
+    auto window_start = zones[block].min_timestamp > p_window
+                          ? zones[block].min_timestamp - p_window
+                          : 0;
+    while (zones[first].max_timestamp < window_start) {
+      first++;
+    }
+    std::uint32_t highest = 0;
+    for (auto i = first; i <= block; i++) {
+      highest = std::max(highest, zones[i].max_pressure);
+    }
+    if (highest - zones[block].min_pressure > limit) {
+      for (auto i = first; i <= block; i++) {
+        needed[i] = true;
+      }
+    }
+  }
+
+  struct point
+  {
+    std::uint64_t timestamp;
+    std::uint32_t pressure;
+  };
+  // Decreasing pressures, the front is the maximum of the window
+  std::deque<point> maxima;
+  std::vector<std::uint64_t> timestamps;
+  std::vector<std::uint32_t> pressures;
+  interval_printer intervals;
+  std::size_t blocks_read = 0;
+
+  std::printf("# start_ms end_ms largest_drop_pa\n");
+  for (std::size_t block = 0; block < zones.size(); block++) {
+    if (!needed[block]) {
+      // Blocks are only skipped when no window reaching past them can drop
+      intervals.end();
+      maxima.clear();
+      continue;
+    }
+    blocks_read++;
+    if (!p_reader.read_timestamps(block, timestamps) ||
+        !p_reader.read_pressures(block, pressures)) {
+      std::fprintf(stderr, "block %zu is corrupt\n", block);
+      return EXIT_FAILURE;
+    }
+
+    for (std::size_t row = 0; row < timestamps.size(); row++) {
+      auto now = timestamps[row];
+      while (!maxima.empty() && maxima.front().timestamp + p_window < now) {
+        maxima.pop_front();
+      }
+      while (!maxima.empty() && maxima.back().pressure <= pressures[row]) {
+        maxima.pop_back();
+      }
+      maxima.push_back({ .timestamp = now, .pressure = pressures[row] });
+
+      auto drop = maxima.front().pressure - pressures[row];
+      if (drop > limit) {
+        intervals.add(now, drop / counts_per_pascal);
+      } else {
+        intervals.end();
+      }
+    }
+  }
+  intervals.end();
+
+  std::printf("# intervals=%zu\n", intervals.count());
+  print_io(p_reader, blocks_read);
+  return EXIT_SUCCESS;
+}
+
+void print_usage(const char* p_program)
+{
+  std::fprintf(stderr,
+               "usage: %s build STORE LOG...\n"
+               "       %s range STORE FROM_MS TO_MS\n"
+               "       %s below STORE PASCALS\n"
+               "       %s drops STORE PASCALS WINDOW_MS\n"
+               "  build  convert sample logs, in time order, to a column "
+               "store\n"
+               "  range  summarize the samples between two times\n"
+               "  below  print intervals with pressure below a threshold\n"
+               "  drops  print intervals where pressure fell more than "
+               "PASCALS within WINDOW_MS, e.g. 300 3600000 for 3 hPa in an "
+               "hour\n",
+               p_program,
+               p_program,
+               p_program,
+               p_program);
+}
+}  // namespace
+
+int main(int p_argc, char** p_argv)
+{
+  std::vector<std::string> arguments(p_argv + 1, p_argv + p_argc);
+  if (arguments.size() < 2) {
+    print_usage(p_argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  const auto& command = arguments[0];
+  const auto& store = arguments[1];
+  if (command == "build" && arguments.size() >= 3) {
+    return build(store, std::span(arguments).subspan(2));
+  }
+
+  auto reader = column_store_reader::open(store);
+  if (!reader) {
+    std::fprintf(stderr, "%s: not a column store\n", store.c_str());
+    return EXIT_FAILURE;
+  }
+
+  if (command == "range" && arguments.size() == 4) {
+    return range(*reader,
+                 std::strtoull(arguments[2].c_str(), nullptr, 10),
+                 std::strtoull(arguments[3].c_str(), nullptr, 10));
+  }
+  if (command == "below" && arguments.size() == 3) {
+    return below(*reader, std::strtod(arguments[2].c_str(), nullptr));
+  }
+  if (command == "drops" && arguments.size() == 4) {
+    return drops(*reader,
+                 std::strtod(arguments[2].c_str(), nullptr),
+                 std::strtoull(arguments[3].c_str(), nullptr, 10));
+  }
+
+  print_usage(p_argv[0]);
+  return EXIT_FAILURE;
+}
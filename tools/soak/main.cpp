@@ -0,0 +1,738 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <libhal-mpl/configuration.hpp>
+#include <libhal-mpl/conversion.hpp>
+#include <libhal-mpl/drift_compensation.hpp>
+#include <libhal-mpl/mpl3115a2.hpp>
+#include <libhal-mpl/sample_cache.hpp>
+#include <libhal-mpl/sample_history.hpp>
+#include <libhal-mpl/sample_log.hpp>
+
+#include "mpl3115a2_simulator.hpp"
+
+/**
+ * Heap accounting. The driver must not allocate once running, so every
+ * allocation a session makes after its warm up window is reported, as is live
+ * heap that keeps growing between windows.
+ */
+namespace {
+std::atomic<std::int64_t> live_heap_bytes = 0;
+std::atomic<std::int64_t> peak_heap_bytes = 0;
+thread_local std::uint64_t thread_allocations = 0;
+thread_local std::int64_t thread_heap_bytes = 0;
+/// Set while the harness drives the register model, whose containers
+/// allocate as a real device would not
+thread_local bool model_scope = false;
+
+/// Keeps the size in front of each block, aligned for any scalar type
+constexpr std::size_t heap_header = alignof(std::max_align_t);
+static_assert(heap_header >= 2 * sizeof(std::size_t));
+
+void* allocate(std::size_t p_size)
+{
+  auto* block = static_cast<unsigned char*>(std::malloc(p_size + heap_header));
+  if (block == nullptr) {
+    throw std::bad_alloc();
+  }
+  auto* header = reinterpret_cast<std::size_t*>(block);
+  header[0] = p_size;
+  // Whether the block counts towards its thread's heap
+  header[1] = model_scope ? 0 : 1;
+
+  auto size = static_cast<std::int64_t>(p_size);
+  if (!model_scope) {
+    thread_allocations++;
+    thread_heap_bytes += size;
+  }
+  auto live = live_heap_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+  auto peak = peak_heap_bytes.load(std::memory_order_relaxed);
+  while (live > peak && !peak_heap_bytes.compare_exchange_weak(
+                          peak, live, std::memory_order_relaxed)) {
+  }
+  return block + heap_header;
+}
+
+void release(void* p_pointer)
+{
+  if (p_pointer == nullptr) {
+    return;
+  }
+  auto* block = static_cast<unsigned char*>(p_pointer) - heap_header;
+  auto* header = reinterpret_cast<std::size_t*>(block);
+  auto size = static_cast<std::int64_t>(header[0]);
+  if (header[1] != 0) {
+    thread_heap_bytes -= size;
+  }
+  live_heap_bytes.fetch_sub(size, std::memory_order_relaxed);
+  std::free(block);
+}
+}  // namespace
+
+void* operator new(std::size_t p_size)
+{
+  return allocate(p_size);
+}
+
+void* operator new[](std::size_t p_size)
+{
+  return allocate(p_size);
+}
+
+void operator delete(void* p_pointer) noexcept
+{
+  release(p_pointer);
+}
+
+void operator delete[](void* p_pointer) noexcept
+{
+  release(p_pointer);
+}
+
+void operator delete(void* p_pointer, std::size_t) noexcept
+{
+  release(p_pointer);
+}
+
+void operator delete[](void* p_pointer, std::size_t) noexcept
+{
+  release(p_pointer);
+}
+
+namespace {
+using namespace hal::mpl;
+
+struct options
+{
+  /// Samples per session
+  std::uint64_t samples = 25'000'000;
+  std::uint64_t seed = 1;
+  /// Uptime at the start of every session. The default puts the u32
+  /// millisecond timestamps of sample logs a minute before they wrap.
+  std::uint64_t start_ms = (1ULL << 32) - 60'000;
+  /// Modeled idle time between samples, to cover weeks of uptime
+  std::uint64_t period_ms = 0;
+};
+
+/// Windows each session is split into to detect drift and leaks
+constexpr std::uint64_t windows = 10;
+/// Samples between retry limit boundary checks
+constexpr std::uint64_t boundary_interval = 1'000'000;
+constexpr std::uint64_t nanoseconds_per_bit = 2'500;  // 400 kHz I2C
+
+/**
+ * @brief Log-linear latency histogram, 16 buckets per power of two, so
+ * percentiles are within 6% without storing every sample
+ */
+class latency_histogram
+{
+public:
+  void add(std::uint64_t p_value)
+  {
+    m_counts[index(p_value)]++;
+    m_count++;
+    m_max = std::max(m_max, p_value);
+  }
+
+  std::uint64_t percentile(double p_fraction) const
+  {
+    auto target = static_cast<std::uint64_t>(
+      std::ceil(p_fraction * static_cast<double>(m_count)));
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < m_counts.size(); i++) {
+      seen += m_counts[i];
+      if (seen >= target && seen != 0) {
+        return std::min(lower_bound(i), m_max);
+      }
+    }
+    return m_max;
+  }
+
+  std::uint64_t max() const
+  {
+    return m_max;
+  }
+
+  void clear()
+  {
+    *this = latency_histogram{};
+  }
+
+private:
+  static constexpr int sub_bits = 4;
+  static constexpr std::uint64_t sub_buckets = 1U << sub_bits;
+
+  static std::size_t index(std::uint64_t p_value)
+  {
+    if (p_value < sub_buckets) {
+      return p_value;
+    }
+    auto msb = 63 - std::countl_zero(p_value);
+    auto sub = (p_value >> (msb - sub_bits)) & (sub_buckets - 1);
+    return static_cast<std::size_t>(msb - sub_bits + 1) * sub_buckets + sub;
+  }
+
+  static std::uint64_t lower_bound(std::size_t p_index)
+  {
+    if (p_index < sub_buckets) {
+      return p_index;
+    }
+    auto msb = p_index / sub_buckets + sub_bits - 1;
+    auto sub = p_index % sub_buckets;
+    return (sub_buckets + sub) << (msb - sub_bits);
+  }
+
+  std::array<std::uint64_t, 64 * sub_buckets> m_counts{};
+  std::uint64_t m_count = 0;
+  std::uint64_t m_max = 0;
+};
+
+/// Nanosecond clock that advances with modeled bus time and idle time
+class soak_clock : public hal::steady_clock
+{
+public:
+  std::uint64_t ticks = 0;
+
+private:
+  frequency_t driver_frequency() override
+  {
+    return frequency_t{ .operating_frequency = 1e9f };
+  }
+
+  uptime_t driver_uptime() override
+  {
+    return uptime_t{ .ticks = ticks };
+  }
+};
+
+struct session
+{
+  std::string_view mode;
+  std::uint64_t samples = 0;
+  std::uint64_t transactions = 0;
+  std::uint64_t injected_timeouts = 0;
+  latency_histogram modeled_ns;
+  latency_histogram host_ns;
+  /// Median host latency of the first window after warm up and of the last
+  std::uint64_t first_window_p50 = 0;
+  std::uint64_t last_window_p50 = 0;
+  std::uint64_t steady_allocations = 0;
+  std::int64_t heap_growth = 0;
+  std::uint64_t log_timestamp_wraps = 0;
+  std::uint64_t modeled_uptime_ms = 0;
+  std::vector<std::string> anomalies;
+
+  void anomaly(std::string p_description)
+  {
+    // Report the first few of a kind, a broken invariant repeats every sample
+    if (anomalies.size() < 16) {
+      anomalies.push_back(std::move(p_description));
+    }
+  }
+};
+
+/// Simulated device, modeled time and the bookkeeping common to every mode
+class harness
+{
+public:
+  harness(const options& p_options,
+          std::string_view p_mode,
+          std::uint64_t p_id)
+    : m_options(p_options)
+    , m_random(p_options.seed * 1'000'003 + p_id)
+  {
+    m_session.mode = p_mode;
+    clock.ticks = p_options.start_ms * 1'000'000;
+    m_last_log_ms = static_cast<std::uint32_t>(p_options.start_ms);
+  }
+
+  mpl3115a2_simulator simulator;
+  soak_clock clock;
+
+  std::uint32_t random(std::uint32_t p_bound)
+  {
+    return static_cast<std::uint32_t>(m_random() % p_bound);
+  }
+
+  /// Run `p_action` on the register model without counting its allocations
+  template<typename Action>
+  void model(Action&& p_action)
+  {
+    model_scope = true;
+    p_action();
+    model_scope = false;
+  }
+
+  /// Random raw OUT_P word of a plausible pressure
+  std::uint32_t random_pressure()
+  {
+    return (0x5A000 + random(0x10000)) << 4;
+  }
+
+  /// Run `p_step` for every sample, timing it and checking for drift and
+  /// leaks. `p_step` returns the samples it produced.
+  template<typename Step>
+  session run(Step&& p_step)
+  {
+    auto window = std::max<std::uint64_t>(m_options.samples / windows, 1);
+    latency_histogram window_host;
+    std::int64_t window_heap = 0;
+    std::uint64_t window_allocations = 0;
+    std::uint64_t next_window = window;
+
+    while (m_session.samples < m_options.samples) {
+      auto modeled_start = clock.ticks;
+      auto host_start = std::chrono::steady_clock::now();
+      auto produced = p_step(m_session.samples);
+      auto host = std::chrono::steady_clock::now() - host_start;
+      account_bus();
+
+      auto host_ns = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(host).count());
+      m_session.host_ns.add(host_ns);
+      window_host.add(host_ns);
+      m_session.modeled_ns.add(clock.ticks - modeled_start);
+      m_session.samples += produced;
+      log_timestamp();
+      clock.ticks += m_options.period_ms * 1'000'000;
+
+      if (m_session.samples < next_window) {
+        continue;
+      }
+      auto index = next_window / window;
+      next_window += window;
+      if (index == 1) {
+        // Warm up: caches filled, one-time allocations made
+        window_heap = thread_heap_bytes;
+        window_allocations = thread_allocations;
+      } else if (index == 2) {
+        m_session.first_window_p50 = window_host.percentile(0.5);
+      }
+      m_session.last_window_p50 = window_host.percentile(0.5);
+      window_host.clear();
+    }
+
+    m_session.transactions = simulator.transactions;
+    m_session.steady_allocations = thread_allocations - window_allocations;
+    m_session.heap_growth = thread_heap_bytes - window_heap;
+    m_session.modeled_uptime_ms =
+      clock.ticks / 1'000'000 - m_options.start_ms;
+    return std::move(m_session);
+  }
+
+  session& report()
+  {
+    return m_session;
+  }
+
+  /// Every boundary_interval samples, make a conversion take exactly as
+  /// many status reads as the driver's u16 retry counter allows, then one
+  /// more. Returns the reads the next conversion takes.
+  std::uint32_t conversion_reads(std::uint64_t p_sample)
+  {
+    auto phase = p_sample % boundary_interval;
+    if (p_sample >= boundary_interval && phase == 0) {
+      return mpl3115a2::default_max_polling_retries;
+    }
+    if (beyond_retry_limit(p_sample)) {
+      return mpl3115a2::default_max_polling_retries + 1;
+    }
+    return random(8);
+  }
+
+  /// Whether the sample of `p_sample` was made to exceed the retry limit
+  static bool beyond_retry_limit(std::uint64_t p_sample)
+  {
+    return p_sample >= boundary_interval && p_sample % boundary_interval == 1;
+  }
+
+private:
+  void account_bus()
+  {
+    clock.ticks += (simulator.bus_bits - m_last_bits) * nanoseconds_per_bit;
+    m_last_bits = simulator.bus_bits;
+  }
+
+  /// Stamp a sample log record like the firmware does and check that the
+  /// wrap-safe difference of the u32 timestamps matches the real uptime
+  void log_timestamp()
+  {
+    auto uptime_ms = clock.ticks / 1'000'000;
+    auto record = decode(encode(sample_record{
+      .timestamp = static_cast<std::uint32_t>(uptime_ms),
+      .pressure = 0,
+      .temperature = 0,
+    }));
+    auto elapsed = static_cast<std::uint32_t>(record.timestamp - m_last_log_ms);
+    if (record.timestamp < m_last_log_ms) {
+      m_session.log_timestamp_wraps++;
+    }
+    if (elapsed != uptime_ms - m_last_uptime_ms && m_last_uptime_ms != 0) {
+      m_session.anomaly("log timestamp difference disagrees with uptime");
+    }
+    m_last_log_ms = record.timestamp;
+    m_last_uptime_ms = uptime_ms;
+  }
+
+  const options& m_options;
+  std::mt19937_64 m_random;
+  session m_session;
+  std::uint64_t m_last_bits = 0;
+  std::uint32_t m_last_log_ms = 0;
+  std::uint64_t m_last_uptime_ms = 0;
+};
+
+/// Check a library u32 counter against a 64-bit shadow count
+void check_counter(session& p_session,
+                   std::string_view p_name,
+                   std::uint64_t p_expected,
+                   std::uint32_t p_counter,
+                   bool p_saturates)
+{
+  auto expected = p_saturates ? std::min<std::uint64_t>(p_expected, UINT32_MAX)
+                              : p_expected % (1ULL << 32);
+  if (p_counter != expected) {
+    p_session.anomaly(std::string(p_name) + " counter is off");
+  }
+  if (!p_saturates && p_expected > UINT32_MAX) {
+    p_session.anomaly(std::string(p_name) + " counter wrapped");
+  }
+}
+
+/// Triggered conversions alternating between barometer and altimeter mode,
+/// feeding the drift compensator and a sample history
+session soak_one_shot(const options& p_options)
+{
+  harness bench(p_options, "one_shot", 0);
+  auto device = mpl3115a2::create(bench.simulator).value();
+  drift_compensator compensator(0x1900);
+  sample_history<64> history;
+  std::uint64_t learned = 0;
+
+  auto result = bench.run([&](std::uint64_t p_sample) -> std::uint64_t {
+    auto& report = bench.report();
+    auto mode = (p_sample & 1) ? mpl3115a2::mode::altimeter
+                               : mpl3115a2::mode::barometer;
+    auto word = bench.random_pressure();
+    auto temperature = static_cast<std::int16_t>(0x1400 + bench.random(0x800));
+    bench.simulator.pressure = word;
+    bench.simulator.altitude = word;
+    bench.simulator.temperature = temperature;
+    bench.simulator.conversion_reads = bench.conversion_reads(p_sample);
+
+    auto sample = [&]() -> hal::result<mpl3115a2::raw_sample_t> {
+      HAL_CHECK(device.trigger_conversion(mode));
+      return device.read_sample();
+    }();
+
+    if (harness::beyond_retry_limit(p_sample)) {
+      if (sample) {
+        report.anomaly("read past the retry limit did not time out");
+      }
+      report.injected_timeouts++;
+      return 1;
+    }
+    if (!sample) {
+      report.anomaly("read failed");
+      return 1;
+    }
+    if (sample.value().pressure != word ||
+        sample.value().temperature != temperature) {
+      report.anomaly("sample does not match the converted value");
+    }
+
+    if (mode == mpl3115a2::mode::barometer) {
+      compensator.learn(sample.value());
+      learned++;
+      check_counter(report,
+                    "drift_compensator::samples",
+                    learned,
+                    compensator.samples(),
+                    true);
+      if (!std::isfinite(compensator.coefficient())) {
+        report.anomaly("drift coefficient is not finite");
+      }
+    }
+
+    auto pushed = history.push({
+      .timestamp = bench.clock.ticks,
+      .pressure = to_pascals(word),
+      .altitude = to_meters(word),
+      .temperature = to_celsius(temperature),
+    });
+    if (!pushed) {
+      report.anomaly("sample_history rejected a later timestamp");
+    } else if (history.at(bench.clock.ticks).value().pressure !=
+               to_pascals(word)) {
+      report.anomaly("sample_history lost the newest sample");
+    }
+    return 1;
+  });
+
+  return result;
+}
+
+constexpr auto continuous_configuration = make_configuration<{
+  .mode = mpl3115a2::mode::barometer,
+  .oversampling = oversampling_ratio::os1,
+  .acquire = acquisition::continuous,
+}>();
+
+/// Active mode polled with `try_read_sample()`
+session soak_continuous(const options& p_options)
+{
+  harness bench(p_options, "continuous", 1);
+  auto device =
+    mpl3115a2::create(bench.simulator, continuous_configuration).value();
+
+  return bench.run([&](std::uint64_t) -> std::uint64_t {
+    auto& report = bench.report();
+    auto word = bench.random_pressure();
+    bench.simulator.pressure = word;
+    bench.simulator.conversion_reads = bench.random(8);
+
+    // A conversion is already running with the previous value, skip it
+    for (std::uint32_t polls = 0; polls < 2 * 8 + 2; polls++) {
+      auto sample = device.try_read_sample();
+      if (!sample) {
+        report.anomaly("poll failed");
+        return 1;
+      }
+      if (sample.value() && sample.value()->pressure == word) {
+        return 1;
+      }
+    }
+    report.anomaly("active mode stopped converting");
+    return 1;
+  });
+}
+
+constexpr auto fifo_configuration = make_configuration<{
+  .mode = mpl3115a2::mode::barometer,
+  .oversampling = oversampling_ratio::os1,
+  .acquire = acquisition::fifo,
+}>();
+
+/// FIFO filled by 1 to 40 conversions, including overflows, and drained
+session soak_fifo(const options& p_options)
+{
+  harness bench(p_options, "fifo", 2);
+  auto device = mpl3115a2::create(bench.simulator, fifo_configuration).value();
+  std::array<mpl3115a2::raw_sample_t, mpl3115a2::fifo_capacity> samples{};
+  bench.simulator.fifo.clear();
+
+  return bench.run([&](std::uint64_t) -> std::uint64_t {
+    auto& report = bench.report();
+    auto conversions = 1 + bench.random(40);
+    auto first = bench.random_pressure();
+    bench.model([&]() {
+      for (std::uint32_t i = 0; i < conversions; i++) {
+        bench.simulator.pressure = first + (i << 4);
+        bench.simulator.convert();
+      }
+    });
+
+    auto read = device.read_fifo(samples);
+    if (!read) {
+      report.anomaly("FIFO read failed");
+      return conversions;
+    }
+    auto expected = std::min<std::uint32_t>(conversions,
+                                            mpl3115a2::fifo_capacity);
+    // Circular mode keeps the newest samples
+    auto oldest = first + ((conversions - expected) << 4);
+    if (read.value().samples.size() != expected ||
+        read.value().overflow != (conversions > mpl3115a2::fifo_capacity) ||
+        read.value().samples.front().pressure != oldest ||
+        read.value().samples.back().pressure != first + ((conversions - 1)
+                                                         << 4)) {
+      report.anomaly("FIFO contents or overflow flag are wrong");
+    }
+    return conversions;
+  });
+}
+
+/// Three readers per control tick sharing conversions through a cache
+session soak_cached(const options& p_options)
+{
+  constexpr std::uint64_t readers = 3;
+  harness bench(p_options, "cached", 3);
+  auto device = mpl3115a2::create(bench.simulator).value();
+  sample_cache cache(device, bench.clock, std::chrono::milliseconds(2));
+  std::uint64_t reads = 0;
+
+  return bench.run([&](std::uint64_t p_sample) -> std::uint64_t {
+    auto& report = bench.report();
+    bench.simulator.pressure = bench.random_pressure();
+    bench.simulator.conversion_reads = bench.random(8);
+
+    for (std::uint64_t i = 0; i < readers; i++) {
+      if (!cache.read()) {
+        report.anomaly("cached read failed");
+      }
+      reads++;
+    }
+    // Control tick
+    bench.clock.ticks += 1'000'000;
+
+    if (p_sample % 4096 == 0) {
+      check_counter(report,
+                    "sample_cache conversions + coalesced",
+                    reads,
+                    cache.conversions() + cache.coalesced(),
+                    false);
+    }
+    return readers;
+  });
+}
+
+void print_session(const session& p_session)
+{
+  std::printf(
+    "%-10s samples=%llu transactions=%llu uptime_days=%.2f "
+    "modeled_us p50=%.1f p99=%.1f p999=%.1f max=%.1f "
+    "host_ns p50=%llu p99=%llu p999=%llu max=%llu "
+    "host_p50_first=%llu last=%llu steady_allocations=%llu "
+    "heap_growth=%lld log_wraps=%llu injected_timeouts=%llu\n",
+    std::string(p_session.mode).c_str(),
+    static_cast<unsigned long long>(p_session.samples),
+    static_cast<unsigned long long>(p_session.transactions),
+    static_cast<double>(p_session.modeled_uptime_ms) / 86'400'000.0,
+    static_cast<double>(p_session.modeled_ns.percentile(0.5)) / 1e3,
+    static_cast<double>(p_session.modeled_ns.percentile(0.99)) / 1e3,
+    static_cast<double>(p_session.modeled_ns.percentile(0.999)) / 1e3,
+    static_cast<double>(p_session.modeled_ns.max()) / 1e3,
+    static_cast<unsigned long long>(p_session.host_ns.percentile(0.5)),
+    static_cast<unsigned long long>(p_session.host_ns.percentile(0.99)),
+    static_cast<unsigned long long>(p_session.host_ns.percentile(0.999)),
+    static_cast<unsigned long long>(p_session.host_ns.max()),
+    static_cast<unsigned long long>(p_session.first_window_p50),
+    static_cast<unsigned long long>(p_session.last_window_p50),
+    static_cast<unsigned long long>(p_session.steady_allocations),
+    static_cast<long long>(p_session.heap_growth),
+    static_cast<unsigned long long>(p_session.log_timestamp_wraps),
+    static_cast<unsigned long long>(p_session.injected_timeouts));
+}
+
+/// Findings from the numbers, added to the anomalies of `p_session`
+void check_trends(session& p_session)
+{
+  if (p_session.steady_allocations != 0) {
+    p_session.anomaly("allocates after warm up");
+  }
+  if (p_session.heap_growth > 0) {
+    p_session.anomaly("live heap grew after warm up");
+  }
+  // Generous, the host is shared, but a cost growing with uptime shows
+  if (p_session.last_window_p50 > 2 * p_session.first_window_p50 + 200) {
+    p_session.anomaly("host latency drifted upwards");
+  }
+}
+
+void print_usage(const char* p_program)
+{
+  std::fprintf(stderr,
+               "usage: %s [--samples N] [--seed N] [--start-ms N] "
+               "[--period-ms N]\n"
+               "  --samples N    samples per mode (default 25000000)\n"
+               "  --start-ms N   uptime at the start (default 2^32 - 60000, "
+               "a minute\n"
+               "                 before u32 log timestamps wrap)\n"
+               "  --period-ms N  modeled idle time between samples "
+               "(default 0)\n",
+               p_program);
+}
+}  // namespace
+
+int main(int p_argc, char** p_argv)
+{
+  options settings;
+  for (int i = 1; i < p_argc; i++) {
+    std::string_view argument(p_argv[i]);
+    auto value = [&]() {
+      return std::strtoull(p_argv[++i], nullptr, 10);
+    };
+    if (argument == "--samples" && i + 1 < p_argc) {
+      settings.samples = value();
+    } else if (argument == "--seed" && i + 1 < p_argc) {
+      settings.seed = value();
+    } else if (argument == "--start-ms" && i + 1 < p_argc) {
+      settings.start_ms = value();
+    } else if (argument == "--period-ms" && i + 1 < p_argc) {
+      settings.period_ms = value();
+    } else {
+      print_usage(p_argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  using soak_function = session (*)(const options&);
+  constexpr std::array<soak_function, 4> modes{
+    soak_one_shot, soak_continuous, soak_fifo, soak_cached,
+  };
+  std::array<session, modes.size()> sessions{};
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < modes.size(); i++) {
+    threads.emplace_back([&, i]() { sessions[i] = modes[i](settings); });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto seconds = std::chrono::duration<double>(
+                   std::chrono::steady_clock::now() - start)
+                   .count();
+
+  bool passed = true;
+  std::uint64_t total = 0;
+  for (auto& result : sessions) {
+    check_trends(result);
+    print_session(result);
+    for (const auto& anomaly : result.anomalies) {
+      std::printf("  %s: %s\n", std::string(result.mode).c_str(),
+                  anomaly.c_str());
+    }
+    passed = passed && result.anomalies.empty();
+    total += result.samples;
+  }
+
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  std::printf("total_samples=%llu wall_s=%.1f peak_heap_bytes=%lld "
+              "max_rss_kb=%ld result=%s\n",
+              static_cast<unsigned long long>(total),
+              seconds,
+              static_cast<long long>(peak_heap_bytes.load()),
+              usage.ru_maxrss,
+              passed ? "pass" : "FAIL");
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
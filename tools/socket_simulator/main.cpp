@@ -0,0 +1,561 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <list>
+#include <memory>
+#include <numbers>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <libhal-mpl/configuration.hpp>
+#include <libhal-mpl/conversion.hpp>
+#include <libhal-mpl/mpl3115a2.hpp>
+#include <libhal-mpl/polling.hpp>
+
+#include "mpl3115a2_simulator.hpp"
+#include "protocol.hpp"
+#include "socket_i2c.hpp"
+#include "statistics.hpp"
+
+namespace {
+using namespace hal::mpl;
+using namespace hal::mpl::tools;
+using clock_type = std::chrono::steady_clock;
+
+volatile std::sig_atomic_t stop_requested = 0;
+
+void request_stop(int)
+{
+  stop_requested = 1;
+}
+
+/**
+ * @brief One simulated I2C bus with an MPL3115A2, served on its own socket
+ *
+ * The register model completes conversions when told to, and this class
+ * tells it to in real time: a one-shot conversion completes the conversion
+ * time of its oversampling ratio after the trigger, and active mode converts
+ * once per time step. Transactions occupy the bus for their modeled
+ * duration, so transactions from different clients queue up behind each other.
+ */
+class simulated_bus
+{
+public:
+  simulated_bus(std::string p_path, hal::hertz p_clock_rate, double p_offset)
+    : m_path(std::move(p_path))
+    , m_clock_rate(p_clock_rate)
+    , m_pressure_offset(p_offset)
+    , m_start(clock_type::now())
+    , m_free_at(m_start)
+  {
+    // Conversions only complete from advance(), never from status reads
+    m_device.conversion_reads = UINT32_MAX;
+  }
+
+  const std::string& path() const
+  {
+    return m_path;
+  }
+
+  /**
+   * @brief Run one transaction once the bus is free
+   *
+   * @return the time the transaction ends, when the response is due, and the
+   * response bytes
+   */
+  std::pair<clock_type::time_point, std::vector<hal::byte>> transact(
+    hal::byte p_address,
+    std::span<const hal::byte> p_data_out,
+    std::size_t p_read_length)
+  {
+    auto start = std::max(clock_type::now(), m_free_at);
+    advance(start);
+
+    auto before = m_device.registers[ctrl_reg1];
+    auto bits = m_device.bus_bits;
+    std::vector<hal::byte> response(1 + p_read_length);
+    auto outcome =
+      m_device.transaction(p_address,
+                           p_data_out,
+                           std::span(response).subspan(1),
+                           hal::never_timeout());
+    if (outcome) {
+      response[0] = socket_protocol::status_success;
+    } else {
+      response.resize(1);
+      response[0] = static_cast<hal::byte>(
+        std::errc::no_such_device_or_address);
+    }
+    schedule(start, before, m_device.registers[ctrl_reg1]);
+
+    // A NACKed address byte, start and stop still take the bus
+    auto transaction_bits = std::max<std::uint64_t>(m_device.bus_bits - bits,
+                                                    11);
+    m_free_at = start + std::chrono::duration_cast<clock_type::duration>(
+                          std::chrono::duration<double>(
+                            static_cast<double>(transaction_bits) /
+                            static_cast<double>(m_clock_rate)));
+    m_transactions++;
+    return { m_free_at, std::move(response) };
+  }
+
+  std::uint64_t transactions() const
+  {
+    return m_transactions;
+  }
+
+  std::uint64_t conversions() const
+  {
+    return m_conversions;
+  }
+
+private:
+  static clock_type::duration to_duration(std::chrono::milliseconds p_time)
+  {
+    return std::chrono::duration_cast<clock_type::duration>(p_time);
+  }
+
+  clock_type::duration conversion_time() const
+  {
+    auto ratio = static_cast<oversampling_ratio>(
+      (m_device.registers[ctrl_reg1] >> 3) & 0x07);
+    return to_duration(hal::mpl::conversion_time(ratio));
+  }
+
+  /// Active mode converts every 2^ST seconds, or back to back when a
+  /// conversion takes longer
+  clock_type::duration time_step() const
+  {
+    auto step = std::chrono::seconds(1U << (m_device.registers[ctrl_reg2] &
+                                            0x0F));
+    return std::max(to_duration(step), conversion_time());
+  }
+
+  /// Start the timers of conversions the transaction at `p_time` triggered
+  void schedule(clock_type::time_point p_time,
+                hal::byte p_before,
+                hal::byte p_after)
+  {
+    bool active = p_after & ctrl_reg1_sbyb;
+    if (!active) {
+      m_next_step.reset();
+    } else if (!(p_before & ctrl_reg1_sbyb)) {
+      m_next_step = p_time + time_step();
+    }
+
+    if (!(p_after & ctrl_reg1_ost)) {
+      m_one_shot_due.reset();
+    } else if (!(p_before & ctrl_reg1_ost) && !active) {
+      m_one_shot_due = p_time + conversion_time();
+    }
+  }
+
+  /// Complete every conversion due by `p_time`
+  void advance(clock_type::time_point p_time)
+  {
+    if (m_one_shot_due && p_time >= *m_one_shot_due) {
+      convert(*m_one_shot_due);
+      m_one_shot_due.reset();
+    }
+
+    // After a long idle period only the samples the FIFO can hold matter
+    std::size_t catch_up = 0;
+    while (m_next_step && p_time >= *m_next_step) {
+      if (catch_up++ > mpl3115a2::fifo_capacity) {
+        m_next_step = p_time + time_step();
+        break;
+      }
+      convert(*m_next_step);
+      *m_next_step += time_step();
+    }
+  }
+
+  void convert(clock_type::time_point p_time)
+  {
+    // Weather scale drift of +-40 Pa over two minutes
+    auto seconds = std::chrono::duration<double>(p_time - m_start).count();
+    auto pascals = 101325.0 + m_pressure_offset +
+                   40.0 * std::sin(2.0 * std::numbers::pi * seconds / 120.0);
+    // OUT_P holds 1/64 Pa in its upper 20 bits
+    m_device.pressure = static_cast<std::uint32_t>(pascals * 4.0) << 4;
+    m_device.convert();
+    m_conversions++;
+  }
+
+  std::string m_path;
+  hal::hertz m_clock_rate;
+  double m_pressure_offset;
+  mpl3115a2_simulator m_device;
+  clock_type::time_point m_start;
+  clock_type::time_point m_free_at;
+  std::optional<clock_type::time_point> m_one_shot_due;
+  std::optional<clock_type::time_point> m_next_step;
+  std::uint64_t m_transactions = 0;
+  std::uint64_t m_conversions = 0;
+};
+
+struct connection
+{
+  int fd = -1;
+  simulated_bus* bus = nullptr;
+  std::vector<hal::byte> received;
+};
+
+struct pending_response
+{
+  clock_type::time_point due;
+  int fd = -1;
+  std::vector<hal::byte> data;
+};
+
+int listen_on(const std::string& p_path)
+{
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (p_path.size() >= sizeof(address.sun_path)) {
+    return -1;
+  }
+  std::memcpy(address.sun_path, p_path.c_str(), p_path.size() + 1);
+  ::unlink(p_path.c_str());
+
+  int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) !=
+        0 ||
+      ::listen(fd, 16) != 0) {
+    ::close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+void send_all(int p_fd, std::span<const hal::byte> p_data)
+{
+  while (!p_data.empty()) {
+    auto sent = ::send(p_fd, p_data.data(), p_data.size(), MSG_NOSIGNAL);
+    if (sent < 0 && errno == EINTR) {
+      continue;
+    }
+    if (sent <= 0) {
+      // The client went away, its connection is closed on the next read
+      return;
+    }
+    p_data = p_data.subspan(static_cast<std::size_t>(sent));
+  }
+}
+
+/// Answer every complete request in the buffer of `p_connection`
+bool handle_requests(connection& p_connection,
+                     std::deque<pending_response>& p_responses)
+{
+  auto& buffer = p_connection.received;
+  std::size_t offset = 0;
+
+  while (buffer.size() - offset >= socket_protocol::request_header_size) {
+    auto header = std::span(buffer).subspan(offset);
+    auto write_length = std::size_t(header[1]) | std::size_t(header[2]) << 8;
+    auto read_length = std::size_t(header[3]) | std::size_t(header[4]) << 8;
+    if (write_length > socket_protocol::max_transfer ||
+        read_length > socket_protocol::max_transfer) {
+      return false;
+    }
+    auto size = socket_protocol::request_header_size + write_length;
+    if (buffer.size() - offset < size) {
+      break;
+    }
+
+    auto [due, data] = p_connection.bus->transact(
+      header[0],
+      header.subspan(socket_protocol::request_header_size, write_length),
+      read_length);
+    p_responses.push_back(pending_response{
+      .due = due,
+      .fd = p_connection.fd,
+      .data = std::move(data),
+    });
+    offset += size;
+  }
+
+  buffer.erase(buffer.begin(), buffer.begin() + offset);
+  return true;
+}
+
+int serve(const std::vector<std::string>& p_paths, hal::hertz p_clock_rate)
+{
+  std::signal(SIGINT, request_stop);
+  std::signal(SIGTERM, request_stop);
+
+  std::vector<std::unique_ptr<simulated_bus>> buses;
+  std::vector<int> listeners;
+  for (const auto& path : p_paths) {
+    int fd = listen_on(path);
+    if (fd < 0) {
+      std::fprintf(stderr, "%s: %s\n", path.c_str(), std::strerror(errno));
+      return EXIT_FAILURE;
+    }
+    listeners.push_back(fd);
+    // Each device reads a little differently, as real ones do
+    auto offset = 3.0 * static_cast<double>(buses.size());
+    buses.push_back(
+      std::make_unique<simulated_bus>(path, p_clock_rate, offset));
+    std::printf("serving %s\n", path.c_str());
+  }
+  std::fflush(stdout);
+
+  std::list<connection> connections;
+  // Responses are due in the order requests arrive on each bus, but buses
+  // are independent, so the earliest is searched for
+  std::deque<pending_response> responses;
+  std::vector<pollfd> descriptors;
+
+  while (!stop_requested) {
+    descriptors.clear();
+    for (auto fd : listeners) {
+      descriptors.push_back({ .fd = fd, .events = POLLIN, .revents = 0 });
+    }
+    for (const auto& client : connections) {
+      descriptors.push_back(
+        { .fd = client.fd, .events = POLLIN, .revents = 0 });
+    }
+
+    timespec wait{};
+    timespec* timeout = nullptr;
+    auto earliest = std::min_element(
+      responses.begin(), responses.end(), [](const auto& p_a, const auto& p_b) {
+        return p_a.due < p_b.due;
+      });
+    if (earliest != responses.end()) {
+      auto remaining = std::max(earliest->due - clock_type::now(),
+                                clock_type::duration::zero());
+      auto nanoseconds =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(remaining).count();
+      wait.tv_sec = static_cast<time_t>(nanoseconds / 1'000'000'000);
+      wait.tv_nsec = static_cast<long>(nanoseconds % 1'000'000'000);
+      timeout = &wait;
+    }
+
+    auto ready = ::ppoll(descriptors.data(), descriptors.size(), timeout,
+                         nullptr);
+    if (ready < 0 && errno != EINTR) {
+      std::perror("ppoll");
+      break;
+    }
+
+    auto now = clock_type::now();
+    std::erase_if(responses, [now](auto& p_response) {
+      if (p_response.due > now) {
+        return false;
+      }
+      send_all(p_response.fd, p_response.data);
+      return true;
+    });
+    if (ready <= 0) {
+      continue;
+    }
+
+    for (std::size_t i = 0; i < listeners.size(); i++) {
+      if (descriptors[i].revents & POLLIN) {
+        int fd = ::accept4(listeners[i], nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd >= 0) {
+          connections.push_back(
+            connection{ .fd = fd, .bus = buses[i].get(), .received = {} });
+        }
+      }
+    }
+
+    auto descriptor = descriptors.begin() +
+                      static_cast<std::ptrdiff_t>(listeners.size());
+    for (auto client = connections.begin(); client != connections.end();
+         descriptor++) {
+      if (!(descriptor->revents & (POLLIN | POLLHUP | POLLERR))) {
+        client++;
+        continue;
+      }
+
+      std::array<hal::byte, 4096> chunk{};
+      auto received = ::recv(client->fd, chunk.data(), chunk.size(), 0);
+      if (received < 0 && errno == EINTR) {
+        client++;
+        continue;
+      }
+      bool open = received > 0;
+      if (open) {
+        client->received.insert(client->received.end(),
+                                chunk.begin(),
+                                chunk.begin() + received);
+        open = handle_requests(*client, responses);
+      }
+      if (!open) {
+        auto fd = client->fd;
+        std::erase_if(responses, [fd](const auto& p_response) {
+          return p_response.fd == fd;
+        });
+        ::close(fd);
+        client = connections.erase(client);
+        continue;
+      }
+      client++;
+    }
+  }
+
+  for (const auto& client : connections) {
+    ::close(client.fd);
+  }
+  for (std::size_t i = 0; i < listeners.size(); i++) {
+    ::close(listeners[i]);
+    ::unlink(buses[i]->path().c_str());
+    std::printf("%s: transactions=%llu conversions=%llu\n",
+                buses[i]->path().c_str(),
+                static_cast<unsigned long long>(buses[i]->transactions()),
+                static_cast<unsigned long long>(buses[i]->conversions()));
+  }
+  return EXIT_SUCCESS;
+}
+
+template<std::size_t... Ratio>
+constexpr auto make_barometer_configurations(std::index_sequence<Ratio...>)
+{
+  return std::array{ make_configuration<configuration_settings{
+    .mode = mpl3115a2::mode::barometer,
+    .oversampling = static_cast<oversampling_ratio>(Ratio),
+  }>()... };
+}
+
+/// One-shot barometer configuration of every oversampling ratio
+constexpr auto barometer_configurations =
+  make_barometer_configurations(std::make_index_sequence<8>{});
+
+/// Take samples from a simulated bus like firmware would, reporting the
+/// latency from trigger to sample
+int take_samples(const std::string& p_path,
+                 std::size_t p_samples,
+                 unsigned p_ratio)
+{
+  auto result = [&]() -> hal::status {
+    auto bus = HAL_CHECK(socket_i2c::create(p_path));
+    auto device = HAL_CHECK(
+      mpl3115a2::create(bus, barometer_configurations[p_ratio]));
+    auto sleep = [](hal::time_duration p_duration) {
+      std::this_thread::sleep_for(p_duration);
+    };
+    polling::expected_time policy(sleep, std::chrono::milliseconds(1));
+
+    statistics latency;
+    statistics pressure;
+    for (std::size_t i = 0; i < p_samples; i++) {
+      auto start = clock_type::now();
+      HAL_CHECK(device.trigger_conversion(mpl3115a2::mode::barometer));
+      auto sample = HAL_CHECK(read_sample(device, policy));
+      latency.add(
+        std::chrono::duration<double, std::milli>(clock_type::now() - start)
+          .count());
+      pressure.add(static_cast<double>(to_pascals(sample.pressure)));
+    }
+
+    std::printf("samples=%zu pressure_pa=%.2f latency_ms mean=%.3f min=%.3f "
+                "max=%.3f expected=%lld\n",
+                latency.count,
+                pressure.mean,
+                latency.mean,
+                latency.min,
+                latency.max,
+                static_cast<long long>(
+                  barometer_configurations[p_ratio].conversion_time.count()));
+    return hal::success();
+  }();
+
+  if (!result) {
+    std::fprintf(stderr, "%s: simulated bus failed\n", p_path.c_str());
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+void print_usage(const char* p_program)
+{
+  std::fprintf(stderr,
+               "usage: %s command ...\n"
+               "  serve [--clock HZ] PATH...\n"
+               "      simulate one MPL3115A2 on a bus per socket path until "
+               "interrupted\n"
+               "  read [--samples N] [--oversampling 0-7] PATH\n"
+               "      take one-shot samples from a simulated bus and report "
+               "their latency\n",
+               p_program);
+}
+}  // namespace
+
+int main(int p_argc, char** p_argv)
+{
+  if (p_argc < 2) {
+    print_usage(p_argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  std::string_view command(p_argv[1]);
+  hal::hertz clock_rate = 400'000.0f;
+  std::size_t samples = 16;
+  unsigned ratio = 0;
+  std::vector<std::string> paths;
+
+  for (int i = 2; i < p_argc; i++) {
+    std::string_view argument(p_argv[i]);
+    if (argument == "--clock" && i + 1 < p_argc) {
+      clock_rate = std::strtof(p_argv[++i], nullptr);
+    } else if (argument == "--samples" && i + 1 < p_argc) {
+      samples = std::strtoul(p_argv[++i], nullptr, 10);
+    } else if (argument == "--oversampling" && i + 1 < p_argc) {
+      ratio = static_cast<unsigned>(std::strtoul(p_argv[++i], nullptr, 10));
+    } else if (argument.starts_with("--")) {
+      print_usage(p_argv[0]);
+      return EXIT_FAILURE;
+    } else {
+      paths.emplace_back(argument);
+    }
+  }
+
+  if (command == "serve" && !paths.empty() && clock_rate > 0.0f) {
+    return serve(paths, clock_rate);
+  }
+  if (command == "read" && paths.size() == 1 &&
+      ratio < barometer_configurations.size()) {
+    return take_samples(paths[0], samples, ratio);
+  }
+
+  print_usage(p_argv[0]);
+  return EXIT_FAILURE;
+}
@@ -0,0 +1,39 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Framing between `socket_i2c` and the socket simulator
+ *
+ * Every transaction is one request answered by one response, little endian:
+ *
+ *   request:  u8 address | u16 write length | u16 read length | write bytes
+ *   response: u8 status | read bytes, only if the status is 0
+ *
+ * A non-zero status is the `std::errc` value of the failure, e.g. a NACK from
+ * an address with no device is `no_such_device_or_address`. The response is
+ * sent once the modeled bus time of the transaction has passed, so clients
+ * observe bus contention and conversion timing as on hardware.
+ */
+namespace hal::mpl::tools::socket_protocol {
+constexpr std::size_t request_header_size = 5;
+/// Largest write or read of one transaction, enough for a full FIFO burst
+constexpr std::size_t max_transfer = 1024;
+constexpr std::uint8_t status_success = 0;
+}  // namespace hal::mpl::tools::socket_protocol
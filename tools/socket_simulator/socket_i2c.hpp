@@ -0,0 +1,233 @@
+// Copyright 2023 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include <libhal/error.hpp>
+#include <libhal/i2c.hpp>
+#include <libhal/timeout.hpp>
+
+#include "protocol.hpp"
+
+namespace hal::mpl::tools {
+/**
+ * @brief `hal::i2c` whose transactions run on a socket simulator process
+ *
+ * Drivers use it like a hardware bus, so firmware built for the host talks to
+ * a simulated device shared with other processes. The timeout is checked
+ * while waiting for the response. A transaction that fails mid-exchange
+ * drops the connection, which is opened again by the next transaction.
+ */
+class socket_i2c : public hal::i2c
+{
+public:
+  /**
+   * @param p_path - Unix domain socket of the simulated bus
+   * @return hal::result<socket_i2c> - connected bus, or the connection error
+   */
+  [[nodiscard]] static hal::result<socket_i2c> create(std::string_view p_path)
+  {
+    socket_i2c bus{ std::string(p_path) };
+    HAL_CHECK(bus.connect());
+    return bus;
+  }
+
+  socket_i2c(socket_i2c&& p_other) noexcept
+    : m_path(std::move(p_other.m_path))
+    , m_fd(std::exchange(p_other.m_fd, -1))
+  {
+  }
+
+  socket_i2c& operator=(socket_i2c&& p_other) noexcept
+  {
+    if (this != &p_other) {
+      disconnect();
+      m_path = std::move(p_other.m_path);
+      m_fd = std::exchange(p_other.m_fd, -1);
+    }
+    return *this;
+  }
+
+  ~socket_i2c() override
+  {
+    disconnect();
+  }
+
+private:
+  explicit socket_i2c(std::string p_path)
+    : m_path(std::move(p_path))
+  {
+  }
+
+  static hal::status last_error()
+  {
+    return hal::new_error(static_cast<std::errc>(errno));
+  }
+
+  hal::status connect()
+  {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (m_path.size() >= sizeof(address.sun_path)) {
+      return hal::new_error(std::errc::filename_too_long);
+    }
+    std::memcpy(address.sun_path, m_path.c_str(), m_path.size() + 1);
+
+    m_fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (m_fd < 0) {
+      return last_error();
+    }
+    if (::connect(m_fd, reinterpret_cast<sockaddr*>(&address),
+                  sizeof(address)) != 0) {
+      auto error = last_error();
+      disconnect();
+      return error;
+    }
+    return hal::success();
+  }
+
+  void disconnect()
+  {
+    if (m_fd >= 0) {
+      ::close(m_fd);
+      m_fd = -1;
+    }
+  }
+
+  hal::status send(std::span<const hal::byte> p_data)
+  {
+    while (!p_data.empty()) {
+      auto sent = ::send(m_fd, p_data.data(), p_data.size(), MSG_NOSIGNAL);
+      if (sent < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return last_error();
+      }
+      p_data = p_data.subspan(static_cast<std::size_t>(sent));
+    }
+    return hal::success();
+  }
+
+  hal::status receive(std::span<hal::byte> p_data,
+                      hal::function_ref<hal::timeout_function> p_timeout)
+  {
+    while (!p_data.empty()) {
+      pollfd descriptor{ .fd = m_fd, .events = POLLIN, .revents = 0 };
+      // Wake up every millisecond to check the timeout
+      auto ready = ::poll(&descriptor, 1, 1);
+      if (ready < 0 && errno != EINTR) {
+        return last_error();
+      }
+      if (ready <= 0) {
+        HAL_CHECK(p_timeout());
+        continue;
+      }
+
+      auto received = ::recv(m_fd, p_data.data(), p_data.size(), 0);
+      if (received == 0) {
+        return hal::new_error(std::errc::connection_reset);
+      }
+      if (received < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return last_error();
+      }
+      p_data = p_data.subspan(static_cast<std::size_t>(received));
+    }
+    return hal::success();
+  }
+
+  hal::status exchange(hal::byte p_address,
+                       std::span<const hal::byte> p_data_out,
+                       std::span<hal::byte> p_data_in,
+                       hal::function_ref<hal::timeout_function> p_timeout)
+  {
+    if (p_data_out.size() > socket_protocol::max_transfer ||
+        p_data_in.size() > socket_protocol::max_transfer) {
+      return hal::new_error(std::errc::message_size);
+    }
+    if (m_fd < 0) {
+      HAL_CHECK(connect());
+    }
+
+    std::array<hal::byte, socket_protocol::request_header_size> header{
+      p_address,
+      hal::byte(p_data_out.size()),
+      hal::byte(p_data_out.size() >> 8),
+      hal::byte(p_data_in.size()),
+      hal::byte(p_data_in.size() >> 8),
+    };
+    m_in_step = false;
+    HAL_CHECK(send(header));
+    HAL_CHECK(send(p_data_out));
+
+    std::array<hal::byte, 1> status{};
+    HAL_CHECK(receive(status, p_timeout));
+    if (status[0] != socket_protocol::status_success) {
+      // A failure response, e.g. a NACK, carries no read bytes
+      m_in_step = true;
+      return hal::new_error(static_cast<std::errc>(status[0]));
+    }
+    HAL_CHECK(receive(p_data_in, p_timeout));
+    m_in_step = true;
+    return hal::success();
+  }
+
+  hal::status driver_configure(const settings&) override
+  {
+    // The clock rate is a property of the simulated bus
+    return hal::success();
+  }
+
+  hal::result<transaction_t> driver_transaction(
+    hal::byte p_address,
+    std::span<const hal::byte> p_data_out,
+    std::span<hal::byte> p_data_in,
+    hal::function_ref<hal::timeout_function> p_timeout) override
+  {
+    auto outcome = exchange(p_address, p_data_out, p_data_in, p_timeout);
+    if (!outcome) {
+      // A response cut short by a timeout or a transport failure would be
+      // read as the response of the next transaction
+      if (!m_in_step) {
+        disconnect();
+      }
+      return outcome.error();
+    }
+    return transaction_t{};
+  }
+
+  std::string m_path;
+  int m_fd = -1;
+  /// The last exchange consumed its whole response
+  bool m_in_step = true;
+};
+}  // namespace hal::mpl::tools